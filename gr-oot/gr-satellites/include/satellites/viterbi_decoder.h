@@ -19,6 +19,10 @@ namespace satellites {
 
 /*!
  * \brief Viterbi decoder
+ *
+ * Decodes PDUs containing hard bits (u8vector) or soft symbols (f32vector or
+ * s8vector, positive meaning 1) using soft-decision Viterbi decoding.
+ *
  * \ingroup satellites
  *
  */
@@ -14,6 +14,11 @@
 
 #include "distributed_syncframe_soft_impl.h"
 #include <gnuradio/io_signature.h>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace gr {
 namespace satellites {
@@ -40,6 +45,15 @@ distributed_syncframe_soft_impl::distributed_syncframe_soft_impl(
     for (auto s : syncword)
         d_syncword.push_back(s & 1);
 
+    // a tap mismatches when the sign bit equals the syncword bit
+    for (auto s : d_syncword)
+        d_tap_masks.push_back(s ? 0 : ~0ULL);
+
+    size_t nplanes = 1;
+    while ((1ULL << nplanes) <= d_syncword.size())
+        ++nplanes;
+    d_count.resize(nplanes);
+
     set_history(d_syncword.size() * d_step);
 
     message_port_register_out(pmt::mp("out"));
@@ -50,25 +64,106 @@ distributed_syncframe_soft_impl::distributed_syncframe_soft_impl(
  */
 distributed_syncframe_soft_impl::~distributed_syncframe_soft_impl() {}
 
+/*
+ * Packs the sign bits (1 for negative) of n input samples into d_signs,
+ * the first sample at the LSB of the first word
+ */
+void distributed_syncframe_soft_impl::pack_signs(const float* in, size_t n)
+{
+    // one extra word so that unaligned 64-bit reads never go out of bounds
+    const size_t nwords = n / 64 + 2;
+    if (d_signs.size() < nwords)
+        d_signs.resize(nwords);
+
+    size_t i = 0;
+    for (size_t w = 0; w < nwords; ++w) {
+        uint64_t bits = 0;
+#ifdef __SSE2__
+        const __m128 zero = _mm_setzero_ps();
+        for (size_t b = 0; b < 64 && i + 4 <= n; b += 4, i += 4) {
+            const uint64_t m = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(in + i), zero));
+            bits |= m << b;
+        }
+#else
+        for (size_t b = 0; b < 64 && i + 8 <= n; b += 8, i += 8) {
+            uint64_t m = 0;
+            for (size_t k = 0; k < 8; ++k)
+                m |= static_cast<uint64_t>(in[i + k] < 0.0f) << k;
+            bits |= m << b;
+        }
+#endif
+        for (size_t b = i - 64 * w; b < 64 && i < n; ++b, ++i)
+            bits |= static_cast<uint64_t>(in[i] < 0.0f) << b;
+        d_signs[w] = bits;
+    }
+}
+
+/*
+ * Correlates the syncword against the outputs i, i + 1, ..., i + nlanes - 1
+ * at once, one output per bit lane. For each tap, the sign bits of the 64
+ * lanes are read as a single word and added to a bit-sliced counter of
+ * mismatches. Returns the lanes whose number of mismatches does not exceed
+ * the threshold
+ */
+uint64_t distributed_syncframe_soft_impl::correlate(size_t i, size_t nlanes)
+{
+    const size_t nplanes = d_count.size();
+    std::fill(d_count.begin(), d_count.end(), 0);
+
+    size_t pos = i;
+    for (size_t j = 0; j < d_syncword.size(); ++j, pos += d_step) {
+        const size_t w = pos / 64;
+        const size_t off = pos % 64;
+        uint64_t carry = d_signs[w] >> off;
+        if (off)
+            carry |= d_signs[w + 1] << (64 - off);
+        carry ^= d_tap_masks[j];
+        for (size_t k = 0; k < nplanes && carry; ++k) {
+            const uint64_t t = d_count[k] & carry;
+            d_count[k] ^= carry;
+            carry = t;
+        }
+    }
+
+    // lanes where count > threshold, comparing from the MS bit plane
+    uint64_t gt = 0;
+    uint64_t eq = ~0ULL;
+    for (size_t k = nplanes; k-- > 0;) {
+        if ((d_threshold >> k) & 1) {
+            eq &= d_count[k];
+        } else {
+            gt |= eq & d_count[k];
+            eq &= ~d_count[k];
+        }
+    }
+    uint64_t hits = ~gt;
+    // as in the tap by tap comparison against size - threshold, which
+    // underflows when the threshold exceeds the syncword size
+    if (d_threshold > d_syncword.size())
+        hits = 0;
+    if (nlanes < 64)
+        hits &= (1ULL << nlanes) - 1;
+    return hits;
+}
+
 int distributed_syncframe_soft_impl::work(int noutput_items,
                                           gr_vector_const_void_star& input_items,
                                           gr_vector_void_star& output_items)
 {
-    size_t match;
-
     const float* in = (const float*)input_items[0];
 
-    for (int i = 0; i < noutput_items; i++) {
-        match = 0;
-        for (size_t j = 0; j < d_syncword.size(); ++j) {
-            match += (in[i + j * d_step] < 0.0) ^ d_syncword[j];
-        }
-        if (match >= d_syncword.size() - d_threshold) {
+    pack_signs(in, noutput_items + history() - 1);
+
+    for (int i = 0; i < noutput_items; i += 64) {
+        uint64_t hits = correlate(i, std::min(noutput_items - i, 64));
+        while (hits) {
+            const int k = i + __builtin_ctzll(hits);
+            hits &= hits - 1;
             // sync found
             message_port_pub(
                 pmt::mp("out"),
                 pmt::cons(pmt::PMT_NIL,
-                          pmt::init_f32vector(d_syncword.size() * d_step, in + i)));
+                          pmt::init_f32vector(d_syncword.size() * d_step, in + k)));
         }
     }
 
@@ -24,6 +24,15 @@ private:
     const size_t d_threshold;
     const size_t d_step;
     std::vector<uint8_t> d_syncword;
+    // XOR masks that turn the sign bits into mismatch bits, one per tap
+    std::vector<uint64_t> d_tap_masks;
+    // sign bits of the current input block, packed in 64-bit words
+    std::vector<uint64_t> d_signs;
+    // bit-sliced mismatch counters, one bit plane per word
+    std::vector<uint64_t> d_count;
+
+    void pack_signs(const float* in, size_t n);
+    uint64_t correlate(size_t i, size_t nlanes);
 
 public:
     distributed_syncframe_soft_impl(int threshold, const std::string& syncword, int step);
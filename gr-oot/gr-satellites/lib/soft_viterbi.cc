@@ -0,0 +1,207 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2021 Daniel Estevez <daniel@destevez.net>
+ *
+ * This file is part of gr-satellites
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#include "soft_viterbi.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace gr {
+namespace satellites {
+
+namespace {
+
+// Metric of the states that are not reachable at the start of the frame.
+// It is large enough to never win and small enough to never overflow
+const int32_t unreachable_metric = 1 << 24;
+
+int parity(unsigned int x) { return __builtin_parity(x); }
+
+unsigned int reverse_bits(int num_bits, unsigned int input)
+{
+    unsigned int output = 0;
+    while (num_bits-- > 0) {
+        output = (output << 1) | (input & 1);
+        input >>= 1;
+    }
+    return output;
+}
+
+} // namespace
+
+soft_viterbi::soft_viterbi(int constraint, const std::vector<int>& polynomials)
+    : d_constraint(constraint),
+      d_rate(polynomials.size()),
+      d_nstates(constraint >= 2 ? 1U << (constraint - 1) : 0)
+{
+    if (constraint < 2 || constraint > 24) {
+        throw std::invalid_argument("soft_viterbi: unsupported constraint length");
+    }
+    if (polynomials.empty()) {
+        throw std::invalid_argument("soft_viterbi: no polynomials given");
+    }
+    for (auto p : polynomials) {
+        if (p <= 0 || p >= (1 << constraint)) {
+            throw std::invalid_argument("soft_viterbi: invalid polynomial");
+        }
+    }
+
+    const size_t half = d_nstates / 2;
+    d_sign_even0.resize(d_rate * half);
+    d_sign_odd0.resize(d_rate * half);
+    d_sign_even1.resize(d_rate * half);
+    d_sign_odd1.resize(d_rate * half);
+    d_bm_even0.resize(half);
+    d_bm_odd0.resize(half);
+    d_bm_even1.resize(half);
+    d_bm_odd1.resize(half);
+    d_metrics.resize(d_nstates);
+    d_new_metrics.resize(d_nstates);
+    d_tail.resize(d_rate);
+
+    // The encoder register holds the source state at the LSBs and the input
+    // bit at the MSB, as in ViterbiCodec::Output()
+    for (int j = 0; j < d_rate; ++j) {
+        const unsigned int poly = reverse_bits(d_constraint, polynomials[j]);
+        for (size_t u = 0; u < half; ++u) {
+            const unsigned int in1 = 1U << (d_constraint - 1);
+            const size_t k = j * half + u;
+            d_sign_even0[k] = parity(poly & (2 * u)) ? -1 : 1;
+            d_sign_odd0[k] = parity(poly & (2 * u + 1)) ? -1 : 1;
+            d_sign_even1[k] = parity(poly & (in1 | (2 * u))) ? -1 : 1;
+            d_sign_odd1[k] = parity(poly & (in1 | (2 * u + 1))) ? -1 : 1;
+        }
+    }
+}
+
+/*
+ * The kernels below are branch free loops over contiguous arrays, so that the
+ * compiler vectorizes them
+ */
+static void accumulate_metrics(int32_t* __restrict bm,
+                               const int32_t* __restrict signs,
+                               int32_t symbol,
+                               size_t n)
+{
+    for (size_t u = 0; u < n; ++u) {
+        bm[u] += signs[u] * symbol;
+    }
+}
+
+/*
+ * Add-compare-select for the target states that share the same input bit.
+ * The target state u is reached from the source states 2u and 2u + 1. On
+ * ties the even source state is kept, as in ViterbiCodec
+ */
+static void add_compare_select_half(const int32_t* __restrict pm,
+                                    const int32_t* __restrict bm_even,
+                                    const int32_t* __restrict bm_odd,
+                                    int32_t* __restrict npm,
+                                    uint8_t* __restrict decisions,
+                                    size_t n)
+{
+    for (size_t u = 0; u < n; ++u) {
+        const int32_t m0 = pm[2 * u] + bm_even[u];
+        const int32_t m1 = pm[2 * u + 1] + bm_odd[u];
+        decisions[u] = m1 < m0;
+        npm[u] = std::min(m0, m1);
+    }
+}
+
+/*
+ * Computes the branch metrics of a trellis step. The metric of a branch is
+ * the sum of the soft symbols, negated where the branch expects a 1, so
+ * lower is better
+ */
+void soft_viterbi::branch_metrics(const int8_t* symbols)
+{
+    const size_t half = d_nstates / 2;
+    std::fill(d_bm_even0.begin(), d_bm_even0.end(), 0);
+    std::fill(d_bm_odd0.begin(), d_bm_odd0.end(), 0);
+    std::fill(d_bm_even1.begin(), d_bm_even1.end(), 0);
+    std::fill(d_bm_odd1.begin(), d_bm_odd1.end(), 0);
+    for (int j = 0; j < d_rate; ++j) {
+        const int32_t s = symbols[j];
+        accumulate_metrics(d_bm_even0.data(), &d_sign_even0[j * half], s, half);
+        accumulate_metrics(d_bm_odd0.data(), &d_sign_odd0[j * half], s, half);
+        accumulate_metrics(d_bm_even1.data(), &d_sign_even1[j * half], s, half);
+        accumulate_metrics(d_bm_odd1.data(), &d_sign_odd1[j * half], s, half);
+    }
+}
+
+/*
+ * Butterfly add-compare-select. The target states u and u + half share the
+ * source states 2u and 2u + 1
+ */
+void soft_viterbi::add_compare_select(uint8_t* decisions)
+{
+    const size_t half = d_nstates / 2;
+    int32_t* npm = d_new_metrics.data();
+    add_compare_select_half(
+        d_metrics.data(), d_bm_even0.data(), d_bm_odd0.data(), npm, decisions, half);
+    add_compare_select_half(d_metrics.data(),
+                            d_bm_even1.data(),
+                            d_bm_odd1.data(),
+                            npm + half,
+                            decisions + half,
+                            half);
+
+    // Renormalize, so that the metrics never overflow
+    int32_t min = npm[0];
+    for (size_t t = 1; t < d_nstates; ++t) {
+        min = std::min(min, npm[t]);
+    }
+    for (size_t t = 0; t < d_nstates; ++t) {
+        npm[t] -= min;
+    }
+    d_metrics.swap(d_new_metrics);
+}
+
+void soft_viterbi::decode(const int8_t* symbols,
+                          size_t nsymbols,
+                          std::vector<uint8_t>& out)
+{
+    const size_t nsteps = (nsymbols + d_rate - 1) / d_rate;
+    if (d_decisions.size() < nsteps * d_nstates) {
+        d_decisions.resize(nsteps * d_nstates);
+    }
+
+    std::fill(d_metrics.begin(), d_metrics.end(), unreachable_metric);
+    d_metrics[0] = 0;
+
+    for (size_t i = 0; i < nsteps; ++i) {
+        const int8_t* s = &symbols[i * d_rate];
+        if ((i + 1) * d_rate > nsymbols) {
+            // Missing symbols at the end of the frame are erasures
+            std::fill(d_tail.begin(), d_tail.end(), 0);
+            std::copy(s, symbols + nsymbols, d_tail.begin());
+            s = d_tail.data();
+        }
+        branch_metrics(s);
+        add_compare_select(&d_decisions[i * d_nstates]);
+    }
+
+    // Traceback from the best state
+    size_t state =
+        std::min_element(d_metrics.begin(), d_metrics.end()) - d_metrics.begin();
+    const size_t nflush = d_constraint - 1;
+    const size_t nout = nsteps > nflush ? nsteps - nflush : 0;
+    out.resize(nout);
+    for (size_t i = nsteps; i-- > 0;) {
+        const uint8_t bit = state >> (d_constraint - 2);
+        if (i < nout) {
+            out[i] = bit;
+        }
+        state = ((state << 1) & (d_nstates - 1)) | d_decisions[i * d_nstates + state];
+    }
+}
+
+} // namespace satellites
+} // namespace gr
@@ -0,0 +1,79 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2021 Daniel Estevez <daniel@destevez.net>
+ *
+ * This file is part of gr-satellites
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+#ifndef INCLUDED_SATELLITES_SOFT_VITERBI_H
+#define INCLUDED_SATELLITES_SOFT_VITERBI_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gr {
+namespace satellites {
+
+/*!
+ * \brief Soft-decision Viterbi decoder for arbitrary convolutional codes
+ *
+ * The code is given by its constraint length and a set of polynomials, using
+ * the same lsb-current convention as ViterbiCodec. The input symbols are
+ * int8_t soft bits, where positive values mean 1 and 0 is an erasure.
+ *
+ * All the buffers, including the decisions of the trellis, are kept between
+ * calls and only grow when a longer frame is decoded.
+ */
+class soft_viterbi
+{
+public:
+    soft_viterbi(int constraint, const std::vector<int>& polynomials);
+
+    int constraint() const { return d_constraint; }
+    int rate() const { return d_rate; }
+
+    /*!
+     * \brief Decodes a frame, including the constraint - 1 flushing bits
+     *
+     * \param symbols soft symbols. If the number of symbols is not a multiple
+     *        of the number of polynomials, the missing symbols are treated
+     *        as erasures.
+     * \param nsymbols number of soft symbols
+     * \param out decoded bits, one per byte, without the flushing bits
+     */
+    void decode(const int8_t* symbols, size_t nsymbols, std::vector<uint8_t>& out);
+
+private:
+    const int d_constraint;
+    const int d_rate;
+    const size_t d_nstates;
+    // For each source state pair 2u, 2u + 1 and each input bit, the sign
+    // (+1 for an expected 0, -1 for an expected 1) of every encoder output,
+    // stored as d_rate arrays of d_nstates / 2 elements
+    std::vector<int32_t> d_sign_even0;
+    std::vector<int32_t> d_sign_odd0;
+    std::vector<int32_t> d_sign_even1;
+    std::vector<int32_t> d_sign_odd1;
+    std::vector<int32_t> d_bm_even0;
+    std::vector<int32_t> d_bm_odd0;
+    std::vector<int32_t> d_bm_even1;
+    std::vector<int32_t> d_bm_odd1;
+    std::vector<int32_t> d_metrics;
+    std::vector<int32_t> d_new_metrics;
+    // symbols of an incomplete last trellis step
+    std::vector<int8_t> d_tail;
+    // one decision per state and trellis step
+    std::vector<uint8_t> d_decisions;
+
+    void branch_metrics(const int8_t* symbols);
+    void add_compare_select(uint8_t* decisions);
+};
+
+} // namespace satellites
+} // namespace gr
+
+#endif /* INCLUDED_SATELLITES_SOFT_VITERBI_H */
@@ -15,7 +15,8 @@
 #include "viterbi_decoder_impl.h"
 #include <gnuradio/io_signature.h>
 
-#include <string>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace gr {
@@ -35,7 +36,7 @@ viterbi_decoder_impl::viterbi_decoder_impl(int constraint,
     : gr::block("viterbi_decoder",
                 gr::io_signature::make(0, 0, 0),
                 gr::io_signature::make(0, 0, 0)),
-      d_codec(constraint, polynomials)
+      d_viterbi(constraint, polynomials)
 {
     message_port_register_out(pmt::mp("out"));
     message_port_register_in(pmt::mp("in"));
@@ -58,20 +59,43 @@ int viterbi_decoder_impl::general_work(int noutput_items,
 
 void viterbi_decoder_impl::msg_handler(pmt::pmt_t pmt_msg)
 {
-    std::vector<uint8_t> msg = pmt::u8vector_elements(pmt::cdr(pmt_msg));
-    std::string bits;
-    for (auto b : msg) {
-        bits.push_back(b ? '1' : '0');
-    }
+    pmt::pmt_t msg = pmt::cdr(pmt_msg);
+    size_t len = 0;
 
-    std::string outbits = d_codec.Decode(bits);
-    std::vector<uint8_t> out;
-    for (auto b : outbits) {
-        out.push_back(b == '1');
+    if (pmt::is_u8vector(msg)) {
+        // hard bits
+        const uint8_t* bits = pmt::u8vector_elements(msg, len);
+        d_symbols.resize(len);
+        for (size_t i = 0; i < len; ++i) {
+            d_symbols[i] = bits[i] ? 1 : -1;
+        }
+    } else if (pmt::is_s8vector(msg)) {
+        // 8-bit soft symbols
+        const int8_t* symbols = pmt::s8vector_elements(msg, len);
+        d_symbols.assign(symbols, symbols + len);
+    } else if (pmt::is_f32vector(msg)) {
+        // soft symbols, quantized so that their mean amplitude maps to 32
+        const float* symbols = pmt::f32vector_elements(msg, len);
+        float amplitude = 0.0f;
+        for (size_t i = 0; i < len; ++i) {
+            amplitude += std::fabs(symbols[i]);
+        }
+        const float scale = amplitude > 0.0f ? 32.0f * len / amplitude : 0.0f;
+        d_symbols.resize(len);
+        for (size_t i = 0; i < len; ++i) {
+            const float x = std::round(symbols[i] * scale);
+            d_symbols[i] = static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, x)));
+        }
+    } else {
+        GR_LOG_WARN(d_logger, "Invalid PDU type for the Viterbi decoder");
+        return;
     }
 
-    message_port_pub(pmt::mp("out"),
-                     pmt::cons(pmt::car(pmt_msg), pmt::init_u8vector(out.size(), out)));
+    d_viterbi.decode(d_symbols.data(), len, d_out);
+
+    message_port_pub(
+        pmt::mp("out"),
+        pmt::cons(pmt::car(pmt_msg), pmt::init_u8vector(d_out.size(), d_out)));
 
     return;
 }
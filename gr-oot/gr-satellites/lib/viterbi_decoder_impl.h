@@ -11,7 +11,7 @@
 #ifndef INCLUDED_SATELLITES_VITERBI_DECODER_IMPL_H
 #define INCLUDED_SATELLITES_VITERBI_DECODER_IMPL_H
 
-#include "viterbi/viterbi.h"
+#include "soft_viterbi.h"
 
 #include <satellites/viterbi_decoder.h>
 
@@ -21,7 +21,9 @@ namespace satellites {
 class viterbi_decoder_impl : public viterbi_decoder
 {
 private:
-    ViterbiCodec d_codec;
+    soft_viterbi d_viterbi;
+    std::vector<int8_t> d_symbols;
+    std::vector<uint8_t> d_out;
 
 public:
     viterbi_decoder_impl(int constraint, const std::vector<int>& polynomials);
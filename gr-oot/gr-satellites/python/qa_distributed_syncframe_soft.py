@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# Copyright 2021 Daniel Estevez <daniel@destevez.net>
+#
+# This file is part of gr-satellites
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+
+from gnuradio import gr, blocks, gr_unittest
+import numpy as np
+import pmt
+
+# bootstrap satellites module, even from build dir
+try:
+    import python as satellites
+except ImportError:
+    pass
+else:
+    import sys
+    sys.modules['satellites'] = satellites
+
+from satellites import distributed_syncframe_soft
+
+
+class qa_distributed_syncframe_soft(gr_unittest.TestCase):
+    def run_syncframe(self, threshold, syncword, step):
+        """Runs the block and a tap by tap reference over random input"""
+        size = 5000
+        sync = np.array([int(s) for s in syncword])
+        taps = np.arange(sync.size) * step
+        data = np.random.randn(size).astype('float32')
+        for start in np.random.randint(0, size - taps[-1], 10):
+            data[start + taps] = np.where(sync == 1, 1.0, -1.0)
+
+        tb = gr.top_block()
+        source = blocks.vector_source_f(data, False, 1, [])
+        sync_block = distributed_syncframe_soft(threshold, syncword, step)
+        dbg = blocks.message_debug()
+        tb.connect(source, sync_block)
+        tb.msg_connect((sync_block, 'out'), (dbg, 'store'))
+        tb.start()
+        tb.wait()
+
+        expected = [i for i in range(size - taps[-1] - step + 1)
+                    if np.sum((data[i + taps] < 0) ^ sync)
+                    >= sync.size - threshold]
+        self.assertEqual(
+            dbg.num_messages(), len(expected),
+            'Incorrect number of syncwords detected')
+        for n, i in enumerate(expected):
+            out = pmt.f32vector_elements(pmt.cdr(dbg.get_message(n)))
+            np.testing.assert_equal(
+                out, data[i:i + sync.size * step],
+                'Syncframe output does not match expected result')
+
+    def test_short_syncword(self):
+        self.run_syncframe(2, '10110111', 3)
+
+    def test_long_syncword(self):
+        syncword = ''.join(str(b) for b in np.random.randint(0, 2, 100))
+        self.run_syncframe(10, syncword, 5)
+
+
+if __name__ == '__main__':
+    gr_unittest.run(qa_distributed_syncframe_soft)
@@ -51,6 +51,35 @@ class qa_viterbi(gr_unittest.TestCase):
             bytes(out), bytes(data),
             'Encoded and decoded message does not match original')
 
+    def test_viterbi_soft(self):
+        tb = gr.top_block()
+        dbg = blocks.message_debug()
+        k = 7
+        p = [79, 109]
+        dec = viterbi_decoder(k, p)
+        data = np.random.randint(2, size=1000, dtype='uint8')
+        # polynomial bit m corresponds to the input delayed by m
+        encoded = np.array(
+            [np.convolve(data, [(q >> m) & 1 for m in range(k)]) & 1
+             for q in p]).T.ravel()
+        symbols = 2.0 * encoded - 1 + 0.5 * np.random.randn(encoded.size)
+        pdu = pmt.cons(pmt.PMT_NIL,
+                       pmt.init_f32vector(symbols.size, list(symbols)))
+
+        tb.msg_connect((dec, 'out'), (dbg, 'store'))
+        dec.to_basic_block()._post(pmt.intern('in'), pdu)
+        dec.to_basic_block()._post(
+            pmt.intern('system'),
+            pmt.cons(pmt.intern('done'), pmt.from_long(1)))
+
+        tb.start()
+        tb.wait()
+
+        out = pmt.u8vector_elements(pmt.cdr(dbg.get_message(0)))
+        self.assertEqual(
+            bytes(out), bytes(data),
+            'Soft decoded message does not match original')
+
 
 if __name__ == '__main__':
     gr_unittest.run(qa_viterbi)
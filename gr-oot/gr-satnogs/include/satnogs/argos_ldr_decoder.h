@@ -23,8 +23,7 @@
 
 #include <satnogs/api.h>
 #include <satnogs/decoder.h>
-
-#include <deque>
+#include <satnogs/bitstream.h>
 
 namespace gr {
 namespace satnogs {
@@ -83,7 +82,7 @@ private:
   size_t d_received_bytes;
   size_t d_decoded_bits;
   uint8_t *d_frame_buffer;
-  std::deque<uint8_t> d_bitstream;
+  bitstream d_bitstream;
   size_t d_start_idx;
   uint64_t d_frame_start;
   uint64_t d_sample_cnt;
@@ -100,6 +99,9 @@ private:
   bool
   _decode(decoder_status_t &status);
 
+  void
+  drop_bitstream();
+
   inline void
   decode_1b(uint8_t in);
   bool
@@ -23,9 +23,7 @@
 
 #include <satnogs/api.h>
 #include <satnogs/decoder.h>
-#include <gnuradio/digital/lfsr.h>
-
-#include <deque>
+#include <satnogs/bitstream.h>
 
 namespace gr {
 namespace satnogs {
@@ -72,7 +70,11 @@ public:
    * @param descramble if set to yes, the data will be descrambled prior
    * decoding using the G3RUH self-synchronizing descrambler.
    * @param max_frame_len the maximum allowed frame length
-   * @param error_correction set to true to enable the 1-bit error correction
+   * @param error_correction set to true to enable the FCS based error
+   * correction
+   * @param max_error_bits the maximum number of erroneous bits (1 or 2) that
+   * the error correction will try to correct. Note that correcting 2 bits
+   * increases the chance of accepting a wrong frame
    *
    * @return a shared pointer of the decoder instance
    */
@@ -80,7 +82,8 @@ public:
   make(const std::string &addr, uint8_t ssid, bool promisc = false,
        bool descramble = true, bool crc_check = true,
        size_t max_frame_len = 512,
-       bool error_correction = false);
+       bool error_correction = false,
+       size_t max_error_bits = 1);
 
   /**
    * The decoder take as input a quadrature demodulated bit stream.
@@ -102,12 +105,17 @@ public:
    * decoding using the G3RUH self-synchronizing descrambler.
    * @param crc_check bypass the CRC check of the frame
    * @param max_frame_len the maximum allowed frame length
-   * @param error_correction set to true to enable the 1-bit error correction
+   * @param error_correction set to true to enable the FCS based error
+   * correction
+   * @param max_error_bits the maximum number of erroneous bits (1 or 2) that
+   * the error correction will try to correct. Note that correcting 2 bits
+   * increases the chance of accepting a wrong frame
    */
   ax25_decoder(const std::string &addr, uint8_t ssid, bool promisc = false,
                bool descramble = true, bool crc_check = true,
                size_t max_frame_len = 512,
-               bool error_correction = false);
+               bool error_correction = false,
+               size_t max_error_bits = 1);
 
   ~ax25_decoder();
 
@@ -131,15 +139,16 @@ private:
   const bool d_crc_check;
   const size_t d_max_frame_len;
   const bool d_error_correction;
+  const size_t d_max_error_bits;
   decoding_state_t d_state;
   uint8_t d_shift_reg;
   uint8_t d_dec_b;
   uint8_t d_prev_bit_nrzi;
   size_t d_received_bytes;
   size_t d_decoded_bits;
-  digital::lfsr d_lfsr;
+  uint64_t d_descrambler_reg;
   uint8_t *d_frame_buffer;
-  std::deque<uint8_t> d_bitstream;
+  bitstream d_bitstream;
   size_t d_start_idx;
   uint64_t d_frame_start;
   uint64_t d_sample_cnt;
@@ -156,10 +165,27 @@ private:
   bool
   _decode(decoder_status_t &status);
 
+  void
+  drop_bitstream();
+
   inline void
   decode_1b(uint8_t in);
+
+  inline void
+  decode_nb(uint64_t in, size_t nbits);
+
+  bool
+  decode_data_bits(uint64_t in, size_t nbits);
+
+  uint64_t
+  nrzi_descramble(uint64_t in, size_t nbits);
+
+  uint16_t
+  fcs_syndrome();
   bool
   is_frame_valid();
+  void
+  flip_bit(size_t pos);
   bool
   error_correction();
 };
@@ -0,0 +1,184 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_SATNOGS_BITSTREAM_H
+#define INCLUDED_SATNOGS_BITSTREAM_H
+
+#include <satnogs/api.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Fixed capacity, bit-packed circular buffer of bits
+ *
+ * Bits are stored packed in 64-bit words. Bits can be appended at the back
+ * and consumed from the front in O(1), without any memory allocation after
+ * construction. Index 0 always refers to the oldest bit in the buffer.
+ *
+ * The get() method returns up to 64 consecutive bits at once, with the
+ * oldest bit at the LS position. This is the natural order for the HDLC based
+ * protocols, where the LS bit of each byte is transmitted first.
+ */
+class SATNOGS_API bitstream {
+public:
+  bitstream(size_t capacity);
+  ~bitstream();
+
+  size_t
+  capacity() const;
+
+  size_t
+  size() const;
+
+  size_t
+  space() const;
+
+  bool
+  empty() const;
+
+  bool
+  full() const;
+
+  void
+  clear();
+
+  void
+  consume(size_t nbits);
+
+  size_t
+  push_back(const uint8_t *in, size_t len);
+
+  /**
+   * Appends a bit at the back of the buffer. The caller should ensure that
+   * there is available space.
+   * @param bit the bit to append. Only the LS bit is used
+   */
+  void
+  push_back(uint8_t bit)
+  {
+    const size_t pos = (d_head + d_size) & d_mask;
+    const uint64_t m = 1ULL << (pos & 63);
+    d_words[pos >> 6] = (d_words[pos >> 6] & ~m) | ((uint64_t)(bit & 0x1) <<
+                        (pos & 63));
+    d_size++;
+  }
+
+  /**
+   * Appends up to 64 packed bits at the back of the buffer. The caller should
+   * ensure that there is available space.
+   * @param bits the bits to append. The LS bit is appended first
+   * @param nbits the number of bits to append (1 to 64)
+   */
+  void
+  push_back_bits(uint64_t bits, size_t nbits)
+  {
+    const size_t pos = (d_head + d_size) & d_mask;
+    const size_t off = pos & 63;
+    const size_t w = pos >> 6;
+    const uint64_t m = nbits < 64 ? (1ULL << nbits) - 1 : ~0ULL;
+    bits &= m;
+    d_words[w] = (d_words[w] & ~(m << off)) | (bits << off);
+    if (off + nbits > 64) {
+      const size_t n = (w + 1) & d_word_mask;
+      const uint64_t m2 = (1ULL << (off + nbits - 64)) - 1;
+      d_words[n] = (d_words[n] & ~m2) | (bits >> (64 - off));
+    }
+    d_size += nbits;
+  }
+
+  /**
+   * @param idx the index of the bit, starting from the oldest one
+   * @return the bit at position idx
+   */
+  uint8_t
+  operator[](size_t idx) const
+  {
+    const size_t pos = (d_head + idx) & d_mask;
+    return (d_words[pos >> 6] >> (pos & 63)) & 0x1;
+  }
+
+  /**
+   * Retrieves up to 64 bits at once. The bit at position idx is placed at the
+   * LS bit of the result. The caller should ensure that idx + nbits does not
+   * exceed size()
+   * @param idx the index of the first bit
+   * @param nbits the number of bits to retrieve (1 to 64)
+   * @return the requested bits
+   */
+  uint64_t
+  get(size_t idx, size_t nbits) const
+  {
+    const size_t pos = (d_head + idx) & d_mask;
+    const size_t off = pos & 63;
+    uint64_t w = d_words[pos >> 6] >> off;
+    if (off + nbits > 64) {
+      w |= d_words[((pos >> 6) + 1) & d_word_mask] << (64 - off);
+    }
+    if (nbits < 64) {
+      w &= (1ULL << nbits) - 1;
+    }
+    return w;
+  }
+
+  /**
+   * Packs unpacked bits into a single word
+   * @param in unpacked bits. Each byte should contain one bit at the LS
+   * position
+   * @param nbits the number of bits to pack (0 to 64)
+   * @return the packed bits. The first bit is placed at the LS position
+   */
+  static uint64_t
+  pack(const uint8_t *in, size_t nbits)
+  {
+    uint64_t w = 0;
+    size_t i = 0;
+    for (; i + 8 <= nbits; i += 8) {
+      uint64_t x;
+      std::memcpy(&x, in + i, sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      x = __builtin_bswap64(x);
+#endif
+      /* Gather the LS bit of each byte at the MS byte of the product */
+      w |= (((x & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56) << i;
+    }
+    for (; i < nbits; i++) {
+      w |= (uint64_t)(in[i] & 0x1) << i;
+    }
+    return w;
+  }
+
+private:
+  const size_t          d_capacity;
+  const size_t          d_mask;
+  const size_t          d_word_mask;
+  std::vector<uint64_t> d_words;
+  size_t                d_head;
+  size_t                d_size;
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_BITSTREAM_H */
@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_CHIRP_ROTATOR_H
+#define INCLUDED_SATNOGS_CHIRP_ROTATOR_H
+
+#include <satnogs/api.h>
+#include <gnuradio/gr_complex.h>
+#include <cstddef>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Continuous phase rotator with a polynomial frequency
+ *
+ * Multiplies a complex stream with exp(j phi(t)), where the instantaneous
+ * frequency dphi/dt is given as a polynomial of the sample index. The
+ * phase is kept across calls, so successive buffers, or a change of the
+ * frequency polynomial, never introduce phase discontinuities.
+ *
+ * The samples are processed in blocks. In each block the phase is
+ * approximated by a cubic polynomial, which is advanced with multiplicative
+ * forward differences on a number of parallel lanes. The phase at the start
+ * of each block is kept in double precision, so the single precision
+ * rotator never accumulates errors beyond a block.
+ */
+class SATNOGS_API chirp_rotator {
+public:
+  /*!
+   * The maximum number of the frequency polynomial coefficients
+   */
+  static const size_t max_coeffs = 4;
+
+  chirp_rotator();
+
+  void
+  reset(double phase = 0.0);
+
+  double
+  phase() const;
+
+  void
+  rotate(gr_complex *out, const gr_complex *in, size_t len,
+         const double *freq, size_t ncoeffs);
+
+  static void
+  shift_polynomial(double *coeffs, size_t ncoeffs, double x0);
+
+private:
+  static const size_t lanes = 8;
+  static const size_t block_len = 512;
+
+  double d_phase;
+  /* Per lane rotator and its forward differences, real and imaginary parts */
+  float d_r[2][lanes];
+  float d_w[2][lanes];
+  float d_v[2][lanes];
+  float d_u[2];
+
+  void
+  setup_lanes(const double *phase_coeffs);
+
+  void
+  rotate_block(gr_complex *out, const gr_complex *in, size_t len);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_CHIRP_ROTATOR_H */
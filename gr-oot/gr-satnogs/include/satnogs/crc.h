@@ -69,11 +69,6 @@ public:
 
   static bool
   check(crc_t t, const uint8_t *data, size_t len, bool nbo = true);
-
-private:
-  static const uint16_t crc16_ccitt_table_reverse[256];
-  static const uint16_t crc16_ccitt_table[256];
-  static const uint32_t crc32_c_table[256];
 };
 
 } // namespace satnogs
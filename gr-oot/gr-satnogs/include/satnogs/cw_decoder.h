@@ -28,7 +28,6 @@
 #include <gnuradio/fft/fft.h>
 #include <cstdlib>
 #include <vector>
-#include <deque>
 
 
 
@@ -90,13 +89,15 @@ private:
   int                           d_dirty_samples;
   std::vector<cw_decoder_priv *>d_decoders;
   gr::fft::fft_complex          *d_fft;
-  gr_complex                    *d_tmp_buf;
+  gr_complex                    *d_hist;
   float                         *d_nf_buf;
   float                         *d_psd;
-  std::deque<decoder_status_t>  d_frames;
 
   void
-  process_psd();
+  fill_window(const gr_complex *input, int start);
+
+  void
+  process_psd(decoder_status_t &status);
 
   void
   process_windows();
@@ -24,6 +24,7 @@
 #include <satnogs/api.h>
 #include <cstdint>
 #include <cstdlib>
+#include <vector>
 #include <pmt/pmt.h>
 
 namespace gr {
@@ -35,6 +36,11 @@ namespace satnogs {
  * This class contains all the necessary information that the
  * \ref decoder::decode() method returns and used by the frame_decoder()
  * to properly inform the GNU Radio scheduler and/or propagate decoded frames
+ *
+ * A single call of the \ref decoder::decode() may produce several frames.
+ * Decoders fill the data field for each frame and then call next_frame(),
+ * which moves it to the frames vector, before continuing with the rest of
+ * the input.
  */
 class decoder_status {
 public:
@@ -42,13 +48,34 @@ public:
   bool
   decode_success; /**< Indicated if there was a successful decoding */
   pmt::pmt_t
-  data;           /**< a dictionary with the PDU with of decoded data and the corresponding metadata for the decoded frame */
+  data;           /**< a dictionary with the PDU with of decoded data and the corresponding metadata for the decoded frame. It is valid only if decode_success is set */
+  std::vector<pmt::pmt_t>
+  frames;         /**< the frames decoded before the one at data, in the order they were decoded */
 
+  /**
+   * The idle status. The metadata dictionary is not created here, but by
+   * the first metadata::add call of the decoder, so calls that do not
+   * produce a frame perform no allocation
+   */
   decoder_status() :
     consumed(0),
     decode_success(false),
-    data(pmt::make_dict())
+    data()
+  {
+  }
+
+  /**
+   * If a frame was decoded, it is moved to the frames vector and
+   * the status is prepared for the next frame
+   */
+  void
+  next_frame()
   {
+    if (decode_success) {
+      frames.push_back(data);
+      data = pmt::pmt_t();
+      decode_success = false;
+    }
   }
 };
 
@@ -87,7 +114,9 @@ public:
    *
    * As the number of input items may not enough to decode a frame, each decoder
    * should keep internal state, so decoding can be accomplished after an
-   * arbitrary number of calls to this method
+   * arbitrary number of calls to this method. On the other hand, all the
+   * frames that can be decoded from the input should be reported by a
+   * single call, using decoder_status::next_frame()
    *
    * @param in the input items
    *
@@ -45,18 +45,25 @@ public:
    * The doppler correction block. The input is the complex signal at
    * baseband as it comes from the SDR device. The message input \p freq
    * received periodically messages containing the predicted absolute
-   * frequency of the satellite at that specific time.
+   * frequency of the satellite at that specific time. A message can also be
+   * a pair of the sample index and the frequency at that sample, as
+   * produced by the sgp4_doppler_msg_source block. Any message on the
+   * \p reset input discards the predictions received so far, so a new
+   * pass does not reuse the fit of the previous one.
    * @param target_freq the absolute frequency of the satellite
    * @param offset the frequency offset from the actual target frequency.
    * This is very common on SDR receivers to avoid DC spikes at the center
    * frequency. This block can automatically compensate this offset
    * @param sampling_rate the sampling rate of the signal
    * @param corrections_per_sec the number of the corrections every second
-   * that the block should perform
+   * that the block should perform. It is not used in chirp mode
+   * @param chirp if set to true, the fitted Doppler curve is applied as a
+   * continuous phase chirp, evaluated at every sample. Otherwise the
+   * frequency is kept constant between successive corrections
    */
   static sptr
   make(double target_freq, double offset, double sampling_rate,
-       size_t corrections_per_sec = 1000);
+       size_t corrections_per_sec = 1000, bool chirp = false);
 };
 
 } // namespace satnogs
@@ -41,7 +41,19 @@ public:
 
   void
   predict_freqs(double *freqs, size_t ncorrections,
-                size_t samples_per_correction);
+                size_t samples_per_correction, uint64_t origin);
+
+  bool
+  polynomial(double *coeffs, uint64_t origin);
+
+  uint64_t
+  horizon();
+
+  void
+  reset();
+
+  size_t
+  degree() const;
 
 private:
   const size_t                            d_degree;
@@ -49,8 +61,8 @@ private:
   std::deque<std::pair<uint64_t, double>> d_data;
   std::mutex                              d_mtx;
 
-  double
-  L(uint64_t x);
+  void
+  coefficients(double *coeffs, uint64_t origin) const;
 };
 
 } // namespace satnogs
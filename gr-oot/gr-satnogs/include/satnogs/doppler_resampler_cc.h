@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_DOPPLER_RESAMPLER_CC_H
+#define INCLUDED_SATNOGS_DOPPLER_RESAMPLER_CC_H
+
+#include <satnogs/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Doppler compensation, decimation and resampling in a single block
+ *
+ * This block performs the same processing as the doppler_compensation
+ * hierarchical block, in a single pass over the input samples. The
+ * frequency translation is folded into the decimating low pass filter, by
+ * rotating its taps with the current frequency instead of rotating every
+ * input sample. The remaining phase is applied at the decimated rate, as a
+ * continuous phase chirp that follows the fitted Doppler curve. A polyphase
+ * arbitrary resampler then produces the requested output sampling rate.
+ *
+ * \ingroup satnogs
+ *
+ */
+class SATNOGS_API doppler_resampler_cc : virtual public gr::block {
+public:
+  typedef boost::shared_ptr<doppler_resampler_cc> sptr;
+
+  /**
+   * The message input \p doppler receives the predicted absolute frequency
+   * of the satellite, either as a plain number that applies to the current
+   * sample, or as a pair of the sample index and the frequency.
+   *
+   * @param samp_rate the sampling rate of the input signal
+   * @param sat_freq the absolute frequency of the satellite
+   * @param lo_offset the LO offset from the actual observation frequency.
+   * It is positive if the hardware RF frequency is less than the target
+   * frequency. The offset is compensated even if \p compensate is false
+   * @param out_samp_rate the sampling rate of the output signal. It should
+   * be less or equal to \p samp_rate
+   * @param compensate if set to false, the Doppler messages are ignored and
+   * only the LO offset is compensated
+   */
+  static sptr
+  make(double samp_rate, double sat_freq, double lo_offset,
+       double out_samp_rate, bool compensate = true);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_DOPPLER_RESAMPLER_CC_H */
@@ -36,13 +36,28 @@ class SATNOGS_API frame_file_sink : virtual public gr::block {
 public:
   typedef boost::shared_ptr<frame_file_sink> sptr;
 
+  /**
+   * The supported output types
+   */
+  typedef enum {
+    BINARY = 0,
+    HEX_ANNOTATED,
+    BINARY_ANNOTATED,
+    FRAME_STORE
+  } output_type_t;
+
   /*!
    * Frame to file, sink block
    * @param prefix_name Prefix of the file name, including the directory path
-   * @param output_type Format type of the output file, txt, hex, bin
+   * @param output_type Format type of the output file, one of the
+   * output_type_t values. With FRAME_STORE all frames are appended
+   * to segment files, that can be read with the frame_store_reader.
+   * @param segment_size the maximum size of a segment file in bytes. Used
+   * only by the segmented frame store.
    */
   static sptr
-  make(const std::string &prefix_name, int output_type);
+  make(const std::string &prefix_name, int output_type,
+       size_t segment_size = 64 * 1024 * 1024);
 };
 
 } // namespace satnogs
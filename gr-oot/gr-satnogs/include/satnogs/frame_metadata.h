@@ -0,0 +1,110 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_SATNOGS_FRAME_METADATA_H
+#define INCLUDED_SATNOGS_FRAME_METADATA_H
+
+#include <satnogs/api.h>
+#include <satnogs/metadata.h>
+#include <pmt/pmt.h>
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <string>
+
+namespace gr {
+namespace satnogs {
+
+/**
+ * \brief Typed view of the metadata dictionary of a frame
+ *
+ * The metadata of the frames travel between blocks as PMT dictionaries.
+ * Instead of looking up each key separately, sinks parse the dictionary
+ * once into this record and then access its fields directly.
+ * The fields that were present at the dictionary are marked at a bitmap.
+ *
+ * PDU and string values are kept as references to the original PMT
+ * objects, so parsing does not copy any data.
+ */
+class SATNOGS_API frame_metadata {
+public:
+  frame_metadata();
+
+  frame_metadata(const pmt::pmt_t &m);
+
+  void
+  parse(const pmt::pmt_t &m);
+
+  void
+  clear();
+
+  /**
+   *
+   * @param k the metadata key
+   * @return true if the field @a k is present
+   */
+  bool
+  has(metadata::key_t k) const
+  {
+    return d_fields & (1U << k);
+  }
+
+  void
+  set(metadata::key_t k, const pmt::pmt_t &v);
+
+  pmt::pmt_t
+  to_pmt() const;
+
+  nlohmann::json
+  to_json() const;
+
+  void
+  write_json(std::string &out, const std::string &extra = std::string()) const;
+
+  pmt::pmt_t    pdu;
+  bool          crc_valid;
+  double        center_freq;
+  double        freq_offset;
+  uint64_t      phase_delay;
+  float         resampling_ratio;
+  uint64_t      corrected_bits;
+  pmt::pmt_t    time;
+  uint64_t      sample_start;
+  uint64_t      sample_cnt;
+  uint64_t      symbol_erasures;
+  float         snr;
+  pmt::pmt_t    decoder_name;
+  pmt::pmt_t    decoder_version;
+  double        antenna_azimuth;
+  double        antenna_elevation;
+  pmt::pmt_t    antenna_polarization;
+  double        symbol_timing_error;
+  long          decoder_id;
+
+private:
+  uint32_t      d_fields;
+
+  pmt::pmt_t
+  value(metadata::key_t k) const;
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_FRAME_METADATA_H */
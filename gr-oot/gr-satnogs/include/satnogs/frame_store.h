@@ -0,0 +1,181 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_SATNOGS_FRAME_STORE_H
+#define INCLUDED_SATNOGS_FRAME_STORE_H
+
+#include <satnogs/api.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gr {
+namespace satnogs {
+
+/**
+ * \brief Append-only storage of frames in segment files
+ *
+ * A segment file starts with the 8 byte header "SNFS" followed by the
+ * format version. Each frame is stored as a record with a 24 byte header
+ * containing the marker "SNFR", the length of the frame, the UTC time of
+ * its reception in microseconds and the index of its first sample. The
+ * frame follows, and then a CRC32-C of the record without the marker.
+ * When a segment is closed, an index with the offset, time and sample index
+ * of each record is appended, followed by a trailer pointing to it. All
+ * integers are little endian.
+ *
+ * Segments that were not closed properly have no index. They can still
+ * be read, as the reader recovers the index by scanning the records up to
+ * the first one that is incomplete or fails the marker and CRC check.
+ *
+ * The records are buffered in memory and written to the file by a
+ * background thread, either when they exceed the flush size or
+ * periodically, so that the caller never waits for the disk.
+ */
+class SATNOGS_API frame_store_writer {
+public:
+  frame_store_writer(const std::string &prefix,
+                     size_t max_segment_size = 64 * 1024 * 1024,
+                     size_t flush_size = 64 * 1024,
+                     double flush_interval = 1.0);
+  ~frame_store_writer();
+
+  void
+  append(const uint8_t *data, size_t len, uint64_t time_us,
+         uint64_t sample_start);
+
+  void
+  flush();
+
+  void
+  close();
+
+  std::string
+  filename() const;
+
+private:
+  struct index_entry {
+    uint64_t    offset;
+    uint64_t    time_us;
+    uint64_t    sample_start;
+  };
+
+  const std::string                     d_prefix;
+  const size_t                          d_max_segment_size;
+  const size_t                          d_flush_size;
+  const std::chrono::duration<double>   d_flush_interval;
+  std::ofstream                         d_file;
+  bool                                  d_open;
+  std::string                           d_filename;
+  std::string                           d_filename_prev;
+  int                                   d_counter;
+  uint64_t                              d_offset;
+  std::vector<uint8_t>                  d_buf;
+  std::vector<uint8_t>                  d_out;
+  std::vector<index_entry>              d_index;
+
+  /*
+   * d_mtx protects the segment state and the pending records. d_io_mtx
+   * protects the file and the records being written. When both are needed,
+   * d_mtx is taken first
+   */
+  mutable std::mutex                    d_mtx;
+  std::mutex                            d_io_mtx;
+  std::condition_variable               d_cond;
+  std::thread                           d_flusher;
+  bool                                  d_stop;
+
+  void
+  open_segment(uint64_t time_us);
+
+  void
+  close_segment();
+
+  void
+  write_pending();
+
+  void
+  flusher();
+};
+
+/**
+ * A frame read from a segment file
+ */
+struct SATNOGS_API frame_store_record {
+  uint64_t              time_us;
+  uint64_t              sample_start;
+  std::vector<uint8_t>  data;
+};
+
+/**
+ * \brief Reads the frames of a segment file created by frame_store_writer
+ */
+class SATNOGS_API frame_store_reader {
+public:
+  frame_store_reader(const std::string &filename);
+
+  size_t
+  size() const;
+
+  frame_store_record
+  read(size_t idx);
+
+  size_t
+  find_time(uint64_t time_us) const;
+
+  size_t
+  find_sample(uint64_t sample) const;
+
+private:
+  typedef std::pair<uint64_t, size_t> key_t;
+
+  std::ifstream         d_file;
+  uint64_t              d_file_size;
+  std::vector<uint64_t> d_offset;
+  /* (key, record index) pairs, sorted by key */
+  std::vector<key_t>    d_by_time;
+  std::vector<key_t>    d_by_sample;
+
+  void
+  add(uint64_t offset, uint64_t time_us, uint64_t sample_start);
+
+  bool
+  load_index();
+
+  void
+  scan();
+
+  bool
+  read_record(uint64_t offset, std::vector<uint8_t> &rec);
+
+  static size_t
+  find(const std::vector<key_t> &v, uint64_t key, size_t n);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_FRAME_STORE_H */
@@ -47,10 +47,14 @@ public:
   * @param extra every JSON frame can contain an arbitrary amount of extra information.
   * Use this fill to provide a JSON-valid string with such information.
   *
+  * @param compact if set to true, each frame is converted to a single line
+  * of compact JSON terminated by a newline, suitable for newline-delimited
+  * JSON streams. Otherwise, the JSON is indented and ASCII escaped.
+  *
   * @return shared pointer of the block instance
   */
   static sptr
-  make(const std::string &extra = "");
+  make(const std::string &extra = "", bool compact = false);
 };
 
 } // namespace satnogs
@@ -0,0 +1,130 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_SATNOGS_LFSR_ENGINE_H
+#define INCLUDED_SATNOGS_LFSR_ENGINE_H
+
+#include <satnogs/api.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Table driven LFSR for additive and self-synchronizing scrambling
+ *
+ * The register follows the conventions of gr::digital::lfsr, so it produces
+ * exactly the same bit sequences. Instead of shifting one bit at a time, the
+ * buffer methods advance the register 64 or 8 bits per step, using
+ * precomputed tables of the state transition and of the output for each
+ * byte of the register and of the input. The tables are shared by all the
+ * engines with the same polynomial, order and bit order.
+ */
+class SATNOGS_API lfsr_engine {
+public:
+  typedef enum {
+    ADDITIVE = 0,
+    SCRAMBLE,
+    DESCRAMBLE,
+    MODES_NUM
+  } mode_t;
+
+  lfsr_engine(uint64_t mask, uint64_t seed, uint32_t order, bool msb = false);
+
+  void
+  reset();
+
+  void
+  additive(uint8_t *out, const uint8_t *in, size_t len);
+
+  void
+  scramble(uint8_t *out, const uint8_t *in, size_t len);
+
+  void
+  descramble(uint8_t *out, const uint8_t *in, size_t len);
+
+  /**
+   *
+   * @return the next bit of the additive sequence
+   */
+  uint8_t
+  next_bit()
+  {
+    const uint8_t out = d_reg & 1;
+    d_reg = (d_reg >> 1) | (parity(d_reg & d_mask) << d_order);
+    return out;
+  }
+
+  /**
+   * Self-synchronizing scrambling of a single bit
+   * @param in the input bit
+   * @return the scrambled bit
+   */
+  uint8_t
+  next_bit_scramble(uint8_t in)
+  {
+    const uint8_t out = d_reg & 1;
+    d_reg = (d_reg >> 1) | ((parity(d_reg & d_mask) ^ (in & 1)) << d_order);
+    return out;
+  }
+
+  /**
+   * Self-synchronizing descrambling of a single bit
+   * @param in the input bit
+   * @return the descrambled bit
+   */
+  uint8_t
+  next_bit_descramble(uint8_t in)
+  {
+    const uint8_t out = parity(d_reg & d_mask) ^ (in & 1);
+    d_reg = (d_reg >> 1) | (static_cast<uint64_t>(in & 1) << d_order);
+    return out;
+  }
+
+private:
+  struct tables;
+
+  const uint64_t                d_mask;
+  const uint64_t                d_seed;
+  const uint32_t                d_order;
+  const bool                    d_msb;
+  const size_t                  d_reg_bytes;
+  uint64_t                      d_reg;
+  std::shared_ptr<const tables> d_tables[MODES_NUM];
+
+  static uint64_t
+  parity(uint64_t x)
+  {
+    return __builtin_parityll(x);
+  }
+
+  void
+  process(mode_t mode, uint8_t *out, const uint8_t *in, size_t len);
+
+  const tables &
+  get_tables(mode_t mode);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_LFSR_ENGINE_H */
@@ -50,14 +50,28 @@ SATNOGS_API int chainback_viterbi27_sse(void *p,unsigned char *data,unsigned int
 SATNOGS_API void delete_viterbi27_sse(void *p);
 SATNOGS_API int update_viterbi27_blk_sse(void *p,unsigned char *syms,int nbits);
 
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
 SATNOGS_API void *create_viterbi27_sse2(int len);
 SATNOGS_API void set_viterbi27_polynomial_sse2(int polys[2]);
 SATNOGS_API int init_viterbi27_sse2(void *p,int starting_state);
 SATNOGS_API int chainback_viterbi27_sse2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+SATNOGS_API int chainback_viterbi27_sse2_unpacked_trunc(void *p,unsigned char *data,unsigned int nbits);
 SATNOGS_API void delete_viterbi27_sse2(void *p);
 SATNOGS_API int update_viterbi27_blk_sse2(void *p,unsigned char *syms,int nbits);
 #endif
 
+#ifdef __x86_64__
+SATNOGS_API void *create_viterbi27_avx2(int len);
+SATNOGS_API void set_viterbi27_polynomial_avx2(int polys[2]);
+SATNOGS_API int init_viterbi27_avx2(void *p,int starting_state);
+SATNOGS_API int chainback_viterbi27_avx2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+SATNOGS_API int chainback_viterbi27_avx2_unpacked_trunc(void *p,unsigned char *data,unsigned int nbits);
+SATNOGS_API void delete_viterbi27_avx2(void *p);
+SATNOGS_API int update_viterbi27_blk_avx2(void *p,unsigned char *syms,int nbits);
+#endif
+
 SATNOGS_API void *create_viterbi27_port(int len);
 SATNOGS_API void set_viterbi27_polynomial_port(int polys[2]);
 SATNOGS_API int init_viterbi27_port(void *p,int starting_state);
@@ -101,6 +115,9 @@ SATNOGS_API int chainback_viterbi29_sse(void *p,unsigned char *data,unsigned int
 SATNOGS_API void delete_viterbi29_sse(void *p);
 SATNOGS_API int update_viterbi29_blk_sse(void *p,unsigned char *syms,int nbits);
 
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
 SATNOGS_API void *create_viterbi29_sse2(int len);
 SATNOGS_API void set_viterbi29_polynomial_sse2(int polys[2]);
 SATNOGS_API int init_viterbi29_sse2(void *p,int starting_state);
@@ -109,6 +126,15 @@ SATNOGS_API void delete_viterbi29_sse2(void *p);
 SATNOGS_API int update_viterbi29_blk_sse2(void *p,unsigned char *syms,int nbits);
 #endif
 
+#ifdef __x86_64__
+SATNOGS_API void *create_viterbi29_avx2(int len);
+SATNOGS_API void set_viterbi29_polynomial_avx2(int polys[2]);
+SATNOGS_API int init_viterbi29_avx2(void *p,int starting_state);
+SATNOGS_API int chainback_viterbi29_avx2(void *p,unsigned char *data,unsigned int nbits,unsigned int endstate);
+SATNOGS_API void delete_viterbi29_avx2(void *p);
+SATNOGS_API int update_viterbi29_blk_avx2(void *p,unsigned char *syms,int nbits);
+#endif
+
 SATNOGS_API void *create_viterbi29_port(int len);
 SATNOGS_API void set_viterbi29_polynomial_port(int polys[2]);
 SATNOGS_API int init_viterbi29_port(void *p,int starting_state);
@@ -152,6 +178,9 @@ SATNOGS_API int chainback_viterbi39_sse(void *p,unsigned char *data,unsigned int
 SATNOGS_API void delete_viterbi39_sse(void *p);
 SATNOGS_API int update_viterbi39_blk_sse(void *p,unsigned char *syms,int nbits);
 
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
 SATNOGS_API void *create_viterbi39_sse2(int len);
 SATNOGS_API void set_viterbi39_polynomial_sse2(int polys[3]);
 SATNOGS_API int init_viterbi39_sse2(void *p,int starting_state);
@@ -214,6 +243,9 @@ SATNOGS_API int chainback_viterbi615_sse(void *p,unsigned char *data,unsigned in
 SATNOGS_API void delete_viterbi615_sse(void *p);
 SATNOGS_API int update_viterbi615_blk_sse(void *p,unsigned char *syms,int nbits);
 
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
 SATNOGS_API void *create_viterbi615_sse2(int len);
 SATNOGS_API void set_viterbi615_polynomial_sse2(int polys[6]);
 SATNOGS_API int init_viterbi615_sse2(void *p,int starting_state);
@@ -261,7 +293,7 @@ SATNOGS_API int decode_rs_ccsds(unsigned char *data,int *eras_pos,int no_eras,in
 extern unsigned char Taltab[],Tal1tab[];
 
 /* CPU SIMD instruction set available */
-extern enum cpu_mode {UNKNOWN=0,PORT,MMX,SSE,SSE2,ALTIVEC} Cpu_mode;
+extern enum cpu_mode {UNKNOWN=0,PORT,MMX,SSE,SSE2,ALTIVEC,AVX2} Cpu_mode;
 SATNOGS_API void find_cpu_mode(void); /* Call this once at startup to set Cpu_mode */
 
 /* Determine parity of argument: 1 = odd, 0 = even */
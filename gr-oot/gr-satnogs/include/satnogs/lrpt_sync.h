@@ -43,9 +43,16 @@ public:
    * constructor is in a private implementation
    * class. satnogs::lrpt_sync::make is the public interface for
    * creating new instances.
+   *
+   * @param threshold the maximum number of bit errors allowed at the
+   * coded ASM
+   * @param soft if set to true, the CADU message carries one 8-bit soft
+   * symbol per coded bit (0 for a strong 0, 255 for a strong 1), suitable
+   * for soft-decision Viterbi decoding. Otherwise it carries the hard
+   * decisions packed into bytes
    */
   static sptr
-  make(size_t threshold = 2);
+  make(size_t threshold = 2, bool soft = false);
 };
 
 } // namespace satnogs
@@ -57,12 +57,19 @@ public:
     ANTENNA_ELEVATION,
     ANTENNA_POLARIZATION,
     SYMBOL_TIMING_ERROR,
+    DECODER_ID,
     KEYS_NUM
   } key_t;
 
   static std::string
   value(const key_t &k);
 
+  static const pmt::pmt_t &
+  key(key_t k);
+
+  static void
+  add(pmt::pmt_t &m, key_t k, const pmt::pmt_t &v);
+
   static std::string
   keys();
 
@@ -124,6 +131,9 @@ public:
   static void
   add_symbol_timing_error(pmt::pmt_t &m, double error);
 
+  static void
+  add_decoder_id(pmt::pmt_t &m, int id);
+
   static nlohmann::json
   to_json(const pmt::pmt_t &m);
 
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_SATNOGS_MULTI_FRAME_DECODER_H
+#define INCLUDED_SATNOGS_MULTI_FRAME_DECODER_H
+
+#include <satnogs/api.h>
+#include <gnuradio/sync_block.h>
+#include <satnogs/decoder.h>
+#include <vector>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Runs several decoders over the same input stream.
+ *
+ * This block is equivalent to connecting a frame_decoder block for each
+ * of the decoders to the same stream. Instead, the input buffer is shared
+ * by all the decoders and they are executed in parallel by a pool of
+ * threads, each thread picking the next decoder that has not been run yet.
+ *
+ * Each decoder reads the input at its own pace. The block consumes its
+ * input immediately and keeps the items that the slowest decoder has not
+ * processed yet, up to 16 times the largest maximum frame length of the
+ * decoders. A decoder that falls further behind is reset and continues
+ * from the newest items, so it cannot stall the others.
+ *
+ * The frames of all decoders are published at the same message port.
+ * The decoder_id metadata field holds the unique id of the decoder that
+ * produced each frame.
+ *
+ * \ingroup satnogs
+ *
+ */
+class SATNOGS_API multi_frame_decoder : virtual public gr::sync_block {
+public:
+  typedef boost::shared_ptr<multi_frame_decoder> sptr;
+
+  /*!
+   * \brief Return a shared_ptr to a new instance of
+   * satnogs::multi_frame_decoder.
+   *
+   * @param decoders the decoder objects to use. All of them should accept
+   * input items of the same size
+   * @param input_size the size of the input items
+   * @param nthreads the number of threads that execute the decoders,
+   * including the thread of the block. If 0, one thread for each decoder
+   * is used, up to the number of available cores
+   */
+  static sptr make(const std::vector<decoder::decoder_sptr> &decoders,
+                   int input_size, size_t nthreads = 0);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_MULTI_FRAME_DECODER_H */
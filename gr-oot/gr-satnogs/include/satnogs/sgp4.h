@@ -0,0 +1,106 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_SGP4_H
+#define INCLUDED_SATNOGS_SGP4_H
+
+#include <satnogs/api.h>
+#include <string>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief SGP4 orbit propagator for Two-Line Element sets
+ *
+ * Implements the near earth SGP4 model of the Spacetrack Report #3, with
+ * the WGS-72 constants and the corrections of Vallado et al., "Revisiting
+ * Spacetrack Report #3". Orbits with a period of 225 minutes or more need
+ * the SDP4 deep space model and are not supported.
+ *
+ * Positions and velocities are given in the True Equator Mean Equinox
+ * (TEME) frame, in km and km/s respectively.
+ */
+class SATNOGS_API sgp4 {
+public:
+  sgp4(const std::string &line1, const std::string &line2);
+
+  double
+  epoch() const;
+
+  void
+  propagate(double tsince, double pos[3], double vel[3]) const;
+
+  void
+  position(double t, double pos[3], double vel[3]) const;
+
+  static double
+  gmst(double t);
+
+private:
+  /* Mean elements at epoch */
+  double d_epoch;
+  double d_ecco;
+  double d_inclo;
+  double d_nodeo;
+  double d_argpo;
+  double d_mo;
+  double d_no;
+  double d_bstar;
+
+  /* Terms computed once by the initialization */
+  bool d_isimp;
+  double d_ao;
+  double d_con41;
+  double d_x1mth2;
+  double d_x7thm1;
+  double d_cosio;
+  double d_sinio;
+  double d_eta;
+  double d_cc1;
+  double d_cc4;
+  double d_cc5;
+  double d_d2;
+  double d_d3;
+  double d_d4;
+  double d_delmo;
+  double d_sinmao;
+  double d_mdot;
+  double d_argpdot;
+  double d_nodedot;
+  double d_nodecf;
+  double d_omgcof;
+  double d_xmcof;
+  double d_t2cof;
+  double d_t3cof;
+  double d_t4cof;
+  double d_t5cof;
+  double d_xlcof;
+  double d_aycof;
+
+  void
+  init();
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_SGP4_H */
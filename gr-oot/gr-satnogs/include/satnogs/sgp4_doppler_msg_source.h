@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_SGP4_DOPPLER_MSG_SOURCE_H
+#define INCLUDED_SATNOGS_SGP4_DOPPLER_MSG_SOURCE_H
+
+#include <satnogs/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Predicts the Doppler shifted frequency of a satellite from its TLE
+ * and produces frequency messages for the doppler_correction_cc block
+ *
+ * The orbit is propagated locally with SGP4, so no external rigctl client
+ * is needed. Each message is a pair of the sample index, counted from the
+ * start of the flowgraph, and the absolute frequency that the satellite
+ * signal will have at that sample. The doppler_correction_cc block fits
+ * the predictions at their exact sample positions.
+ *
+ * The input should be connected to the same stream as the correction
+ * block. The predictions are paced by the samples of this stream and
+ * published a few intervals ahead of them, so the stream can be processed
+ * at any rate, e.g. when replaying a recording with a \p start_time.
+ * \ingroup satnogs
+ *
+ */
+class SATNOGS_API sgp4_doppler_msg_source : virtual public gr::sync_block {
+public:
+  typedef boost::shared_ptr<sgp4_doppler_msg_source> sptr;
+
+  /**
+   * SGP4 Doppler frequency predictor
+   *
+   * @param tle1 the first line of the TLE
+   * @param tle2 the second line of the TLE
+   * @param lat the latitude of the ground station in degrees
+   * @param lon the longitude of the ground station in degrees
+   * @param alt the altitude of the ground station in meters
+   * @param target_freq the transmit frequency of the satellite in Hz
+   * @param sampling_rate the sampling rate of the stream that is corrected
+   * @param start_time the UNIX time of the first sample. If 0, the time
+   * that the flowgraph started is used
+   * @param interval_ms the interval in milliseconds between successive
+   * predictions
+   * @return shared pointer of the block
+   */
+  static sptr
+  make(const std::string &tle1, const std::string &tle2,
+       double lat, double lon, double alt, double target_freq,
+       double sampling_rate, double start_time = 0.0,
+       size_t interval_ms = 1000);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_SGP4_DOPPLER_MSG_SOURCE_H */
@@ -22,15 +22,21 @@
 #define INCLUDED_SATNOGS_SHIFT_REG_H
 
 #include <satnogs/api.h>
-#include <deque>
+#include <cstdint>
 #include <ostream>
+#include <vector>
 
 namespace gr {
 namespace satnogs {
 
 /*!
- * \brief Implements a bit shift register
+ * \brief Fixed length shift register of bits
  *
+ * The bits are stored packed in 64-bit words. Index 0 refers to the front
+ * of the register, which is the oldest bit when shifting in with
+ * operator<<=(). Internally the back of the register is kept at the LS bit
+ * of the first word, so shifting and comparing registers of a few tens of
+ * bits costs only a couple of word operations.
  */
 class SATNOGS_API shift_reg {
 public:
@@ -50,28 +56,54 @@ public:
   size() const;
 
   size_t
-  count();
+  count() const;
+
+  size_t
+  hamming_distance(const shift_reg &rhs) const;
 
   shift_reg
-  operator|(const shift_reg &rhs);
+  operator|(const shift_reg &rhs) const;
 
   shift_reg
-  operator&(const shift_reg &rhs);
+  operator&(const shift_reg &rhs) const;
 
   shift_reg
-  operator^(const shift_reg &rhs);
+  operator^(const shift_reg &rhs) const;
 
   shift_reg &
-  operator>>=(bool bit);
+  operator|=(const shift_reg &rhs);
+
+  shift_reg &
+  operator&=(const shift_reg &rhs);
+
+  shift_reg &
+  operator^=(const shift_reg &rhs);
 
-  bool &
-  operator[](size_t pos);
+  shift_reg &
+  operator>>=(bool bit);
 
   bool
   operator[](size_t pos) const;
 
+  /**
+   * Shifts a new bit at the back of the register, dropping the front one
+   * @param bit the new bit
+   * @return reference to the register
+   */
   shift_reg &
-  operator<<=(bool bit);
+  operator<<=(bool bit)
+  {
+    if (d_reg.size() == 1) {
+      d_reg[0] = ((d_reg[0] << 1) | bit) & d_last_mask;
+    }
+    else {
+      shift_left(bit);
+    }
+    return *this;
+  }
+
+  void
+  set(size_t pos, bool bit);
 
   void
   push_front(bool bit);
@@ -80,21 +112,24 @@ public:
   push_back(bool bit);
 
   bool
-  front();
+  front() const;
 
   bool
-  back();
+  back() const;
 
   friend std::ostream &
   operator<<(std::ostream &os, const shift_reg &reg);
 
 private:
   const size_t          d_len;
-  std::deque<bool>      d_reg;
+  const uint64_t        d_last_mask;
+  std::vector<uint64_t> d_reg;
+
+  void
+  shift_left(bool bit);
 };
 
 } // namespace satnogs
 } // namespace gr
 
 #endif /* INCLUDED_SATNOGS_SHIFT_REG_H */
-
@@ -39,11 +39,45 @@ public:
 
   /**
    * UDP sink that accepts PMT messages
-   * @param addr the address of the destination host
+   *
+   * In batching mode, the messages are copied to a bounded queue and sent
+   * by a dedicated thread with sendmmsg(), so the message handler never
+   * blocks on the socket. If the queue is full, the message is dropped.
+   *
+   * @param addr the address of the destination host. Multiple destinations
+   * can be given separated by commas. Each one of them may have its own
+   * port, in the form 127.0.0.1:16887
    * @param port the destination UDP port
-   * @param mtu the maximum MTU
+   * @param mtu the maximum MTU. Larger messages are dropped
+   * @param batch enables the batching mode
+   * @param latency_ms the maximum time in milliseconds that a message may
+   * wait in the queue, so it can be sent together with the following ones
+   * @param queue_size the number of messages the queue can hold
    */
-  static sptr make(const std::string &addr, uint16_t port, size_t mtu);
+  static sptr make(const std::string &addr, uint16_t port, size_t mtu,
+                   bool batch = false, double latency_ms = 1.0,
+                   size_t queue_size = 1024);
+
+  /**
+   *
+   * @return the number of messages dropped because the queue was full
+   */
+  virtual uint64_t
+  dropped() const = 0;
+
+  /**
+   *
+   * @return the number of messages dropped because they exceeded the MTU
+   */
+  virtual uint64_t
+  oversized() const = 0;
+
+  /**
+   *
+   * @return the number of datagrams that the socket failed to send
+   */
+  virtual uint64_t
+  send_errors() const = 0;
 };
 
 } // namespace satnogs
@@ -47,10 +47,13 @@ public:
    * @param mtu the maximum MTU. Used to pre-allocate a maximum packet size
    * @param type code of the data type of each message. 0 corresponds to raw
    * bytes, 1 to 32-bit signed integers and 2 to 3 bit unsigned integers.
+   * @param stream if true, the payload of the datagrams is delivered as a
+   * byte stream through the output port, instead of messages. In this
+   * case the @a type is ignored.
    */
   static sptr
   make(const std::string &addr, uint16_t port, size_t mtu = 1500,
-       size_t type = 0);
+       size_t type = 0, bool stream = false);
 };
 
 } // namespace satnogs
@@ -71,7 +71,8 @@ public:
    * observation.
    * Each waterfall line is prepended with a int64_t field indicating the
    * absolute time in microseconds with respect to the start of the waterfall
-   * data (stored in the corresponding header field).
+   * data (stored in the corresponding header field). The time is derived
+   * from the number of samples processed up to the end of the line.
    * The spectral content is stored in $FFT$ float values already converted in
    * dB scale.
    *
@@ -22,7 +22,7 @@
 #define INCLUDED_SATNOGS_WHITENING_H
 
 #include <satnogs/api.h>
-#include <gnuradio/digital/lfsr.h>
+#include <satnogs/lfsr_engine.h>
 #include <boost/shared_ptr.hpp>
 
 namespace gr {
@@ -73,7 +73,7 @@ public:
 private:
   const bool            d_msb;
   const bool            d_self_sync;
-  digital::lfsr         d_lfsr;
+  lfsr_engine           d_lfsr;
   int                   d_id;
 };
 
@@ -48,6 +48,7 @@ argos_ldr_decoder::argos_ldr_decoder(bool crc_check, size_t max_frame_len) :
   d_decoded_bits(0),
   d_frame_buffer(
     new uint8_t[max_frame_len + sizeof(uint16_t)]),
+  d_bitstream(4 * max_frame_len * 8),
   d_start_idx(0),
   d_frame_start(0),
   d_sample_cnt(0)
@@ -59,15 +60,22 @@ argos_ldr_decoder::decode(const void *in, int len)
 {
   const uint8_t *input = (const uint8_t *) in;
   decoder_status_t status;
-
-  for (int i = 0; i < len; i++) {
-    d_bitstream.push_back(input[i]);
-  }
-  /*
-   * The decoder always consumes all the available input bits and stores them
-   * internally
-   */
-  _decode(status);
+  int i = 0;
+  do {
+    if (d_bitstream.full()) {
+      drop_bitstream();
+    }
+    i += d_bitstream.push_back(input + i, len - i);
+    _decode(status);
+    /*
+     * Back-to-back frames may already be in the bitstream, so keep decoding
+     * until no new frame is found
+     */
+    while (status.decode_success) {
+      status.next_frame();
+      _decode(status);
+    }
+  } while (i < len);
   status.consumed = len;
   return status;
 }
@@ -95,8 +103,7 @@ argos_ldr_decoder::_decode(decoder_status_t &status)
                               | (ax25::sync_flag << 8)
                               | (ax25::sync_flag << 16);
         if (test == d_shift_reg) {
-          d_bitstream.erase(d_bitstream.begin(),
-                            d_bitstream.begin() + i + 1);
+          d_bitstream.consume(i + 1);
           /* Increment the number of items read so far */
           incr_nitems_read(i + 1);
           enter_sync_state();
@@ -143,8 +150,7 @@ argos_ldr_decoder::_decode(decoder_status_t &status)
           d_sample_cnt = nitems_read() + i - d_frame_start;
           LOG_DEBUG("Found frame end");
           if (enter_frame_end(status)) {
-            d_bitstream.erase(d_bitstream.begin(),
-                              d_bitstream.begin() + i + 1);
+            d_bitstream.consume(i + 1);
             /* Increment the number of items read so far */
             incr_nitems_read(i + 1);
             d_start_idx = d_bitstream.size();
@@ -198,6 +204,19 @@ argos_ldr_decoder::~argos_ldr_decoder()
   delete[] d_frame_buffer;
 }
 
+/**
+ * Drops all the buffered bits. This should happen only if the bitstream
+ * is full, without any frame decoded, e.g. due to a very long preamble
+ */
+void
+argos_ldr_decoder::drop_bitstream()
+{
+  LOG_DEBUG("Bitstream overflow");
+  incr_nitems_read(d_bitstream.size());
+  d_bitstream.clear();
+  reset_state();
+}
+
 void
 argos_ldr_decoder::reset_state()
 {
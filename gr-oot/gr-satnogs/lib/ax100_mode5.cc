@@ -171,8 +171,8 @@ ax100_mode5::search_preamble(const uint8_t *in, int len)
 
   for (int i = 0; i < len; i++) {
     d_preamble_shift_reg <<= in[i];
-    shift_reg tmp = d_preamble_shift_reg ^ d_preamble;
-    if (tmp.count() <= d_preamble_thrsh) {
+    if (d_preamble_shift_reg.hamming_distance(d_preamble)
+        <= d_preamble_thrsh) {
       d_state = SEARCHING_SYNC;
       d_cnt = 0;
       d_frame_start = nitems_read() + i + 1;
@@ -187,9 +187,8 @@ ax100_mode5::search_sync(const uint8_t *in, int len)
 {
   for (int i = 0; i < len; i++) {
     d_sync_shift_reg <<= in[i];
-    shift_reg tmp = d_sync_shift_reg ^ d_sync;
     d_cnt++;
-    if (tmp.count() <= d_sync_thrsh) {
+    if (d_sync_shift_reg.hamming_distance(d_sync) <= d_sync_thrsh) {
       LOG_DEBUG("DECODING_FRAME_LEN");
       d_state = DECODING_FRAME_LEN;
       d_cnt = 0;
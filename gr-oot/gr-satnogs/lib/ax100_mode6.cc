@@ -29,6 +29,7 @@
 #include <satnogs/utils.h>
 #include <satnogs/libfec/fec.h>
 #include <satnogs/metadata.h>
+#include <algorithm>
 
 namespace gr {
 namespace satnogs {
@@ -57,6 +58,7 @@ ax100_mode6::ax100_mode6(crc::crc_t crc, whitening::whitening_sptr descrambler,
   d_lfsr(0x21, 0x0, 16),
   d_frame_buffer(
     new uint8_t[d_max_frame_len + ax25::max_header_len + sizeof(uint16_t)]),
+  d_bitstream(4 * d_max_frame_len * 8),
   d_start_idx(0),
   d_frame_start(0),
   d_sample_cnt(0)
@@ -68,28 +70,39 @@ ax100_mode6::decode(const void *in, int len)
 {
   const uint8_t *input = (const uint8_t *) in;
   decoder_status_t status;
-  if (d_ax25_descramble) {
-    for (int i = 0; i < len; i++) {
-      /* Perform NRZI decoding */
-      uint8_t b = (~((input[i] - d_prev_bit_nrzi) % 2)) & 0x1;
-      d_prev_bit_nrzi = input[i];
-      b = d_lfsr.next_bit_descramble(b);
-      d_bitstream.push_back(b);
+  int i = 0;
+  do {
+    if (d_bitstream.full()) {
+      drop_bitstream();
     }
-  }
-  else {
-    for (int i = 0; i < len; i++) {
-      /* Perform NRZI decoding */
-      uint8_t b = (~((input[i] - d_prev_bit_nrzi) % 2)) & 0x1;
-      d_prev_bit_nrzi = input[i];
-      d_bitstream.push_back(b);
+    const int end = i + std::min<size_t>(len - i, d_bitstream.space());
+    if (d_ax25_descramble) {
+      for (; i < end; i++) {
+        /* Perform NRZI decoding */
+        uint8_t b = (~((input[i] - d_prev_bit_nrzi) % 2)) & 0x1;
+        d_prev_bit_nrzi = input[i];
+        b = d_lfsr.next_bit_descramble(b);
+        d_bitstream.push_back(b);
+      }
     }
-  }
-  /*
-   * The decoder always consumes all the available input bits and stores them
-   * internally
-   */
-  _decode(status);
+    else {
+      for (; i < end; i++) {
+        /* Perform NRZI decoding */
+        uint8_t b = (~((input[i] - d_prev_bit_nrzi) % 2)) & 0x1;
+        d_prev_bit_nrzi = input[i];
+        d_bitstream.push_back(b);
+      }
+    }
+    _decode(status);
+    /*
+     * Back-to-back frames may already be in the bitstream, so keep decoding
+     * until no new frame is found
+     */
+    while (status.decode_success) {
+      status.next_frame();
+      _decode(status);
+    }
+  } while (i < len);
   status.consumed = len;
   return status;
 }
@@ -124,8 +137,7 @@ ax100_mode6::_decode(decoder_status_t &status)
                               | (ax25::sync_flag << 8)
                               | (ax25::sync_flag << 16);
         if (test == d_shift_reg) {
-          d_bitstream.erase(d_bitstream.begin(),
-                            d_bitstream.begin() + i + 1);
+          d_bitstream.consume(i + 1);
           /* Increment the number of items read so far */
           incr_nitems_read(i + 1);
           enter_sync_state();
@@ -174,8 +186,7 @@ ax100_mode6::_decode(decoder_status_t &status)
           d_sample_cnt = nitems_read() + i - d_frame_start;
           LOG_DEBUG("Found frame end");
           if (enter_frame_end(status)) {
-            d_bitstream.erase(d_bitstream.begin(),
-                              d_bitstream.begin() + i + 1);
+            d_bitstream.consume(i + 1);
             /* Increment the number of items read so far */
             incr_nitems_read(i + 1);
             d_start_idx = d_bitstream.size();
@@ -223,6 +234,19 @@ ax100_mode6::~ax100_mode6()
   delete[] d_frame_buffer;
 }
 
+/**
+ * Drops all the buffered bits. This should happen only if the bitstream
+ * is full, without any frame decoded, e.g. due to a very long preamble
+ */
+void
+ax100_mode6::drop_bitstream()
+{
+  LOG_DEBUG("Bitstream overflow");
+  incr_nitems_read(d_bitstream.size());
+  d_bitstream.clear();
+  reset_state();
+}
+
 void
 ax100_mode6::reset_state()
 {
@@ -23,12 +23,11 @@
 
 #include <satnogs/api.h>
 #include <satnogs/decoder.h>
-#include <gnuradio/digital/lfsr.h>
+#include <satnogs/bitstream.h>
+#include <satnogs/lfsr_engine.h>
 #include <satnogs/crc.h>
 #include <satnogs/whitening.h>
 
-#include <deque>
-
 namespace gr {
 namespace satnogs {
 
@@ -89,9 +88,9 @@ private:
   uint8_t d_prev_bit_nrzi;
   size_t d_received_bytes;
   size_t d_decoded_bits;
-  digital::lfsr d_lfsr;
+  lfsr_engine d_lfsr;
   uint8_t *d_frame_buffer;
-  std::deque<uint8_t> d_bitstream;
+  bitstream d_bitstream;
   size_t d_start_idx;
   uint64_t d_frame_start;
   uint64_t d_sample_cnt;
@@ -108,6 +107,9 @@ private:
   bool
   _decode(decoder_status_t &status);
 
+  void
+  drop_bitstream();
+
   inline void
   decode_1b(uint8_t in);
 };
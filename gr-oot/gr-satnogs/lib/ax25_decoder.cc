@@ -26,6 +26,9 @@
 #include <satnogs/ax25_decoder.h>
 #include <satnogs/ax25.h>
 #include <satnogs/metadata.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 namespace gr {
 namespace satnogs {
@@ -33,35 +36,41 @@ namespace satnogs {
 decoder::decoder_sptr
 ax25_decoder::make(const std::string &addr, uint8_t ssid, bool promisc,
                    bool descramble, bool crc_check, size_t max_frame_len,
-                   bool error_correction)
+                   bool error_correction, size_t max_error_bits)
 {
   return decoder::decoder_sptr(
            new ax25_decoder(addr, ssid, promisc, descramble, crc_check,
-                            max_frame_len, error_correction));
+                            max_frame_len, error_correction, max_error_bits));
 }
 
 ax25_decoder::ax25_decoder(const std::string &addr, uint8_t ssid, bool promisc,
                            bool descramble, bool crc_check, size_t max_frame_len,
-                           bool error_correction) :
+                           bool error_correction, size_t max_error_bits) :
   decoder("ax25", "1.2", sizeof(uint8_t), 2 * max_frame_len * 8),
   d_promisc(promisc),
   d_descramble(descramble),
   d_crc_check(crc_check),
   d_max_frame_len(max_frame_len),
   d_error_correction(error_correction),
+  d_max_error_bits(max_error_bits),
   d_state(NO_SYNC),
   d_shift_reg(0x0),
   d_dec_b(0x0),
   d_prev_bit_nrzi(0),
   d_received_bytes(0),
   d_decoded_bits(0),
-  d_lfsr(0x21, 0x0, 16),
+  d_descrambler_reg(0),
   d_frame_buffer(
     new uint8_t[max_frame_len + ax25::max_header_len + sizeof(uint16_t)]),
+  d_bitstream(2 * max_frame_len * 8),
   d_start_idx(0),
   d_frame_start(0),
   d_sample_cnt(0)
 {
+  if (max_error_bits < 1 || max_error_bits > 2) {
+    throw std::invalid_argument(
+      "ax25_decoder: Error correction supports up to 2 bits");
+  }
 }
 
 decoder_status_t
@@ -69,28 +78,28 @@ ax25_decoder::decode(const void *in, int len)
 {
   const uint8_t *input = (const uint8_t *) in;
   decoder_status_t status;
-  if (d_descramble) {
-    for (int i = 0; i < len; i++) {
-      /* Perform NRZI decoding */
-      uint8_t b = (~((input[i] - d_prev_bit_nrzi) % 2)) & 0x1;
-      d_prev_bit_nrzi = input[i];
-      b = d_lfsr.next_bit_descramble(b);
-      d_bitstream.push_back(b);
+  int i = 0;
+  do {
+    if (d_bitstream.full()) {
+      drop_bitstream();
     }
-  }
-  else {
-    for (int i = 0; i < len; i++) {
-      /* Perform NRZI decoding */
-      uint8_t b = (~((input[i] - d_prev_bit_nrzi) % 2)) & 0x1;
-      d_prev_bit_nrzi = input[i];
-      d_bitstream.push_back(b);
+    const int end = i + std::min<size_t>(len - i, d_bitstream.space());
+    while (i < end) {
+      const size_t n = std::min(end - i, 64);
+      d_bitstream.push_back_bits(
+        nrzi_descramble(bitstream::pack(input + i, n), n), n);
+      i += n;
     }
-  }
-  /*
-   * The decoder always consumes all the available input bits and stores them
-   * internally
-   */
-  _decode(status);
+    _decode(status);
+    /*
+     * Back-to-back frames may already be in the bitstream, so keep decoding
+     * until no new frame is found
+     */
+    while (status.decode_success) {
+      status.next_frame();
+      _decode(status);
+    }
+  } while (i < len);
   status.consumed = len;
   return status;
 }
@@ -101,6 +110,52 @@ ax25_decoder::reset()
   reset_state();
 }
 
+/*
+ * Word-wise operations over the raw HDLC bits. A window holds the 8 previous
+ * bits (the shift register) at the LS byte, followed by up to 56 new bits.
+ * Each of the masks below has a bit set at the position of the window where
+ * the corresponding condition is met for the 8 most recent bits.
+ */
+static const size_t hdlc_chunk = 56;
+
+static inline uint64_t
+hdlc_window(uint8_t shift_reg, uint64_t bits)
+{
+  return shift_reg | (bits << 8);
+}
+
+/* At least 5 consecutive 1s ending at each position */
+static inline uint64_t
+hdlc_ones5(uint64_t w)
+{
+  return w & (w << 1) & (w << 2) & (w << 3) & (w << 4);
+}
+
+/* The shift register contains the AX.25 flag */
+static inline uint64_t
+hdlc_flags(uint64_t w)
+{
+  return ~w & (hdlc_ones5(w) << 1) & (w << 6) & ~(w << 7);
+}
+
+/*
+ * Positions that are not plain data bits: a 0 after five 1s (stuffed bit or
+ * flag) or seven consecutive 1s (abort)
+ */
+static inline uint64_t
+hdlc_events(uint64_t w)
+{
+  const uint64_t ones5 = hdlc_ones5(w);
+  return (~w & (ones5 << 1)) | (ones5 & (w << 5) & (w << 6));
+}
+
+/* Keeps only the positions of the n new bits */
+static inline uint64_t
+hdlc_new_bits(uint64_t mask, size_t n)
+{
+  return (mask >> 8) & ((1ULL << n) - 1);
+}
+
 bool
 ax25_decoder::_decode(decoder_status_t &status)
 {
@@ -108,9 +163,13 @@ ax25_decoder::_decode(decoder_status_t &status)
     bool cont = false;
     switch (d_state) {
     case NO_SYNC:
-      for (size_t i = 0; i < d_bitstream.size(); i++) {
-        decode_1b(d_bitstream[i]);
-        if (ax25::sync_flag == d_shift_reg) {
+      for (size_t i = 0; i < d_bitstream.size(); i += hdlc_chunk) {
+        const size_t n = std::min(hdlc_chunk, d_bitstream.size() - i);
+        const uint64_t bits = d_bitstream.get(i, n);
+        const uint64_t flags =
+          hdlc_new_bits(hdlc_flags(hdlc_window(d_shift_reg, bits)), n);
+        if (flags) {
+          const size_t idx = i + __builtin_ctzll(flags);
           LOG_DEBUG("Have SYNC");
           /*
            * If this was a false positive, the next possible valid AX.25 flag
@@ -118,10 +177,9 @@ ax25_decoder::_decode(decoder_status_t &status)
            * empty the buffer until the last zero sample of the first possible
            * AX.25 SYNC flag encountered
            */
-          d_bitstream.erase(d_bitstream.begin(),
-                            d_bitstream.begin() + i);
+          d_bitstream.consume(idx);
           /* Increment the number of items read so far */
-          incr_nitems_read(i);
+          incr_nitems_read(idx);
           enter_sync_state();
           /* Mark possible start of the frame */
           d_frame_start = nitems_read();
@@ -129,6 +187,7 @@ ax25_decoder::_decode(decoder_status_t &status)
           cont = true;
           break;
         }
+        decode_nb(bits, n);
       }
       if (cont) {
         continue;
@@ -136,15 +195,25 @@ ax25_decoder::_decode(decoder_status_t &status)
       incr_nitems_read(d_bitstream.size());
       d_bitstream.clear();
       return false;
-    case IN_SYNC:
+    case IN_SYNC: {
       /*
        * Most of the transmitters repeat several times the AX.25 SYNC
        * In case of G3RUH this is mandatory to allow the self synchronizing
        * scrambler to settle
        */
-      for (size_t i = d_start_idx; i < d_bitstream.size(); i++) {
-        decode_1b(d_bitstream[i]);
-        d_decoded_bits++;
+      size_t i = d_start_idx;
+      while (i < d_bitstream.size()) {
+        /* Skip quickly long runs of byte aligned flags */
+        if (d_decoded_bits == 0 && d_bitstream.size() - i >= 64
+            && d_bitstream.get(i, 64) == 0x7e7e7e7e7e7e7e7eULL) {
+          decode_nb(0x7e, 8);
+          i += 64;
+          continue;
+        }
+        const size_t n = std::min(8 - d_decoded_bits, d_bitstream.size() - i);
+        decode_nb(d_bitstream.get(i, n), n);
+        d_decoded_bits += n;
+        i += n;
         if (d_decoded_bits == 8) {
           /* Perhaps we are in frame! */
           if (d_shift_reg != ax25::sync_flag) {
@@ -152,9 +221,8 @@ ax25_decoder::_decode(decoder_status_t &status)
              * Again, leave the 7 last processed samples inside the buffer
              *  in case this was a false alarm of a frame start
              */
-            d_bitstream.erase(d_bitstream.begin(),
-                              d_bitstream.begin() + i + 1 - 7);
-            incr_nitems_read(i + 1 - 7);
+            d_bitstream.consume(i - 7);
+            incr_nitems_read(i - 7);
             d_start_idx = 7;
             enter_decoding_state();
             cont = true;
@@ -172,9 +240,32 @@ ax25_decoder::_decode(decoder_status_t &status)
       }
       d_start_idx = d_bitstream.size();
       return false;
-    case DECODING:
-      for (size_t i = d_start_idx; i < d_bitstream.size(); i++) {
-        decode_1b(d_bitstream[i]);
+    }
+    case DECODING: {
+      size_t i = d_start_idx;
+      while (i < d_bitstream.size()) {
+        /*
+         * Bits up to the first flag, stuffed bit or abort sequence are plain
+         * data bits and are shifted in all at once
+         */
+        const size_t n = std::min(hdlc_chunk, d_bitstream.size() - i);
+        const uint64_t bits = d_bitstream.get(i, n);
+        const uint64_t events =
+          hdlc_new_bits(hdlc_events(hdlc_window(d_shift_reg, bits)), n);
+        const size_t ndata = events ? __builtin_ctzll(events) : n;
+        if (decode_data_bits(bits, ndata)) {
+          /*Check if the frame limit was reached */
+          LOG_DEBUG("Wrong size");
+          reset_state();
+          cont = true;
+          break;
+        }
+        i += ndata;
+        if (!events) {
+          continue;
+        }
+
+        decode_1b((bits >> ndata) & 0x1);
         if (d_shift_reg == ax25::sync_flag) {
           /*
            * The stop flag should be at a byte boundary. If not this is a
@@ -182,8 +273,7 @@ ax25_decoder::_decode(decoder_status_t &status)
            * AX.25 SYNC flag is a start for a new frame
            */
           if (d_decoded_bits != 7) {
-            d_bitstream.erase(d_bitstream.begin(),
-                              d_bitstream.begin() + i + 1 - 8);
+            d_bitstream.consume(i + 1 - 8);
             incr_nitems_read(i + 1 - 8);
             reset_state();
             cont = true;
@@ -196,8 +286,7 @@ ax25_decoder::_decode(decoder_status_t &status)
            * AX.25 termination SYNC flag of the previous frame. Thus, we
            * delete only the data portion from the bitstream buffer
            */
-          d_bitstream.erase(d_bitstream.begin(),
-                            d_bitstream.begin() + i + 1 - 8);
+          d_bitstream.consume(i + 1 - 8);
           incr_nitems_read(i + 1 - 8);
 
           if (enter_frame_end(status)) {
@@ -210,7 +299,7 @@ ax25_decoder::_decode(decoder_status_t &status)
           /*This was a stuffed bit */
           d_dec_b <<= 1;
         }
-        else if ((d_shift_reg & 0xfe) == 0xfe) {
+        else {
           LOG_DEBUG("Invalid shift register value 0x%02x", d_shift_reg);
           /*
            * Again at this point, we have not encounter yet any AX.25 flag
@@ -218,34 +307,20 @@ ax25_decoder::_decode(decoder_status_t &status)
            * led to this invalid shift register value. These maybe the start
            * of a new frame
            */
-          d_bitstream.erase(d_bitstream.begin(),
-                            d_bitstream.begin() + i + 1 - 8);
+          d_bitstream.consume(i + 1 - 8);
           incr_nitems_read(i + 1 - 8);
           reset_state();
           cont = true;
           break;
         }
-        else {
-          d_decoded_bits++;
-          if (d_decoded_bits == 8) {
-            d_frame_buffer[d_received_bytes++] = d_dec_b;
-            d_decoded_bits = 0;
-
-            /*Check if the frame limit was reached */
-            if (d_received_bytes >= d_max_frame_len) {
-              LOG_DEBUG("Wrong size");
-              reset_state();
-              cont = true;
-              break;
-            }
-          }
-        }
+        i++;
       }
       if (cont) {
         continue;
       }
       d_start_idx = d_bitstream.size();
       return false;
+    }
     default:
       LOG_ERROR("Invalid decoding state");
       reset_state();
@@ -261,6 +336,19 @@ ax25_decoder::~ax25_decoder()
   delete[] d_frame_buffer;
 }
 
+/**
+ * Drops all the buffered bits. This should happen only if the bitstream
+ * is full, without any frame decoded, e.g. due to a very long preamble
+ */
+void
+ax25_decoder::drop_bitstream()
+{
+  LOG_DEBUG("Bitstream overflow");
+  incr_nitems_read(d_bitstream.size());
+  d_bitstream.clear();
+  reset_state();
+}
+
 void
 ax25_decoder::reset_state()
 {
@@ -330,7 +418,7 @@ ax25_decoder::enter_frame_end(decoder_status_t &status)
     return true;
   }
   else {
-    /* Try to correct up to 1-bit*/
+    /* Try to locate and correct the erroneous bits */
     if (error_correction()) {
       metadata::add_decoder(status.data, this);
       metadata::add_pdu(status.data, d_frame_buffer,
@@ -373,88 +461,248 @@ ax25_decoder::decode_1b(uint8_t in)
   d_dec_b = (d_dec_b >> 1) | (in << 7);
 }
 
+/**
+ * Shifts in up to 64 bits at once. Equivalent to calling decode_1b() for
+ * each one of them
+ * @param in the bits. The LS bit is the oldest one
+ * @param nbits the number of bits
+ */
+inline void
+ax25_decoder::decode_nb(uint64_t in, size_t nbits)
+{
+  if (nbits >= 8) {
+    d_shift_reg = (in >> (nbits - 8)) & 0xff;
+    d_dec_b = d_shift_reg;
+  }
+  else {
+    d_shift_reg = (d_shift_reg >> nbits) | (in << (8 - nbits));
+    d_dec_b = (d_dec_b >> nbits) | (in << (8 - nbits));
+  }
+}
+
+/**
+ * Shifts in data bits that do not contain any stuffed bit or flag, storing
+ * every completed byte into the frame buffer
+ * @param in the bits. The LS bit is the oldest one
+ * @param nbits the number of bits
+ * @return true if the maximum frame length was reached. In this case any
+ * remaining bits are not processed
+ */
 bool
-ax25_decoder::is_frame_valid()
+ax25_decoder::decode_data_bits(uint64_t in, size_t nbits)
+{
+  while (nbits) {
+    const size_t n = std::min(8 - d_decoded_bits, nbits);
+    decode_nb(in, n);
+    in >>= n;
+    nbits -= n;
+    d_decoded_bits += n;
+    if (d_decoded_bits == 8) {
+      d_frame_buffer[d_received_bytes++] = d_dec_b;
+      d_decoded_bits = 0;
+      if (d_received_bytes >= d_max_frame_len) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Performs NRZI decoding and, if enabled, G3RUH descrambling on up to 64
+ * bits at once
+ * @param in the raw bits. The LS bit is the oldest one
+ * @param nbits the number of bits (1 to 64)
+ * @return the decoded bits
+ */
+uint64_t
+ax25_decoder::nrzi_descramble(uint64_t in, size_t nbits)
+{
+  const uint64_t mask = nbits < 64 ? (1ULL << nbits) - 1 : ~0ULL;
+  /* A transition stands for 0, no transition for 1 */
+  const uint64_t b = ~(in ^ ((in << 1) | d_prev_bit_nrzi)) & mask;
+  d_prev_bit_nrzi = (in >> (nbits - 1)) & 0x1;
+  if (!d_descramble) {
+    return b;
+  }
+
+  /*
+   * Self-synchronizing descrambler with polynomial 1 + x^12 + x^17. The
+   * register holds the previous 64 descrambler inputs, the most recent at the
+   * MS bit
+   */
+  const uint64_t out = b ^ ((b << 12) | (d_descrambler_reg >> 52))
+                       ^ ((b << 17) | (d_descrambler_reg >> 47));
+  if (nbits < 64) {
+    d_descrambler_reg = (d_descrambler_reg >> nbits) | (b << (64 - nbits));
+  }
+  else {
+    d_descrambler_reg = b;
+  }
+  return out & mask;
+}
+
+/*
+ * The AX.25 FCS is linear. Flipping a bit of a frame changes the FCS
+ * calculated over it by a value that depends only on the distance of that bit
+ * from the end of the frame. The syndrome, i.e the XOR of the calculated and
+ * the received FCS, is therefore enough to locate an erroneous bit.
+ *
+ * Bit positions are counted backwards from the end of the frame. Positions
+ * 0 to 15 correspond to the bits of the received FCS field and the rest to
+ * the frame data, starting from the MS bit of the last data byte.
+ */
+namespace {
+
+class fcs_syndrome_table {
+public:
+  /*
+   * The AX.25 FCS generator has a period of 32767 bits. Up to this length
+   * every single bit error produces a unique syndrome
+   */
+  static const size_t max_bits = 32767;
+
+  static const fcs_syndrome_table &
+  instance()
+  {
+    static const fcs_syndrome_table t;
+    return t;
+  }
+
+  uint16_t
+  syndrome(size_t pos) const
+  {
+    return d_syndromes[pos];
+  }
+
+  /**
+   * @param syndrome the syndrome
+   * @return the position of the single bit error that produces this
+   * syndrome or max_bits if there is none
+   */
+  size_t
+  position(uint16_t syndrome) const
+  {
+    return d_positions[syndrome];
+  }
+
+private:
+  std::vector<uint16_t> d_syndromes;
+  std::vector<uint16_t> d_positions;
+
+  fcs_syndrome_table() :
+    d_syndromes(max_bits),
+    d_positions(1 << 16, max_bits)
+  {
+    for (size_t i = 0; i < 16; i++) {
+      d_syndromes[i] = 1 << i;
+    }
+    /*
+     * Errors on data bits propagate through the reflected CRC register,
+     * shifting in zeros for each of the following bits
+     */
+    uint16_t reg = 0x8408;
+    for (size_t i = 16; i < max_bits; i++) {
+      d_syndromes[i] = reg;
+      reg = (reg & 0x1) ? (reg >> 1) ^ 0x8408 : reg >> 1;
+    }
+    for (size_t i = 0; i < max_bits; i++) {
+      d_positions[d_syndromes[i]] = i;
+    }
+  }
+};
+
+} // namespace
+
+uint16_t
+ax25_decoder::fcs_syndrome()
 {
   uint16_t fcs;
   uint16_t recv_fcs = 0x0;
 
-  /* Check if the frame is correct using the FCS field */
   fcs = ax25::crc(d_frame_buffer, d_received_bytes - sizeof(uint16_t));
   recv_fcs = (((uint16_t) d_frame_buffer[d_received_bytes - 1]) << 8)
              | d_frame_buffer[d_received_bytes - 2];
   LOG_DEBUG("CRC Received: 0x%02x", recv_fcs);
   LOG_DEBUG("CRC Calculated: 0x%02x", fcs);
-  if (fcs == recv_fcs) {
-    return true;
+  return fcs ^ recv_fcs;
+}
+
+bool
+ax25_decoder::is_frame_valid()
+{
+  /* Check if the frame is correct using the FCS field */
+  return fcs_syndrome() == 0;
+}
+
+/**
+ * Toggles a bit of the frame buffer
+ * @param pos the bit position, as indexed by the FCS syndrome table
+ */
+void
+ax25_decoder::flip_bit(size_t pos)
+{
+  if (pos < 16) {
+    d_frame_buffer[d_received_bytes - 2 + pos / 8] ^= 1 << (pos % 8);
+  }
+  else {
+    pos -= 16;
+    d_frame_buffer[d_received_bytes - 3 - pos / 8] ^= 0x80 >> (pos % 8);
   }
-  return false;
 }
 
+/**
+ * Tries to correct the frame using the FCS syndrome. A single bit error is
+ * located directly. For two bit errors, each bit position is tried as the
+ * first error and the second one is located from the remaining syndrome.
+ * Because the FCS cannot distinguish between all possible pairs, the
+ * correction is applied only if exactly one pair matches.
+ *
+ * @return true if the frame was corrected
+ */
 bool
 ax25_decoder::error_correction()
 {
   if (!d_error_correction) {
     return false;
   }
-  for (size_t i = 0; i < d_received_bytes; i++) {
-    /*
-     * Make loop un-roll to simplify the logic for toggling every bit of a
-     * specific byte
-     */
-    d_frame_buffer[i] ^= 0x1;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x1;
-
-    d_frame_buffer[i] ^= 0x2;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x2;
-
-    d_frame_buffer[i] ^= 0x4;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x4;
-
-    d_frame_buffer[i] ^= 0x8;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x8;
-
-    d_frame_buffer[i] ^= 0x10;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x10;
-
-    d_frame_buffer[i] ^= 0x20;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x20;
+  const fcs_syndrome_table &t = fcs_syndrome_table::instance();
+  const size_t nbits = d_received_bytes * 8;
+  if (nbits > fcs_syndrome_table::max_bits) {
+    return false;
+  }
 
-    d_frame_buffer[i] ^= 0x40;
-    if (is_frame_valid()) {
-      return true;
-    }
-    d_frame_buffer[i] ^= 0x40;
+  const uint16_t s = fcs_syndrome();
+  const size_t pos = t.position(s);
+  if (pos < nbits) {
+    flip_bit(pos);
+    return true;
+  }
+  if (d_max_error_bits < 2) {
+    return false;
+  }
 
-    d_frame_buffer[i] ^= 0x80;
-    if (is_frame_valid()) {
-      return true;
+  size_t pos0 = nbits;
+  size_t pos1 = nbits;
+  for (size_t i = 0; i < nbits; i++) {
+    const size_t j = t.position(s ^ t.syndrome(i));
+    if (j > i && j < nbits) {
+      if (pos0 < nbits) {
+        LOG_DEBUG("Ambiguous 2-bit error");
+        return false;
+      }
+      pos0 = i;
+      pos1 = j;
     }
-    d_frame_buffer[i] ^= 0x80;
+  }
+  if (pos0 < nbits) {
+    flip_bit(pos0);
+    flip_bit(pos1);
+    return true;
   }
   return false;
 }
 
-
-
 } /* namespace satnogs */
 } /* namespace gr */
 
@@ -0,0 +1,166 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <satnogs/bitstream.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace gr {
+namespace satnogs {
+
+static size_t
+round_capacity(size_t capacity)
+{
+  /* Power of two capacity, so wrapping around is a single mask operation */
+  size_t c = 64;
+  while (c < capacity) {
+    c <<= 1;
+  }
+  return c;
+}
+
+/**
+ * Creates a new bitstream
+ * @param capacity the minimum number of bits that the bitstream should be
+ * able to hold. The actual capacity is rounded up to the next power of two.
+ */
+bitstream::bitstream(size_t capacity) :
+  d_capacity(round_capacity(capacity)),
+  d_mask(d_capacity - 1),
+  d_word_mask(d_capacity / 64 - 1),
+  d_words(d_capacity / 64, 0),
+  d_head(0),
+  d_size(0)
+{
+  if (capacity == 0) {
+    throw std::invalid_argument("bitstream: Invalid capacity");
+  }
+}
+
+bitstream::~bitstream()
+{
+}
+
+/**
+ *
+ * @return the maximum number of bits that the bitstream can hold
+ */
+size_t
+bitstream::capacity() const
+{
+  return d_capacity;
+}
+
+/**
+ *
+ * @return the number of bits currently stored
+ */
+size_t
+bitstream::size() const
+{
+  return d_size;
+}
+
+/**
+ *
+ * @return the number of bits that can be appended before the bitstream
+ * becomes full
+ */
+size_t
+bitstream::space() const
+{
+  return d_capacity - d_size;
+}
+
+bool
+bitstream::empty() const
+{
+  return d_size == 0;
+}
+
+bool
+bitstream::full() const
+{
+  return d_size == d_capacity;
+}
+
+/**
+ * Removes all the bits
+ */
+void
+bitstream::clear()
+{
+  d_head = 0;
+  d_size = 0;
+}
+
+/**
+ * Removes bits from the front of the bitstream
+ * @param nbits the number of bits to remove. If it is larger than the
+ * size of the bitstream, the bitstream is cleared
+ */
+void
+bitstream::consume(size_t nbits)
+{
+  if (nbits >= d_size) {
+    clear();
+    return;
+  }
+  d_head = (d_head + nbits) & d_mask;
+  d_size -= nbits;
+}
+
+/**
+ * Appends bits at the back of the bitstream
+ * @param in unpacked bits. Each byte should contain one bit at the LS position
+ * @param len the number of bits
+ * @return the number of bits appended. This may be less than len, if the
+ * available space was not enough.
+ */
+size_t
+bitstream::push_back(const uint8_t *in, size_t len)
+{
+  const size_t n = std::min(len, space());
+  size_t i = 0;
+
+  /* Fill bit-by-bit until the write position is word aligned */
+  while (i < n && ((d_head + d_size) & 63)) {
+    push_back(in[i++]);
+  }
+
+  /* Pack full words at once */
+  while (n - i >= 64) {
+    d_words[((d_head + d_size) & d_mask) >> 6] = pack(in + i, 64);
+    d_size += 64;
+    i += 64;
+  }
+
+  while (i < n) {
+    push_back(in[i++]);
+  }
+  return n;
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
@@ -0,0 +1,225 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <satnogs/chirp_rotator.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+
+namespace gr {
+namespace satnogs {
+
+const size_t chirp_rotator::max_coeffs;
+
+/**
+ * Creates a rotator with zero initial phase
+ */
+chirp_rotator::chirp_rotator() :
+  d_phase(0.0)
+{
+  setup_lanes(nullptr);
+}
+
+/**
+ * Resets the phase of the rotator
+ * @param phase the new phase in radians
+ */
+void
+chirp_rotator::reset(double phase)
+{
+  d_phase = std::remainder(phase, 2 * M_PI);
+}
+
+/**
+ *
+ * @return the phase in radians that will be applied to the next sample
+ */
+double
+chirp_rotator::phase() const
+{
+  return d_phase;
+}
+
+/**
+ * Rewrites in place the coefficients of the polynomial p(x) so that they
+ * describe the polynomial q(x) = p(x0 + x)
+ * @param coeffs the coefficients of the polynomial, starting from the
+ * constant term
+ * @param ncoeffs the number of coefficients
+ * @param x0 the shift
+ */
+void
+chirp_rotator::shift_polynomial(double *coeffs, size_t ncoeffs, double x0)
+{
+  for (size_t i = 1; i < ncoeffs; i++) {
+    for (size_t j = ncoeffs - 1; j >= i; j--) {
+      coeffs[j - 1] += x0 * coeffs[j];
+    }
+  }
+}
+
+/**
+ * Rotates the input samples by the phase of the chirp.
+ *
+ * @param out the output buffer. It can be the same as the input
+ * @param in the input buffer
+ * @param len the number of samples
+ * @param freq the coefficients of the angular frequency polynomial in
+ * radians per sample, starting from the constant term. The variable of the
+ * polynomial is the sample index relative to the first sample of \p in.
+ * @param ncoeffs the number of the coefficients. At most
+ * chirp_rotator::max_coeffs are supported
+ */
+void
+chirp_rotator::rotate(gr_complex *out, const gr_complex *in, size_t len,
+                      const double *freq, size_t ncoeffs)
+{
+  if (ncoeffs > max_coeffs) {
+    throw std::invalid_argument("chirp_rotator: too many coefficients");
+  }
+  double a[max_coeffs] = {0.0};
+  std::copy(freq, freq + ncoeffs, a);
+
+  size_t done = 0;
+  while (done < len) {
+    const size_t n = std::min(block_len, len - done);
+    /*
+     * The phase is the integral of the frequency. Inside the block the
+     * quartic term is dropped. Its contribution over a block is negligible
+     * for any realistic Doppler curve, and the exact phase is restored at
+     * the start of the next block anyway.
+     */
+    const double p[4] = {0.0, a[0], a[1] / 2, a[2] / 3};
+    setup_lanes(p);
+    rotate_block(out + done, in + done, n);
+
+    const double x = n;
+    d_phase = std::remainder(
+                d_phase + (((a[3] / 4 * x + a[2] / 3) * x + a[1] / 2) * x + a[0]) * x,
+                2 * M_PI);
+    shift_polynomial(a, max_coeffs, x);
+    done += n;
+  }
+}
+
+/*
+ * Initializes the rotator of each lane and its multiplicative forward
+ * differences for the cubic phase polynomial p, with a step equal to the
+ * number of lanes. The phase of the first lanes is generated by a double
+ * precision rotator, so only a few sincos evaluations are needed per block.
+ */
+void
+chirp_rotator::setup_lanes(const double *p)
+{
+  typedef std::complex<double> cd;
+  const double p1 = p ? p[1] : 0.0;
+  const double p2 = p ? p[2] : 0.0;
+  const double p3 = p ? p[3] : 0.0;
+
+  cd r = std::polar(1.0, d_phase);
+  cd w = std::polar(1.0, p1 + p2 + p3);
+  cd v = std::polar(1.0, 2 * p2 + 6 * p3);
+  const cd u = std::polar(1.0, 6 * p3);
+  cd seq[3 * lanes];
+  for (size_t i = 0; i < 3 * lanes; i++) {
+    seq[i] = r;
+    r *= w;
+    w *= v;
+    v *= u;
+  }
+
+  for (size_t k = 0; k < lanes; k++) {
+    const cd lr = seq[k];
+    const cd lw = seq[k + lanes] * std::conj(seq[k]);
+    const cd lv = seq[k + 2 * lanes] * std::conj(seq[k + lanes])
+                  * std::conj(seq[k + lanes]) * seq[k];
+    d_r[0][k] = lr.real();
+    d_r[1][k] = lr.imag();
+    d_w[0][k] = lw.real();
+    d_w[1][k] = lw.imag();
+    d_v[0][k] = lv.real();
+    d_v[1][k] = lv.imag();
+  }
+  const double l = lanes;
+  const cd lu = std::polar(1.0, 6 * p3 * l * l * l);
+  d_u[0] = lu.real();
+  d_u[1] = lu.imag();
+}
+
+/*
+ * The loops below operate on split real and imaginary arrays of the lane
+ * width and have no branches, so that the compiler vectorizes them
+ */
+void
+chirp_rotator::rotate_block(gr_complex *out, const gr_complex *in,
+                            size_t len)
+{
+  const float *x = reinterpret_cast<const float *>(in);
+  float *y = reinterpret_cast<float *>(out);
+  float rr[lanes], ri[lanes], wr[lanes], wi[lanes], vr[lanes], vi[lanes];
+  std::copy(d_r[0], d_r[0] + lanes, rr);
+  std::copy(d_r[1], d_r[1] + lanes, ri);
+  std::copy(d_w[0], d_w[0] + lanes, wr);
+  std::copy(d_w[1], d_w[1] + lanes, wi);
+  std::copy(d_v[0], d_v[0] + lanes, vr);
+  std::copy(d_v[1], d_v[1] + lanes, vi);
+  const float ur = d_u[0];
+  const float ui = d_u[1];
+
+  size_t i = 0;
+  for (; i + lanes <= len; i += lanes) {
+    for (size_t k = 0; k < lanes; k++) {
+      const float xr = x[2 * (i + k)];
+      const float xi = x[2 * (i + k) + 1];
+      y[2 * (i + k)] = xr * rr[k] - xi * ri[k];
+      y[2 * (i + k) + 1] = xr * ri[k] + xi * rr[k];
+    }
+    for (size_t k = 0; k < lanes; k++) {
+      const float tr = rr[k] * wr[k] - ri[k] * wi[k];
+      const float ti = rr[k] * wi[k] + ri[k] * wr[k];
+      const float sr = wr[k] * vr[k] - wi[k] * vi[k];
+      const float si = wr[k] * vi[k] + wi[k] * vr[k];
+      const float qr = vr[k] * ur - vi[k] * ui;
+      const float qi = vr[k] * ui + vi[k] * ur;
+      rr[k] = tr;
+      ri[k] = ti;
+      wr[k] = sr;
+      wi[k] = si;
+      vr[k] = qr;
+      vi[k] = qi;
+    }
+  }
+
+  for (size_t k = 0; i + k < len; k++) {
+    const float xr = x[2 * (i + k)];
+    const float xi = x[2 * (i + k) + 1];
+    y[2 * (i + k)] = xr * rr[k] - xi * ri[k];
+    y[2 * (i + k) + 1] = xr * ri[k] + xi * rr[k];
+  }
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
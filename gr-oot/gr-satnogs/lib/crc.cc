@@ -26,190 +26,382 @@
 #include <satnogs/crc.h>
 #include <cstring>
 #include <arpa/inet.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
 
 namespace gr {
 namespace satnogs {
 
 
-const uint16_t crc::crc16_ccitt_table_reverse[256] = {
-  0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF, 0x8C48,
-  0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7, 0x1081, 0x0108,
-  0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E, 0x9CC9, 0x8D40, 0xBFDB,
-  0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876, 0x2102, 0x308B, 0x0210, 0x1399,
-  0x6726, 0x76AF, 0x4434, 0x55BD, 0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E,
-  0xFAE7, 0xC87C, 0xD9F5, 0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E,
-  0x54B5, 0x453C, 0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD,
-  0xC974, 0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
-  0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3, 0x5285,
-  0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A, 0xDECD, 0xCF44,
-  0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72, 0x6306, 0x728F, 0x4014,
-  0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9, 0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5,
-  0xA96A, 0xB8E3, 0x8A78, 0x9BF1, 0x7387, 0x620E, 0x5095, 0x411C, 0x35A3,
-  0x242A, 0x16B1, 0x0738, 0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862,
-  0x9AF9, 0x8B70, 0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E,
-  0xF0B7, 0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
-  0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036, 0x18C1,
-  0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E, 0xA50A, 0xB483,
-  0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5, 0x2942, 0x38CB, 0x0A50,
-  0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD, 0xB58B, 0xA402, 0x9699, 0x8710,
-  0xF3AF, 0xE226, 0xD0BD, 0xC134, 0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7,
-  0x6E6E, 0x5CF5, 0x4D7C, 0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1,
-  0xA33A, 0xB2B3, 0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72,
-  0x3EFB, 0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
-  0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A, 0xE70E,
-  0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1, 0x6B46, 0x7ACF,
-  0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9, 0xF78F, 0xE606, 0xD49D,
-  0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330, 0x7BC7, 0x6A4E, 0x58D5, 0x495C,
-  0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
-};
-
-const uint16_t crc::crc16_ccitt_table[256] = {
-  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108,
-  0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF, 0x1231, 0x0210,
-  0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6, 0x9339, 0x8318, 0xB37B,
-  0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE, 0x2462, 0x3443, 0x0420, 0x1401,
-  0x64E6, 0x74C7, 0x44A4, 0x5485, 0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE,
-  0xF5CF, 0xC5AC, 0xD58D, 0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6,
-  0x5695, 0x46B4, 0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D,
-  0xC7BC, 0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
-  0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B, 0x5AF5,
-  0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12, 0xDBFD, 0xCBDC,
-  0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A, 0x6CA6, 0x7C87, 0x4CE4,
-  0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41, 0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD,
-  0xAD2A, 0xBD0B, 0x8D68, 0x9D49, 0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13,
-  0x2E32, 0x1E51, 0x0E70, 0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A,
-  0x9F59, 0x8F78, 0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E,
-  0xE16F, 0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
-  0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E, 0x02B1,
-  0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256, 0xB5EA, 0xA5CB,
-  0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D, 0x34E2, 0x24C3, 0x14A0,
-  0x0481, 0x7466, 0x6447, 0x5424, 0x4405, 0xA7DB, 0xB7FA, 0x8799, 0x97B8,
-  0xE75F, 0xF77E, 0xC71D, 0xD73C, 0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657,
-  0x7676, 0x4615, 0x5634, 0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9,
-  0xB98A, 0xA9AB, 0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882,
-  0x28A3, 0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
-  0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92, 0xFD2E,
-  0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9, 0x7C26, 0x6C07,
-  0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1, 0xEF1F, 0xFF3E, 0xCF5D,
-  0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8, 0x6E17, 0x7E36, 0x4E55, 0x5E74,
-  0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
-};
+namespace {
 
 /*
- * Slicing-by-8 software
+ * Table driven CRC engine of up to 32 bits, using the slicing-by-8 method.
+ * Polynomials of reflected CRCs are given in their reversed form.
  *
- * The following CRC lookup table was generated automagically
- * using the following model parameters:
- *
- * Generator Polynomial = ................. 0x1EDC6F41
- * Generator Polynomial Length = .......... 32 bits
- * Reflected Bits = ....................... TRUE
- * Table Generation Offset = .............. 32 bits
- * Number of Slices = ..................... 8 slices
- * Slice Lengths = ........................ 8 8 8 8 8 8 8 8
- * Directory Name = ....................... .\
- * File Name = ............................ 8x256_tables.c
+ * On x86-64 CPUs with PCLMULQDQ, buffers of at least 32 bytes are first
+ * folded with carry-less multiplications, 64 bytes at a time for long
+ * buffers and 16 bytes at a time otherwise, down to a single 16 byte block
+ * that has the same remainder. The tables then process
+ * this block and the remaining tail bytes.
  */
+class crc_engine {
+public:
+  crc_engine(size_t width, uint32_t poly, bool reflected);
+
+  uint32_t
+  update(uint32_t reg, const uint8_t *data, size_t len) const;
+
+private:
+  const size_t    d_width;
+  const uint32_t  d_mask;
+  const bool      d_reflected;
+  uint32_t        d_table[8][256];
+  /*
+   * Folding constants for the high and the low 64-bit half of a block,
+   * for a distance of one and of four blocks
+   */
+  uint64_t        d_fold1_hi;
+  uint64_t        d_fold1_lo;
+  uint64_t        d_fold4_hi;
+  uint64_t        d_fold4_lo;
+
+  uint32_t
+  update_table(uint32_t reg, const uint8_t *data, size_t len) const;
 
-const uint32_t crc::crc32_c_table[256] = {
-  0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
-  0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B, 0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
-  0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
-  0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
-  0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A, 0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
-  0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
-  0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
-  0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A, 0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
-  0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
-  0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
-  0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927, 0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
-  0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
-  0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
-  0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859, 0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
-  0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
-  0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
-  0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C, 0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
-  0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
-  0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
-  0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C, 0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
-  0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
-  0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
-  0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D, 0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
-  0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
-  0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
-  0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF, 0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
-  0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
-  0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
-  0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE, 0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
-  0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
-  0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
-  0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E, 0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+#if defined(__x86_64__) && defined(__GNUC__)
+  __attribute__((target("pclmul,ssse3")))
+  uint32_t
+  update_clmul(uint32_t reg, const uint8_t *data, size_t len) const;
+#endif
 };
 
-uint16_t
-crc::crc16_ccitt_reversed(const uint8_t *data, size_t len)
+static uint64_t
+load_le64(const uint8_t *in)
 {
-  uint16_t crc = 0xFFFF;
-  for (size_t i = 0; i < len; i++) {
-    crc = (crc >> 8) ^ crc16_ccitt_table_reverse[(crc ^ data[i]) & 0xff];
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; i++) {
+    v |= static_cast<uint64_t>(in[i]) << (8 * i);
   }
-  return crc ^ 0xFFFF;
+  return v;
 }
 
-uint16_t
-crc::crc16_ccitt(const uint8_t *data, size_t len)
+static uint64_t
+load_be64(const uint8_t *in)
 {
-  uint16_t crc = 0;
-  while (len-- != 0) {
-    crc = crc16_ccitt_table[((crc >> 8) ^ *data++) & 0xff] ^ (crc << 8);
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; i++) {
+    v = (v << 8) | in[i];
   }
-  return crc;
+  return v;
 }
 
-uint16_t
-crc::crc16_aug_ccitt(const uint8_t *data, size_t len)
+static uint64_t
+reverse_bits(uint64_t v, size_t n)
 {
-  uint16_t crc = 0x1D0F;
-  while (len-- != 0) {
-    crc = crc16_ccitt_table[((crc >> 8) ^ *data++) & 0xff] ^ (crc << 8);
+  uint64_t r = 0;
+  for (size_t i = 0; i < n; i++) {
+    r = (r << 1) | ((v >> i) & 1);
   }
-  return crc ^ 0xFFFF;
+  return r;
 }
 
-uint16_t
-crc::crc16_ax25(const uint8_t *data, size_t len)
+/*
+ * Computes x^n mod P, where the polynomial P is given in normal form
+ * without its leading term
+ */
+static uint64_t
+xpow_mod(size_t n, uint32_t poly, size_t width)
 {
-  uint16_t fcs = 0xFFFF;
-  while (len--) {
-    fcs = (fcs >> 8) ^ crc16_ccitt_table_reverse[(fcs ^ *data++) & 0xFF];
+  const uint64_t p = (1ULL << width) | poly;
+  uint64_t r = 1;
+  for (size_t i = 0; i < n; i++) {
+    r <<= 1;
+    if (r & (1ULL << width)) {
+      r ^= p;
+    }
   }
-  return fcs ^ 0xFFFF;
+  return r;
 }
 
-static uint16_t
-update_crc16_ibm(uint8_t crc, uint16_t reg)
+crc_engine::crc_engine(size_t width, uint32_t poly, bool reflected) :
+  d_width(width),
+  d_mask(width == 32 ? 0xFFFFFFFF : (1U << width) - 1),
+  d_reflected(reflected),
+  d_fold1_hi(0),
+  d_fold1_lo(0),
+  d_fold4_hi(0),
+  d_fold4_lo(0)
 {
-  const uint16_t crc_poly = 0x8005;
-  for (size_t i = 0; i < 8; i++) {
-    if (((reg & 0x8000) >> 8) ^ (crc & 0x80)) {
-      reg = (reg << 1) ^ crc_poly;
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t c;
+    if (reflected) {
+      c = b;
+      for (size_t i = 0; i < 8; i++) {
+        c = (c & 1) ? (c >> 1) ^ poly : c >> 1;
+      }
     }
     else {
-      reg = (reg << 1);
+      c = b << (width - 8);
+      for (size_t i = 0; i < 8; i++) {
+        c = (c & (1U << (width - 1))) ? (c << 1) ^ poly : c << 1;
+      }
+    }
+    d_table[0][b] = c & d_mask;
+  }
+  for (size_t k = 1; k < 8; k++) {
+    for (size_t b = 0; b < 256; b++) {
+      const uint32_t c = d_table[k - 1][b];
+      if (reflected) {
+        d_table[k][b] = (c >> 8) ^ d_table[0][c & 0xFF];
+      }
+      else {
+        d_table[k][b] = ((c << 8) ^ d_table[0][c >> (width - 8)]) & d_mask;
+      }
+    }
+  }
+
+  /*
+   * Folding a block over a distance of D bits multiplies its high half by
+   * x^(D + 64) and its low half by x^D. In the reflected domain the
+   * carry-less product of two reflected operands lacks a factor of x, so
+   * the exponents are reduced by one.
+   */
+  if (reflected) {
+    const uint32_t p = reverse_bits(poly, width);
+    d_fold1_lo = reverse_bits(xpow_mod(128 + 63, p, width), 64);
+    d_fold1_hi = reverse_bits(xpow_mod(128 - 1, p, width), 64);
+    d_fold4_lo = reverse_bits(xpow_mod(512 + 63, p, width), 64);
+    d_fold4_hi = reverse_bits(xpow_mod(512 - 1, p, width), 64);
+  }
+  else {
+    d_fold1_hi = xpow_mod(128 + 64, poly, width);
+    d_fold1_lo = xpow_mod(128, poly, width);
+    d_fold4_hi = xpow_mod(512 + 64, poly, width);
+    d_fold4_lo = xpow_mod(512, poly, width);
+  }
+}
+
+uint32_t
+crc_engine::update_table(uint32_t reg, const uint8_t *data, size_t len) const
+{
+  if (d_reflected) {
+    while (len >= 8) {
+      const uint64_t v = load_le64(data) ^ reg;
+      reg = d_table[7][v & 0xFF] ^ d_table[6][(v >> 8) & 0xFF]
+            ^ d_table[5][(v >> 16) & 0xFF] ^ d_table[4][(v >> 24) & 0xFF]
+            ^ d_table[3][(v >> 32) & 0xFF] ^ d_table[2][(v >> 40) & 0xFF]
+            ^ d_table[1][(v >> 48) & 0xFF] ^ d_table[0][v >> 56];
+      data += 8;
+      len -= 8;
+    }
+    while (len--) {
+      reg = (reg >> 8) ^ d_table[0][(reg ^ *data++) & 0xFF];
+    }
+    return reg;
+  }
+
+  while (len >= 8) {
+    const uint64_t v = load_be64(data)
+                       ^ (static_cast<uint64_t>(reg) << (64 - d_width));
+    reg = d_table[7][v >> 56] ^ d_table[6][(v >> 48) & 0xFF]
+          ^ d_table[5][(v >> 40) & 0xFF] ^ d_table[4][(v >> 32) & 0xFF]
+          ^ d_table[3][(v >> 24) & 0xFF] ^ d_table[2][(v >> 16) & 0xFF]
+          ^ d_table[1][(v >> 8) & 0xFF] ^ d_table[0][v & 0xFF];
+    data += 8;
+    len -= 8;
+  }
+  while (len--) {
+    reg = ((reg << 8) ^ d_table[0][((reg >> (d_width - 8)) ^ *data++) & 0xFF])
+          & d_mask;
+  }
+  return reg;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+static bool
+have_pclmul()
+{
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+  }();
+  return supported;
+}
+
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i
+load(const uint8_t *p, bool reflected, __m128i swap)
+{
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  return reflected ? b : _mm_shuffle_epi8(b, swap);
+}
+
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i
+fold(__m128i x, __m128i k, __m128i b)
+{
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11),
+                                     _mm_clmulepi64_si128(x, k, 0x00)), b);
+}
+
+__attribute__((target("pclmul,ssse3")))
+uint32_t
+crc_engine::update_clmul(uint32_t reg, const uint8_t *data, size_t len) const
+{
+  /*
+   * In the normal domain the blocks are byte swapped, so the first byte
+   * becomes the most significant of the high half. In the reflected domain
+   * the first byte is already the least significant of the low half.
+   */
+  const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                    12, 13, 14, 15);
+
+  /*
+   * The register is XOR-ed to the first bytes of the message, so the
+   * folded block is processed with a zero register
+   */
+  const __m128i init = d_reflected ? _mm_cvtsi32_si128(reg)
+                       : _mm_set_epi64x(static_cast<uint64_t>(reg)
+                                        << (64 - d_width), 0);
+  const __m128i k1 = _mm_set_epi64x(d_fold1_hi, d_fold1_lo);
+  __m128i x = _mm_xor_si128(load(data, d_reflected, swap), init);
+  data += 16;
+  len -= 16;
+
+  /* Four independent folds hide the latency of the multiplications */
+  if (len >= 112) {
+    const __m128i k4 = _mm_set_epi64x(d_fold4_hi, d_fold4_lo);
+    __m128i x1 = load(data, d_reflected, swap);
+    __m128i x2 = load(data + 16, d_reflected, swap);
+    __m128i x3 = load(data + 32, d_reflected, swap);
+    data += 48;
+    len -= 48;
+    while (len >= 64) {
+      x = fold(x, k4, load(data, d_reflected, swap));
+      x1 = fold(x1, k4, load(data + 16, d_reflected, swap));
+      x2 = fold(x2, k4, load(data + 32, d_reflected, swap));
+      x3 = fold(x3, k4, load(data + 48, d_reflected, swap));
+      data += 64;
+      len -= 64;
     }
-    crc <<= 1;
+    x = fold(x, k1, x1);
+    x = fold(x, k1, x2);
+    x = fold(x, k1, x3);
+  }
+
+  while (len >= 16) {
+    x = fold(x, k1, load(data, d_reflected, swap));
+    data += 16;
+    len -= 16;
+  }
+
+  uint8_t block[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(block),
+                   d_reflected ? x : _mm_shuffle_epi8(x, swap));
+  reg = update_table(0, block, 16);
+  return update_table(reg, data, len);
+}
+#endif
+
+/**
+ * Updates the CRC register
+ * @param reg the current value of the register
+ * @param data the input buffer
+ * @param len the size of the input buffer in bytes
+ * @return the new value of the register
+ */
+uint32_t
+crc_engine::update(uint32_t reg, const uint8_t *data, size_t len) const
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (len >= 32 && have_pclmul()) {
+    return update_clmul(reg, data, len);
+  }
+#endif
+  return update_table(reg, data, len);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("sse4.2")))
+static uint32_t
+crc32_c_sse42(uint32_t reg, const uint8_t *data, size_t len)
+{
+  uint64_t r = reg;
+  while (len >= 8) {
+    uint64_t v;
+    memcpy(&v, data, sizeof(v));
+    r = _mm_crc32_u64(r, v);
+    data += 8;
+    len -= 8;
+  }
+  reg = r;
+  while (len--) {
+    reg = _mm_crc32_u8(reg, *data++);
   }
   return reg;
 }
+#endif
+
+static const crc_engine &
+crc16_ccitt_engine()
+{
+  static const crc_engine e(16, 0x1021, false);
+  return e;
+}
+
+static const crc_engine &
+crc16_ccitt_reversed_engine()
+{
+  static const crc_engine e(16, 0x8408, true);
+  return e;
+}
+
+static const crc_engine &
+crc16_ibm_engine()
+{
+  static const crc_engine e(16, 0x8005, false);
+  return e;
+}
+
+static const crc_engine &
+crc32_c_engine()
+{
+  static const crc_engine e(32, 0x82F63B78, true);
+  return e;
+}
+
+} // namespace
+
+uint16_t
+crc::crc16_ccitt_reversed(const uint8_t *data, size_t len)
+{
+  return crc16_ccitt_reversed_engine().update(0xFFFF, data, len) ^ 0xFFFF;
+}
+
+uint16_t
+crc::crc16_ccitt(const uint8_t *data, size_t len)
+{
+  return crc16_ccitt_engine().update(0, data, len);
+}
+
+uint16_t
+crc::crc16_aug_ccitt(const uint8_t *data, size_t len)
+{
+  return crc16_ccitt_engine().update(0x1D0F, data, len) ^ 0xFFFF;
+}
+
+uint16_t
+crc::crc16_ax25(const uint8_t *data, size_t len)
+{
+  return crc16_ccitt_reversed_engine().update(0xFFFF, data, len) ^ 0xFFFF;
+}
 
 uint16_t
 crc::crc16_ibm(const uint8_t *data, size_t len)
 {
-  uint16_t crc = 0xFFFF;
-  for (size_t i = 0; i < len; i++) {
-    crc = update_crc16_ibm(data[i], crc);
-  }
-  return crc;
+  return crc16_ibm_engine().update(0xFFFF, data, len);
 }
 
 /**
@@ -239,11 +431,16 @@ crc::crc_size(crc_t t)
 uint32_t
 crc::crc32_c(const uint8_t *data, size_t len)
 {
-  uint32_t crc = 0xFFFFFFFF;
-  for (size_t i = 0; i < len; i++) {
-    crc = (crc >> 8) ^ crc::crc32_c_table[(crc ^ data[i]) & 0xff];
+#if defined(__x86_64__) && defined(__GNUC__)
+  static const bool sse42 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+  }();
+  if (sse42) {
+    return crc32_c_sse42(0xFFFFFFFF, data, len) ^ 0xFFFFFFFF;
   }
-  return crc ^ 0xFFFFFFFF;
+#endif
+  return crc32_c_engine().update(0xFFFFFFFF, data, len) ^ 0xFFFFFFFF;
 }
 
 /**
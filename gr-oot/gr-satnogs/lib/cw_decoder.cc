@@ -84,11 +84,13 @@ cw_decoder::cw_decoder(double samp_rate, int fft_len, int overlapping,
   }
 
   d_fft = new gr::fft::fft_complex(fft_len, true, 1);
-  d_tmp_buf = (gr_complex *)volk_malloc(fft_len * sizeof(gr_complex),
-                                        volk_get_alignment());
-  if (!d_tmp_buf) {
+  d_hist = (gr_complex *)volk_malloc(std::max(overlapping, 1)
+                                     * sizeof(gr_complex),
+                                     volk_get_alignment());
+  if (!d_hist) {
     throw std::runtime_error("cw_decoder: could not allocate aligned memory");
   }
+  std::fill(d_hist, d_hist + overlapping, gr_complex(0.0, 0.0));
   d_psd = (float *)volk_malloc(fft_len * sizeof(float),
                                volk_get_alignment());
   if (!d_psd) {
@@ -123,7 +125,7 @@ cw_decoder::cw_decoder(double samp_rate, int fft_len, int overlapping,
 
 cw_decoder::~cw_decoder()
 {
-  volk_free(d_tmp_buf);
+  volk_free(d_hist);
   volk_free(d_psd);
   volk_free(d_nf_buf);
   delete d_fft;
@@ -140,17 +142,19 @@ cw_decoder::decode(const void *in, int len)
 
   const int fft_frames = len / d_new_samples;
   for (int i = 0; i < fft_frames; i++) {
-    memcpy(d_tmp_buf, d_fft->get_inbuf() + d_new_samples,
-           d_overlapping * sizeof(gr_complex));
-    memcpy(d_tmp_buf + d_overlapping,
-           input + i * d_new_samples, d_new_samples * sizeof(gr_complex));
-    memcpy(d_fft->get_inbuf(), d_tmp_buf, d_fft_len * sizeof(gr_complex));
+    fill_window(input, i * d_new_samples - d_overlapping);
     d_fft->execute();
-    /* Log scale is not a requirement, but let's start with something familiar */
-    volk_32fc_s32f_x2_power_spectral_density_32f(d_psd, d_fft->get_outbuf(),
-        d_fft_len, 1.0, d_fft_len);
-    /*FFT shift */
-    std::rotate(d_psd, d_psd + d_shift_len, d_psd + d_fft_len);
+    /*
+     * Log scale is not a requirement, but let's start with something familiar.
+     * The FFT shift is performed by writing the two halves of the spectrum
+     * at their final position
+     */
+    volk_32fc_s32f_x2_power_spectral_density_32f(d_psd,
+        d_fft->get_outbuf() + d_shift_len,
+        d_fft_len, 1.0, d_fft_len - d_shift_len);
+    volk_32fc_s32f_x2_power_spectral_density_32f(
+      d_psd + d_fft_len - d_shift_len, d_fft->get_outbuf(),
+      d_fft_len, 1.0, d_shift_len);
     /* Drop the first samples that will probably pollute our NF estimation */
     if (d_dirty_samples > 0) {
       d_dirty_samples -= d_new_samples;
@@ -160,24 +164,56 @@ cw_decoder::decode(const void *in, int len)
       d_nf_est_remaining -= d_new_samples;
     }
     else {
-      process_psd();
+      process_psd(status);
     }
   }
-  /*
-   * Check if any decoded frames exist. As multiple windows may produce
-   * frames at the same time, propagate them in a serial way,
-   * just to keep compatibility with the decoder API
-   */
-  if (d_frames.size() > 0) {
-    status = d_frames.front();
-    d_frames.pop_front();
-  }
   status.consumed = fft_frames * d_new_samples;
+
+  /* Keep the overlapping samples for the next call */
+  const int consumed = status.consumed;
+  if (consumed >= d_overlapping) {
+    memcpy(d_hist, input + consumed - d_overlapping,
+           d_overlapping * sizeof(gr_complex));
+  }
+  else {
+    memmove(d_hist, d_hist + consumed,
+            (d_overlapping - consumed) * sizeof(gr_complex));
+    memcpy(d_hist + d_overlapping - consumed, input,
+           consumed * sizeof(gr_complex));
+  }
   return status;
 }
 
+/**
+ * Copies a window of the signal to the FFT input buffer. Each sample is
+ * copied only once per FFT, directly from the input if the window lies
+ * entirely on it. Otherwise the start of the window is taken from the
+ * samples kept from the previous call.
+ *
+ * @param input the input samples of the current call
+ * @param start the index of the first sample of the window, relative to
+ * the input. Negative values refer to the samples of the previous call
+ */
+void
+cw_decoder::fill_window(const gr_complex *input, int start)
+{
+  gr_complex *out = d_fft->get_inbuf();
+  if (start >= 0) {
+    memcpy(out, input + start, d_fft_len * sizeof(gr_complex));
+    return;
+  }
+  memcpy(out, d_hist + d_overlapping + start, -start * sizeof(gr_complex));
+  memcpy(out - start, input, (d_fft_len + start) * sizeof(gr_complex));
+}
+
+/**
+ * Feeds the per channel decoders with the current PSD.
+ * As multiple channels may produce frames at the same time, all of them are
+ * appended to the frames of the @a status
+ * @param status the status of the current decode() call
+ */
 void
-cw_decoder::process_psd()
+cw_decoder::process_psd(decoder_status_t &status)
 {
   bool trigger = false;
   for (int win_i = 0; win_i < d_channels_num; win_i++) {
@@ -190,7 +226,7 @@ cw_decoder::process_psd()
                                  i]);
         if (d.decode_success) {
           metadata::add_decoder(d.data, this);
-          d_frames.push_back(d);
+          status.frames.push_back(d.data);
         }
         trigger = true;
         break;
@@ -200,7 +236,7 @@ cw_decoder::process_psd()
       decoder_status_t d = d_decoders[win_i]->decode(0.0f, 0.0f);
       if (d.decode_success) {
         metadata::add_decoder(d.data, this);
-        d_frames.push_back(d);
+        status.frames.push_back(d.data);
       }
     }
   }
@@ -34,12 +34,14 @@ doppler_correction_cc::sptr
 doppler_correction_cc::make(double target_freq,
                             double offset,
                             double sampling_rate,
-                            size_t corrections_per_sec)
+                            size_t corrections_per_sec,
+                            bool chirp)
 {
   return gnuradio::get_initial_sptr(
            new doppler_correction_cc_impl(target_freq, offset,
                                           sampling_rate,
-                                          corrections_per_sec));
+                                          corrections_per_sec,
+                                          chirp));
 }
 
 /*
@@ -49,7 +51,8 @@ doppler_correction_cc_impl::doppler_correction_cc_impl(
   double target_freq,
   double offset,
   double sampling_rate,
-  size_t corrections_per_sec) :
+  size_t corrections_per_sec,
+  bool chirp) :
   gr::sync_block("doppler_correction_cc",
                  gr::io_signature::make(1, 1, sizeof(gr_complex)),
                  gr::io_signature::make(1, 1, sizeof(gr_complex))),
@@ -57,28 +60,26 @@ doppler_correction_cc_impl::doppler_correction_cc_impl(
   d_offset(offset),
   d_samp_rate(sampling_rate),
   d_update_period(sampling_rate / corrections_per_sec),
-  d_est_thrhld(7),
   d_corrections_per_sec(corrections_per_sec),
+  d_chirp(chirp),
   d_nco(),
   d_doppler_fit_engine(4),
   d_freq_diff(offset),
-  d_freq_est_num(0),
-  d_corrections(0),
-  d_corrected_samples(0)
+  d_corrected_samples(0),
+  d_active(),
+  d_pending(),
+  d_has_pending(false),
+  d_nitems(0)
 {
   message_port_register_in(pmt::mp("freq"));
   message_port_register_in(pmt::mp("reset"));
 
   /*
    * NOTE:
-   * Set the maximum number of samples to be equivalent of half a second.
-   * With this way we are sure that at least one frequency message
-   * per second will be processed.
-   *
-   * This is taken into consideration due to the fact that the work()
-   * and the input message handler are NOT reentrant.
+   * The message handlers and the work() share only the lock-free
+   * prediction exchange and the atomic sample counter, so the number of
+   * items per work() call is not limited in order to interleave messages.
    */
-  set_max_noutput_items(d_samp_rate / 2.0);
   set_alignment(8);
 
   set_msg_handler(pmt::mp("freq"),
@@ -91,8 +92,6 @@ doppler_correction_cc_impl::doppler_correction_cc_impl(
   });
 
   d_nco.set_freq((2 * M_PI * (-d_freq_diff)) / d_samp_rate);
-  /* Allocate the buffer that will hold the predicted frequency differences */
-  d_predicted_freqs = new double[d_corrections_per_sec];
 
   /* Allocate aligned memory for the NCO */
   d_nco_buff = (gr_complex *) volk_malloc(
@@ -105,24 +104,56 @@ doppler_correction_cc_impl::doppler_correction_cc_impl(
 void
 doppler_correction_cc_impl::new_freq(pmt::pmt_t msg)
 {
-  boost::mutex::scoped_lock lock(d_mutex);
   double new_freq;
-  new_freq = pmt::to_double(msg);
+  const uint64_t nitems = d_nitems.load(std::memory_order_relaxed);
+  uint64_t idx = nitems;
+  /*
+   * Messages from a predictor carry the sample index that the frequency
+   * corresponds to. Plain frequencies apply to the current sample
+   */
+  if (pmt::is_pair(msg)) {
+    idx = pmt::to_uint64(pmt::car(msg));
+    new_freq = pmt::to_double(pmt::cdr(msg));
+  }
+  else {
+    new_freq = pmt::to_double(msg);
+  }
   d_freq_diff = new_freq - (d_target_freq - d_offset);
-  d_doppler_fit_engine.fit(nitems_written(0), d_freq_diff);
-  /* Predict the frequency differences for the near future */
-  d_doppler_fit_engine.predict_freqs(d_predicted_freqs,
-                                     d_corrections_per_sec,
-                                     d_update_period);
-  d_corrections = 0;
+  d_doppler_fit_engine.fit(idx, d_freq_diff);
+  publish_prediction(nitems, idx);
 }
 
+/*
+ * Discards the predictions received so far, e.g. when a new pass starts.
+ * The correction stops until the fit is ready again
+ */
 void
 doppler_correction_cc_impl::reset(pmt::pmt_t msg)
 {
-  boost::mutex::scoped_lock lock(d_mutex);
-  d_freq_est_num = 0;
-  d_corrections = 0;
+  const uint64_t nitems = d_nitems.load(std::memory_order_relaxed);
+  d_doppler_fit_engine.reset();
+  publish_prediction(nitems, nitems);
+}
+
+/*
+ * Publishes the current fit, which is invalid if the fit is not ready. In
+ * the step mode it takes effect at the first correction step that starts
+ * after the samples already processed
+ */
+void
+doppler_correction_cc_impl::publish_prediction(uint64_t nitems,
+                                               uint64_t origin)
+{
+  doppler_prediction::slot &s = d_prediction.back();
+  s.start = nitems;
+  if (!d_chirp) {
+    s.start = (nitems + d_update_period - 1) / d_update_period
+              * d_update_period;
+  }
+  s.origin = origin;
+  s.end = d_doppler_fit_engine.horizon();
+  s.valid = d_doppler_fit_engine.polynomial(s.coeffs, s.origin);
+  d_prediction.publish();
 }
 
 /*
@@ -130,7 +161,6 @@ doppler_correction_cc_impl::reset(pmt::pmt_t msg)
  */
 doppler_correction_cc_impl::~doppler_correction_cc_impl()
 {
-  delete[] d_predicted_freqs;
   volk_free(d_nco_buff);
 }
 
@@ -141,30 +171,29 @@ doppler_correction_cc_impl::work(int noutput_items,
 {
   const gr_complex *in = (const gr_complex *) input_items[0];
   gr_complex *out = (gr_complex *) output_items[0];
+  const uint64_t nitems = nitems_written(0);
   int produced = 0;
   size_t cnt;
 
+  if (d_chirp) {
+    produced = work_chirp(noutput_items, in, out);
+    d_nitems.store(nitems + produced, std::memory_order_relaxed);
+    return produced;
+  }
+
   while (produced < noutput_items) {
     /*
      * If no samples have been corrected from the current correction step
-     * compute and store the NCO buffer with the corresponding frequency
+     * compute and store the NCO buffer with the corresponding frequency.
+     * The doppler estimation may fail/delay. In such a case the block
+     * extrapolates the last prediction for about one interval and then
+     * holds its frequency
      */
     if (d_corrected_samples == 0) {
-      d_nco.set_freq(
-        2 * M_PI * (-d_predicted_freqs[d_corrections]) / d_samp_rate);
+      const uint64_t idx = nitems + produced;
+      update_prediction(idx);
+      d_nco.set_freq(2 * M_PI * (-d_active.eval(idx)) / d_samp_rate);
       d_nco.sincos(d_nco_buff, d_update_period, 1.0);
-      d_corrections++;
-
-      /*
-       * The doppler estimation may fail/delay. In such a case the block
-       * should continue using the predicted frequencies
-       */
-      if (d_corrections == d_corrections_per_sec) {
-        d_doppler_fit_engine.predict_freqs(d_predicted_freqs,
-                                           d_corrections_per_sec,
-                                           d_update_period);
-        d_corrections = 0;
-      }
     }
 
     cnt = std::min(d_update_period - d_corrected_samples,
@@ -182,6 +211,60 @@ doppler_correction_cc_impl::work(int noutput_items,
     }
   }
 
+  d_nitems.store(nitems + noutput_items, std::memory_order_relaxed);
+  return noutput_items;
+}
+
+/*
+ * Picks up any newly published prediction and switches to it, if the
+ * sample it applies from has been reached
+ */
+void
+doppler_correction_cc_impl::update_prediction(uint64_t idx)
+{
+  if (d_prediction.consume(d_pending)) {
+    d_has_pending = true;
+  }
+  if (d_has_pending && d_pending.start <= idx) {
+    d_active = d_pending;
+    d_has_pending = false;
+  }
+}
+
+/*
+ * Applies the fitted Doppler polynomial directly on the samples, in a single
+ * pass and without an intermediate NCO buffer
+ */
+int
+doppler_correction_cc_impl::work_chirp(int noutput_items, const gr_complex *in,
+                                       gr_complex *out)
+{
+  const uint64_t nitems = nitems_written(0);
+  int produced = 0;
+
+  while (produced < noutput_items) {
+    const uint64_t idx = nitems + produced;
+    update_prediction(idx);
+
+    /* Stop at the sample that a pending prediction applies from */
+    size_t cnt = noutput_items - produced;
+    if (d_has_pending && d_pending.start < idx + cnt) {
+      cnt = d_pending.start - idx;
+    }
+
+    /*
+     * Convert to angular frequency, relative to the first sample. Past the
+     * end of the prediction the frequency is held
+     */
+    double c[chirp_rotator::max_coeffs];
+    cnt = d_active.polynomial(c, idx, cnt);
+    for (double &ci : c) {
+      ci *= -2 * M_PI / d_samp_rate;
+    }
+    d_rotator.rotate(out + produced, in + produced, cnt, c,
+                     chirp_rotator::max_coeffs);
+    produced += cnt;
+  }
   return noutput_items;
 }
 
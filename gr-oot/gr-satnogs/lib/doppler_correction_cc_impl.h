@@ -23,8 +23,10 @@
 
 #include <satnogs/doppler_correction_cc.h>
 #include <satnogs/doppler_fit.h>
+#include <satnogs/chirp_rotator.h>
+#include "doppler_prediction.h"
 #include <gnuradio/fxpt_nco.h>
-#include <deque>
+#include <atomic>
 
 namespace gr {
 namespace satnogs {
@@ -35,18 +37,20 @@ private:
   const double d_offset;
   const double d_samp_rate;
   const size_t d_update_period;
-  const size_t d_est_thrhld;
   const size_t d_corrections_per_sec;
+  const bool d_chirp;
 
   gr::fxpt_nco d_nco;
   doppler_fit d_doppler_fit_engine;
   double d_freq_diff;
-  size_t d_freq_est_num;
-  size_t d_corrections;
   size_t d_corrected_samples;
-  double *d_predicted_freqs;
   gr_complex *d_nco_buff;
-  boost::mutex d_mutex;
+  chirp_rotator d_rotator;
+  doppler_prediction d_prediction;
+  doppler_prediction::slot d_active;
+  doppler_prediction::slot d_pending;
+  bool d_has_pending;
+  std::atomic<uint64_t> d_nitems;
 
   void
   new_freq(pmt::pmt_t msg);
@@ -54,11 +58,21 @@ private:
   void
   reset(pmt::pmt_t msg);
 
+  void
+  publish_prediction(uint64_t nitems, uint64_t origin);
+
+  void
+  update_prediction(uint64_t idx);
+
+  int
+  work_chirp(int noutput_items, const gr_complex *in, gr_complex *out);
+
 public:
   doppler_correction_cc_impl(double target_freq,
                              double offset,
                              double sampling_rate,
-                             size_t corrections_per_sec);
+                             size_t corrections_per_sec,
+                             bool chirp);
   ~doppler_correction_cc_impl();
 
   // Where all the action really happens
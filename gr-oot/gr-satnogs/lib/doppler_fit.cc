@@ -24,6 +24,8 @@
 
 #include <gnuradio/io_signature.h>
 #include <satnogs/doppler_fit.h>
+#include <algorithm>
+#include <vector>
 
 namespace gr {
 namespace satnogs {
@@ -61,23 +63,39 @@ doppler_fit::fit(uint64_t x, double y)
   d_data.push_back({x, y});
 }
 
-double
-doppler_fit::L(uint64_t x)
+/*
+ * Expands the Lagrange polynomial of the stored measurements into its
+ * coefficients, with the sample index relative to origin as variable.
+ * The caller should hold the lock and make sure that the engine is ready.
+ */
+void
+doppler_fit::coefficients(double *coeffs, uint64_t origin) const
 {
-  if (!d_ready) {
-    return 0.0;
-  }
-  double ret = 0.0;
+  std::vector<double> basis(d_degree);
+  std::fill(coeffs, coeffs + d_degree, 0.0);
   for (size_t i = 0; i < d_degree; i++) {
-    double m = d_data[i].second;
+    const double xi = static_cast<int64_t>(d_data[i].first - origin);
+    double den = 1.0;
+    size_t n = 1;
+    basis[0] = 1.0;
     for (size_t j = 0; j < d_degree; j++) {
-      if (i != j && d_data[i].first != d_data[j].first) {
-        m *= ((x - d_data[j].first) / (d_data[i].first - d_data[j].first));
+      if (i == j || d_data[i].first == d_data[j].first) {
+        continue;
       }
+      const double xj = static_cast<int64_t>(d_data[j].first - origin);
+      /* Multiply the basis polynomial by (x - xj) */
+      basis[n] = basis[n - 1];
+      for (size_t k = n - 1; k > 0; k--) {
+        basis[k] = basis[k - 1] - xj * basis[k];
+      }
+      basis[0] *= -xj;
+      den *= xi - xj;
+      n++;
+    }
+    for (size_t k = 0; k < n; k++) {
+      coeffs[k] += d_data[i].second * basis[k] / den;
     }
-    ret += m;
   }
-  return ret;
 }
 
 /**
@@ -92,10 +110,11 @@ doppler_fit::L(uint64_t x)
  *
  * @param samples_per_correction the number of samples elapsed between each
  * correction.
+ * @param origin the sample index of the first prediction
  */
 void
 doppler_fit::predict_freqs(double *freqs, size_t ncorrections,
-                           size_t samples_per_correction)
+                           size_t samples_per_correction, uint64_t origin)
 {
   std::lock_guard<std::mutex> lock(d_mtx);
   if (!d_ready) {
@@ -105,11 +124,86 @@ doppler_fit::predict_freqs(double *freqs, size_t ncorrections,
     return;
   }
 
+  std::vector<double> c(d_degree);
+  coefficients(c.data(), origin);
   for (size_t i = 0; i < ncorrections; i++) {
-    freqs[i] = L(d_data[d_degree - 1].first + i * samples_per_correction);
+    const double x = i * samples_per_correction;
+    double f = 0.0;
+    for (size_t k = d_degree; k > 0; k--) {
+      f = f * x + c[k - 1];
+    }
+    freqs[i] = f;
   }
 }
 
+/**
+ * Retrieves the coefficients of the fitted polynomial, so the frequency
+ * can be evaluated at any sample without repeating the Lagrange
+ * interpolation
+ * @param coeffs buffer that will hold degree() coefficients, starting from
+ * the constant term. The variable of the polynomial is the sample index
+ * relative to \p origin
+ * @param origin the sample index that corresponds to x = 0
+ * @return true if enough measurements have been received to perform the
+ * fit, false otherwise. In the latter case all the coefficients are zero
+ */
+bool
+doppler_fit::polynomial(double *coeffs, uint64_t origin)
+{
+  std::lock_guard<std::mutex> lock(d_mtx);
+  if (!d_ready) {
+    std::fill(coeffs, coeffs + d_degree, 0.0);
+    return false;
+  }
+  coefficients(coeffs, origin);
+  return true;
+}
+
+/**
+ * The fit interpolates between the measurements, but diverges quickly
+ * after the newest one. It should be evaluated at most about one
+ * measurement interval past the newest measurement.
+ * @return the last sample index that the fit should be evaluated at. This
+ * is the index of the newest measurement plus the spacing of the two newest
+ * ones. 0 if there are no measurements
+ */
+uint64_t
+doppler_fit::horizon()
+{
+  std::lock_guard<std::mutex> lock(d_mtx);
+  if (d_data.empty()) {
+    return 0;
+  }
+  const uint64_t last = d_data.back().first;
+  if (d_data.size() < 2 || d_data[d_data.size() - 2].first > last) {
+    return last;
+  }
+  return last + (last - d_data[d_data.size() - 2].first);
+}
+
+/**
+ * Discards all the measurements. The fit is not ready until degree() new
+ * measurements are received
+ */
+void
+doppler_fit::reset()
+{
+  std::lock_guard<std::mutex> lock(d_mtx);
+  d_data.clear();
+  d_ready = false;
+}
+
+/**
+ *
+ * @return the number of measurements used for the fit, which is also the
+ * number of the polynomial coefficients
+ */
+size_t
+doppler_fit::degree() const
+{
+  return d_degree;
+}
+
 } /* namespace satnogs */
 } /* namespace gr */
 
@@ -0,0 +1,149 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "doppler_prediction.h"
+#include <algorithm>
+
+namespace gr {
+namespace satnogs {
+
+/* Layout of the shared state: sequence number, fresh flag, slot index */
+static const uint64_t idx_mask = 0x3;
+static const uint64_t fresh_bit = 0x4;
+static const int seq_shift = 3;
+
+/**
+ * Evaluates the frequency of the prediction
+ * @param idx the sample index
+ * @return the frequency, or 0 if the prediction is not valid. Beyond the
+ * end of the prediction, the frequency at the end is returned
+ */
+double
+doppler_prediction::slot::eval(uint64_t idx) const
+{
+  if (!valid) {
+    return 0.0;
+  }
+  if (static_cast<int64_t>(idx - end) > 0) {
+    idx = end;
+  }
+  const double x = static_cast<int64_t>(idx - origin);
+  double f = 0.0;
+  for (size_t i = chirp_rotator::max_coeffs; i > 0; i--) {
+    f = f * x + coeffs[i - 1];
+  }
+  return f;
+}
+
+/**
+ * Retrieves the frequency polynomial for a run of samples
+ * @param c buffer that will hold chirp_rotator::max_coeffs coefficients.
+ * The variable of the polynomial is the sample index relative to idx
+ * @param idx the first sample of the run
+ * @param n the number of samples of the run
+ * @return the number of samples, up to n, that the polynomial applies to.
+ * A run that crosses the end of the prediction is split there, after which
+ * the polynomial is the constant frequency at the end
+ */
+size_t
+doppler_prediction::slot::polynomial(double *c, uint64_t idx, size_t n) const
+{
+  std::fill(c, c + chirp_rotator::max_coeffs, 0.0);
+  if (!valid) {
+    return n;
+  }
+  const int64_t left = static_cast<int64_t>(end - idx);
+  if (left < 0) {
+    c[0] = eval(end);
+    return n;
+  }
+  std::copy(coeffs, coeffs + chirp_rotator::max_coeffs, c);
+  chirp_rotator::shift_polynomial(c, chirp_rotator::max_coeffs,
+                                  static_cast<int64_t>(idx - origin));
+  return std::min<uint64_t>(n, left + 1);
+}
+
+doppler_prediction::doppler_prediction() :
+  d_state(1),
+  d_back(0),
+  d_seq(0),
+  d_front(2)
+{
+  for (slot &s : d_slots) {
+    s.seq = 0;
+    s.start = 0;
+    s.origin = 0;
+    s.end = 0;
+    s.valid = false;
+    for (double &c : s.coeffs) {
+      c = 0.0;
+    }
+  }
+}
+
+/**
+ * Writer side. The slot returned can be filled freely until publish() is
+ * called
+ * @return the slot owned by the writer
+ */
+doppler_prediction::slot &
+doppler_prediction::back()
+{
+  return d_slots[d_back];
+}
+
+/**
+ * Writer side. Publishes the slot returned by back(), replacing any
+ * previous prediction that the reader has not consumed yet
+ */
+void
+doppler_prediction::publish()
+{
+  d_slots[d_back].seq = ++d_seq;
+  const uint64_t old = d_state.exchange((d_seq << seq_shift) | fresh_bit
+                                        | d_back, std::memory_order_acq_rel);
+  d_back = old & idx_mask;
+}
+
+/**
+ * Reader side. Retrieves the latest prediction, if a new one has been
+ * published since the last call
+ * @param s the slot to copy the prediction into
+ * @return true if a new prediction was copied, false otherwise
+ */
+bool
+doppler_prediction::consume(slot &s)
+{
+  if (!(d_state.load(std::memory_order_acquire) & fresh_bit)) {
+    return false;
+  }
+  const uint64_t old = d_state.exchange(d_front, std::memory_order_acq_rel);
+  d_front = old & idx_mask;
+  s = d_slots[d_front];
+  return true;
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
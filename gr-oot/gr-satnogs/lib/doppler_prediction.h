@@ -0,0 +1,93 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_DOPPLER_PREDICTION_H
+#define INCLUDED_SATNOGS_DOPPLER_PREDICTION_H
+
+#include <satnogs/api.h>
+#include <satnogs/chirp_rotator.h>
+#include <atomic>
+#include <cstdint>
+
+namespace gr {
+namespace satnogs {
+
+/*!
+ * \brief Lock-free handoff of the Doppler predictions from a message
+ * handler to work()
+ *
+ * A prediction is the fitted frequency polynomial, tagged with the sample
+ * index it applies from. The writer fills a slot that only it owns and
+ * publishes it with a single atomic exchange. The reader picks up the
+ * latest published slot in the same way, so neither side ever waits for
+ * the other and no slot is accessed by both at the same time. Three slots
+ * are needed for that: one owned by each side and the latest published
+ * one. The atomic word holds the sequence number of the latest prediction,
+ * whether it is not yet consumed and its slot index.
+ */
+class SATNOGS_API doppler_prediction {
+public:
+  struct slot {
+    uint64_t seq;
+    /* First sample index that the prediction applies to */
+    uint64_t start;
+    /* Sample index that corresponds to x = 0 of the polynomial */
+    uint64_t origin;
+    /*
+     * Last sample index that the polynomial is evaluated at. The frequency
+     * is held beyond it, as the fit diverges away from the measurements
+     */
+    uint64_t end;
+    bool valid;
+    double coeffs[chirp_rotator::max_coeffs];
+
+    double
+    eval(uint64_t idx) const;
+
+    size_t
+    polynomial(double *c, uint64_t idx, size_t n) const;
+  };
+
+  doppler_prediction();
+
+  slot &
+  back();
+
+  void
+  publish();
+
+  bool
+  consume(slot &s);
+
+private:
+  slot d_slots[3];
+  std::atomic<uint64_t> d_state;
+  /* Owned by the writer */
+  uint32_t d_back;
+  uint64_t d_seq;
+  /* Owned by the reader */
+  uint32_t d_front;
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_DOPPLER_PREDICTION_H */
@@ -0,0 +1,360 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/filter/firdes.h>
+#include "doppler_resampler_cc_impl.h"
+#include <satnogs/log.h>
+#include <volk/volk.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+
+namespace gr {
+namespace satnogs {
+
+/* Number of filters of the arbitrary resampler filterbank */
+static const size_t resampler_nfilts = 32;
+
+/*
+ * Number of decimated samples after which the taps are rotated again.
+ * Between updates the phase is still tracked exactly at the decimated rate,
+ * only the frequency offset across the span of the filter is kept constant
+ */
+static const size_t taps_update_period = 64;
+
+doppler_resampler_cc::sptr
+doppler_resampler_cc::make(double samp_rate, double sat_freq,
+                           double lo_offset, double out_samp_rate,
+                           bool compensate)
+{
+  return gnuradio::get_initial_sptr(
+           new doppler_resampler_cc_impl(samp_rate, sat_freq, lo_offset,
+                                         out_samp_rate, compensate));
+}
+
+/*
+ * The private constructor
+ */
+doppler_resampler_cc_impl::doppler_resampler_cc_impl(double samp_rate,
+    double sat_freq,
+    double lo_offset,
+    double out_samp_rate,
+    bool compensate) :
+  gr::block("doppler_resampler_cc",
+            gr::io_signature::make(1, 1, sizeof(gr_complex)),
+            gr::io_signature::make(1, 1, sizeof(gr_complex))),
+  d_samp_rate(samp_rate),
+  d_sat_freq(sat_freq),
+  d_lo_offset(lo_offset),
+  d_out_samp_rate(out_samp_rate),
+  d_compensate(compensate),
+  d_decimation(1),
+  d_step(1.0),
+  d_rot_taps(nullptr),
+  d_nfilts(resampler_nfilts),
+  d_flt_len(0),
+  d_mu(0.0),
+  d_dec_len(0),
+  d_dec_idx(0),
+  d_doppler_fit_engine(4),
+  d_active(),
+  d_nitems(0)
+{
+  if (out_samp_rate <= 0.0 || out_samp_rate > samp_rate) {
+    throw std::invalid_argument("doppler_resampler_cc: Output sampling rate "
+                                "should be less or equal the device sampling rate");
+  }
+  if (std::abs(lo_offset) > samp_rate / 2) {
+    throw std::invalid_argument("doppler_resampler_cc: The LO offset "
+                                "frequency should be less than samp_rate/2");
+  }
+  if (sat_freq < 1) {
+    throw std::invalid_argument("doppler_resampler_cc: Invalid satellite "
+                                "frequency");
+  }
+
+  /*
+   * Decimate as much as possible before the resampler, keeping the LO offset
+   * and the maximum Doppler shift of an (extreme) elliptic LEO with a
+   * relative speed of 10 km/s inside the passband
+   */
+  const double max_doppler = (10e3 / 3e8) * sat_freq;
+  d_decimation = std::max(1.0, std::ceil(samp_rate / (out_samp_rate
+                                         + std::abs(lo_offset) + max_doppler)));
+  const double dec_samp_rate = samp_rate / d_decimation;
+  d_step = dec_samp_rate / out_samp_rate;
+
+  std::vector<float> taps(1, 1.0f);
+  if (d_decimation > 1) {
+    const double passband = out_samp_rate / 2 + std::abs(lo_offset)
+                            + max_doppler;
+    taps = filter::firdes::low_pass(1, samp_rate, passband, passband / 4,
+                                    filter::firdes::WIN_HAMMING);
+  }
+  d_taps.assign(taps.rbegin(), taps.rend());
+  d_rot_taps = (gr_complex *) volk_malloc(d_taps.size() * sizeof(gr_complex),
+                                          volk_get_alignment());
+  if (!d_rot_taps) {
+    throw std::runtime_error("Could not allocate filter memory");
+  }
+  set_history(d_taps.size());
+
+  /*
+   * Prototype filter of the arbitrary resampler, running at d_nfilts times
+   * the decimated rate. Each filter of the bank is a phase of the prototype
+   * and an extra filter holds the phase of the next sample, so the output
+   * can always be interpolated between two adjacent filters.
+   */
+  const double rate = out_samp_rate / dec_samp_rate;
+  const double bw = 0.4 * std::min(1.0, rate);
+  const double tb = 0.2 * std::min(1.0, rate);
+  std::vector<float> proto = filter::firdes::low_pass_2(d_nfilts, d_nfilts,
+                             bw, tb, 80,
+                             filter::firdes::WIN_BLACKMAN_hARRIS);
+  d_flt_len = (proto.size() + d_nfilts - 1) / d_nfilts;
+  proto.resize(d_nfilts * (d_flt_len + 1), 0.0f);
+  for (size_t j = 0; j <= d_nfilts; j++) {
+    float *f = (float *) volk_malloc(d_flt_len * sizeof(float),
+                                     volk_get_alignment());
+    if (!f) {
+      throw std::runtime_error("Could not allocate filter memory");
+    }
+    for (size_t i = 0; i < d_flt_len; i++) {
+      f[d_flt_len - 1 - i] = proto[j + i * d_nfilts];
+    }
+    d_bank.push_back(f);
+  }
+  d_dec.resize(d_flt_len - 1, 0.0f);
+  d_dec_len = d_flt_len - 1;
+
+  set_relative_rate(out_samp_rate / samp_rate);
+
+  message_port_register_in(pmt::mp("doppler"));
+  set_msg_handler(pmt::mp("doppler"),
+  [this](pmt::pmt_t msg) {
+    this->new_freq(msg);
+  });
+}
+
+/*
+ * Our virtual destructor.
+ */
+doppler_resampler_cc_impl::~doppler_resampler_cc_impl()
+{
+  volk_free(d_rot_taps);
+  for (float *f : d_bank) {
+    volk_free(f);
+  }
+}
+
+void
+doppler_resampler_cc_impl::new_freq(pmt::pmt_t msg)
+{
+  if (!d_compensate) {
+    return;
+  }
+  double new_freq;
+  const uint64_t nitems = d_nitems.load(std::memory_order_relaxed);
+  uint64_t idx = nitems;
+  if (pmt::is_pair(msg)) {
+    idx = pmt::to_uint64(pmt::car(msg));
+    new_freq = pmt::to_double(pmt::cdr(msg));
+  }
+  else {
+    new_freq = pmt::to_double(msg);
+  }
+  d_doppler_fit_engine.fit(idx, new_freq - (d_sat_freq - d_lo_offset));
+
+  doppler_prediction::slot &s = d_prediction.back();
+  s.start = nitems;
+  s.origin = idx;
+  s.end = d_doppler_fit_engine.horizon();
+  s.valid = d_doppler_fit_engine.polynomial(s.coeffs, s.origin);
+  d_prediction.publish();
+}
+
+/*
+ * Retrieves the angular frequency of the shift in radians per input
+ * sample, as a polynomial of the input sample index relative to origin,
+ * and returns the number of input samples, up to n, that it applies to.
+ * Until the Doppler fit is ready, only the LO offset is compensated
+ */
+size_t
+doppler_resampler_cc_impl::freq_polynomial(double *c, int64_t origin,
+                                           size_t n)
+{
+  d_prediction.consume(d_active);
+  if (d_active.valid) {
+    n = d_active.polynomial(c, origin, n);
+  }
+  else {
+    std::fill(c, c + chirp_rotator::max_coeffs, 0.0);
+    c[0] = d_lo_offset;
+  }
+  for (size_t i = 0; i < chirp_rotator::max_coeffs; i++) {
+    c[i] *= -2 * M_PI / d_samp_rate;
+  }
+  return n;
+}
+
+/*
+ * Shifts the frequency response of the decimating filter by w radians per
+ * sample. The taps are reversed, so the tap i multiplies the i-th oldest
+ * sample of the window
+ */
+void
+doppler_resampler_cc_impl::rotate_taps(double w)
+{
+  const std::complex<double> e = std::polar(1.0, w);
+  std::complex<double> r(1.0, 0.0);
+  for (size_t i = 0; i < d_taps.size(); i++) {
+    d_rot_taps[i] = gr_complex(d_taps[i] * r.real(), d_taps[i] * r.imag());
+    r *= e;
+  }
+}
+
+/*
+ * Produces n decimated and frequency shifted samples. The filter with the
+ * rotated taps applies the shift relative to the first sample of each
+ * window and the chirp rotator the phase of that sample. The samples are
+ * processed in runs that share the same frequency polynomial
+ */
+size_t
+doppler_resampler_cc_impl::decimate(gr_complex *out, const gr_complex *in,
+                                    size_t n)
+{
+  const size_t ntaps = d_taps.size();
+  const double dec = d_decimation;
+  double c[chirp_rotator::max_coeffs];
+
+  size_t done = 0;
+  while (done < n) {
+    const int64_t first = (int64_t)(nitems_read(0) + done * d_decimation)
+                          - (int64_t)(ntaps - 1);
+    const size_t nin = freq_polynomial(c, first, (n - done) * d_decimation);
+    const size_t nout = (nin + d_decimation - 1) / d_decimation;
+    const size_t run = std::min(n - done, std::max<size_t>(1, nout));
+    gr_complex *o = out + done;
+    const gr_complex *x_in = in + done * d_decimation;
+
+    for (size_t m = 0; m < run; m += taps_update_period) {
+      const double x = m * dec;
+      double w = 0.0;
+      for (size_t i = chirp_rotator::max_coeffs; i > 0; i--) {
+        w = w * x + c[i - 1];
+      }
+      rotate_taps(w);
+      const size_t cnt = std::min(taps_update_period, run - m);
+      for (size_t i = m; i < m + cnt; i++) {
+        volk_32fc_x2_dot_prod_32fc(o + i, x_in + i * d_decimation,
+                                   d_rot_taps, ntaps);
+      }
+    }
+
+    /* The frequency per decimated sample */
+    double s = dec;
+    for (size_t i = 0; i < chirp_rotator::max_coeffs; i++) {
+      c[i] *= s;
+      s *= dec;
+    }
+    d_rotator.rotate(o, o, run, c, chirp_rotator::max_coeffs);
+    done += run;
+  }
+  return n;
+}
+
+/*
+ * Interpolates the output samples from the decimated ones, with a linear
+ * interpolation between the two filters closest to the fractional position
+ */
+size_t
+doppler_resampler_cc_impl::resample(gr_complex *out, size_t noutput_items)
+{
+  size_t produced = 0;
+  while (produced < noutput_items && d_dec_idx + d_flt_len <= d_dec_len) {
+    const gr_complex *w = &d_dec[d_dec_idx];
+    const double pos = d_mu * d_nfilts;
+    const size_t j = std::min((size_t) pos, d_nfilts - 1);
+    const float a = pos - j;
+    gr_complex y0;
+    gr_complex y1;
+    volk_32fc_32f_dot_prod_32fc(&y0, w, d_bank[j], d_flt_len);
+    volk_32fc_32f_dot_prod_32fc(&y1, w, d_bank[j + 1], d_flt_len);
+    out[produced++] = y0 + a * (y1 - y0);
+
+    d_mu += d_step;
+    const double adv = std::floor(d_mu);
+    d_mu -= adv;
+    d_dec_idx += (size_t) adv;
+  }
+  return produced;
+}
+
+void
+doppler_resampler_cc_impl::forecast(int noutput_items,
+                                    gr_vector_int &ninput_items_required)
+{
+  ninput_items_required[0] = std::ceil(noutput_items * d_step) * d_decimation;
+}
+
+int
+doppler_resampler_cc_impl::general_work(int noutput_items,
+                                        gr_vector_int &ninput_items,
+                                        gr_vector_const_void_star &input_items,
+                                        gr_vector_void_star &output_items)
+{
+  const gr_complex *in = (const gr_complex *) input_items[0];
+  gr_complex *out = (gr_complex *) output_items[0];
+
+  /* Decimate only as many samples as the requested output needs */
+  const size_t needed = d_dec_idx + d_flt_len
+                        + (size_t) std::ceil(noutput_items * d_step);
+  size_t n = 0;
+  if (needed > d_dec_len) {
+    n = std::min(ninput_items[0] / d_decimation, needed - d_dec_len);
+  }
+  if (d_dec.size() < d_dec_len + n) {
+    d_dec.resize(d_dec_len + n);
+  }
+  decimate(&d_dec[d_dec_len], in, n);
+  d_dec_len += n;
+  consume_each(n * d_decimation);
+  d_nitems.store(nitems_read(0) + n * d_decimation,
+                 std::memory_order_relaxed);
+
+  const size_t produced = resample(out, noutput_items);
+
+  /* Keep only the samples that the next outputs need */
+  const size_t drop = std::min(d_dec_idx, d_dec_len);
+  std::copy(d_dec.begin() + drop, d_dec.begin() + d_dec_len, d_dec.begin());
+  d_dec_len -= drop;
+  d_dec_idx -= drop;
+  return produced;
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
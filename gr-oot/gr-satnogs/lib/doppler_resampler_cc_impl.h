@@ -0,0 +1,99 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_DOPPLER_RESAMPLER_CC_IMPL_H
+#define INCLUDED_SATNOGS_DOPPLER_RESAMPLER_CC_IMPL_H
+
+#include <satnogs/doppler_resampler_cc.h>
+#include <satnogs/doppler_fit.h>
+#include <satnogs/chirp_rotator.h>
+#include "doppler_prediction.h"
+#include <atomic>
+#include <vector>
+
+namespace gr {
+namespace satnogs {
+
+class doppler_resampler_cc_impl : public doppler_resampler_cc {
+private:
+  const double d_samp_rate;
+  const double d_sat_freq;
+  const double d_lo_offset;
+  const double d_out_samp_rate;
+  const bool d_compensate;
+  size_t d_decimation;
+  double d_step;
+
+  /* Decimating filter, reversed, and its copy rotated by the frequency */
+  std::vector<float> d_taps;
+  gr_complex *d_rot_taps;
+
+  /* Arbitrary resampler filterbank, reversed, one filter per phase */
+  size_t d_nfilts;
+  size_t d_flt_len;
+  std::vector<float *> d_bank;
+  double d_mu;
+
+  /* Decimated samples, including the history of the resampler */
+  std::vector<gr_complex> d_dec;
+  size_t d_dec_len;
+  size_t d_dec_idx;
+
+  chirp_rotator d_rotator;
+  doppler_fit d_doppler_fit_engine;
+  doppler_prediction d_prediction;
+  doppler_prediction::slot d_active;
+  std::atomic<uint64_t> d_nitems;
+
+  void
+  new_freq(pmt::pmt_t msg);
+
+  size_t
+  freq_polynomial(double *c, int64_t origin, size_t n);
+
+  void
+  rotate_taps(double w);
+
+  size_t
+  decimate(gr_complex *out, const gr_complex *in, size_t n);
+
+  size_t
+  resample(gr_complex *out, size_t noutput_items);
+
+public:
+  doppler_resampler_cc_impl(double samp_rate, double sat_freq,
+                            double lo_offset, double out_samp_rate,
+                            bool compensate);
+  ~doppler_resampler_cc_impl();
+
+  void
+  forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+  int
+  general_work(int noutput_items, gr_vector_int &ninput_items,
+               gr_vector_const_void_star &input_items,
+               gr_vector_void_star &output_items);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_DOPPLER_RESAMPLER_CC_IMPL_H */
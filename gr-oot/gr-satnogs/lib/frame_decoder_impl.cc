@@ -108,12 +108,14 @@ frame_decoder_impl::work(int noutput_items,
     d_t_err_acc += *d_t_err;
   }
 
-  if (status.decode_success) {
+  /* Publish all the frames decoded during this call at once */
+  status.next_frame();
+  for (pmt::pmt_t &frame : status.frames) {
     if (input_items.size() > 1) {
-      metadata::add_symbol_timing_error(status.data,
+      metadata::add_symbol_timing_error(frame,
                                         d_t_err_acc / (nitems_read(0) + noutput_items));
     }
-    message_port_pub(pmt::mp("out"), status.data);
+    message_port_pub(pmt::mp("out"), frame);
   }
 
   // Tell runtime system how many output items we produced.
@@ -32,17 +32,18 @@ namespace gr {
 namespace satnogs {
 
 frame_file_sink::sptr
-frame_file_sink::make(const std::string &prefix_name, int output_type)
+frame_file_sink::make(const std::string &prefix_name, int output_type,
+                      size_t segment_size)
 {
   return gnuradio::get_initial_sptr(
-           new frame_file_sink_impl(prefix_name, output_type));
+           new frame_file_sink_impl(prefix_name, output_type, segment_size));
 }
 
 /*
  * The private constructor
  */
 frame_file_sink_impl::frame_file_sink_impl(const std::string &prefix_name,
-    int output_type) :
+    int output_type, size_t segment_size) :
   gr::block("frame_file_sink", gr::io_signature::make(0, 0, 0),
             gr::io_signature::make(0, 0, 0)),
   d_prefix_name(prefix_name),
@@ -50,6 +51,9 @@ frame_file_sink_impl::frame_file_sink_impl(const std::string &prefix_name,
   d_filename_prev(""),
   d_counter(0)
 {
+  if (d_output_type == FRAME_STORE) {
+    d_store.reset(new frame_store_writer(prefix_name, segment_size));
+  }
   message_port_register_in(pmt::mp("frame"));
   set_msg_handler(pmt::mp("frame"),
   [this](pmt::pmt_t msg) {
@@ -65,10 +69,57 @@ frame_file_sink_impl::~frame_file_sink_impl()
 {
 }
 
+bool
+frame_file_sink_impl::stop()
+{
+  if (d_store) {
+    d_store->close();
+  }
+  return true;
+}
+
+void
+frame_file_sink_impl::store_frame(pmt::pmt_t msg, const uint8_t *pdu,
+                                  size_t len)
+{
+  uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+  uint64_t sample_start = UINT64_MAX;
+  if (pmt::is_dict(msg)) {
+    pmt::pmt_t s = pmt::dict_ref(msg, metadata::key(metadata::SAMPLE_START),
+                                 pmt::PMT_NIL);
+    if (pmt::is_integer(s) || pmt::is_uint64(s)) {
+      sample_start = pmt::to_uint64(s);
+    }
+  }
+  d_store->append(pdu, len, time_us, sample_start);
+}
+
 void
 frame_file_sink_impl::msg_handler_frame(pmt::pmt_t msg)
 {
 
+  const char *su;
+  size_t len;
+
+  /* Check if the message contains the legacy or the new format */
+  if (pmt::is_dict(msg)) {
+    pmt::pmt_t pdu = pmt::dict_ref(msg,
+                                   pmt::mp(metadata::value(metadata::PDU)),
+                                   pmt::PMT_NIL);
+    su = (const char *) pmt::blob_data(pdu);
+    len = pmt::blob_length(pdu);
+  }
+  else {
+    su = (const char *) pmt::blob_data(msg), pmt::blob_length(msg);
+    len = pmt::blob_length(msg);
+  }
+
+  if (d_store) {
+    store_frame(msg, (const uint8_t *) su, len);
+    return;
+  }
+
   /* check for the current UTC time */
   std::chrono::system_clock::time_point p2 =
     std::chrono::system_clock::now();
@@ -99,31 +150,15 @@ frame_file_sink_impl::msg_handler_frame(pmt::pmt_t msg)
     d_counter = 0;
   }
 
-  const char *su;
-  size_t len;
-
-  /* Check if the message contains the legacy or the new format */
-  if (pmt::is_dict(msg)) {
-    pmt::pmt_t pdu = pmt::dict_ref(msg,
-                                   pmt::mp(metadata::value(metadata::PDU)),
-                                   pmt::PMT_NIL);
-    su = (const char *) pmt::blob_data(pdu);
-    len = pmt::blob_length(pdu);
-  }
-  else {
-    su = (const char *) pmt::blob_data(msg), pmt::blob_length(msg);
-    len = pmt::blob_length(msg);
-  }
-
   switch (d_output_type) {
-  case 0: {
+  case BINARY: {
     /* Binary form */
     std::ofstream fd(filename.c_str());
     fd.write(su, len);
     fd.close();
     break;
   }
-  case 1: {
+  case HEX_ANNOTATED: {
     /* aHex annotated, dd .txt to filename */
     filename.append(".txt");
     std::ofstream fd(filename.c_str());
@@ -134,7 +169,7 @@ frame_file_sink_impl::msg_handler_frame(pmt::pmt_t msg)
     fd.close();
     break;
   }
-  case 2: {
+  case BINARY_ANNOTATED: {
     /* Binary annotated, add .txt to filename */
     filename.append(".txt");
     std::ofstream fd(filename.c_str());
@@ -22,8 +22,10 @@
 #define INCLUDED_SATNOGS_FRAME_FILE_SINK_IMPL_H
 
 #include <satnogs/frame_file_sink.h>
+#include <satnogs/frame_store.h>
 #include <chrono>
 #include <fstream>
+#include <memory>
 
 
 namespace gr {
@@ -35,11 +37,19 @@ private:
   int d_output_type;
   std::string d_filename_prev;
   int d_counter;
+  std::unique_ptr<frame_store_writer> d_store;
+
+  void
+  store_frame(pmt::pmt_t msg, const uint8_t *pdu, size_t len);
 
 public:
-  frame_file_sink_impl(const std::string &prefix_name, int output_type);
+  frame_file_sink_impl(const std::string &prefix_name, int output_type,
+                       size_t segment_size);
   ~frame_file_sink_impl();
 
+  bool
+  stop();
+
   void
   msg_handler_frame(pmt::pmt_t msg);
 };
@@ -0,0 +1,512 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <satnogs/frame_metadata.h>
+#include <satnogs/base64.h>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace gr {
+namespace satnogs {
+
+static_assert(metadata::KEYS_NUM <= 32,
+              "frame_metadata: the field bitmap cannot hold all keys");
+
+/*
+ * Helpers for writing compact JSON directly into a string buffer
+ */
+static void
+write_key(std::string &out, metadata::key_t k)
+{
+  if (out.back() != '{') {
+    out += ',';
+  }
+  out += '"';
+  out += metadata::value(k);
+  out += "\":";
+}
+
+static void
+write_number(std::string &out, double x, int precision)
+{
+  /* JSON does not support NaN and infinite numbers */
+  if (!std::isfinite(x)) {
+    out += "null";
+    return;
+  }
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%.*g", precision, x);
+  out.append(buf, n);
+}
+
+static void
+write_number(std::string &out, uint64_t x)
+{
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%" PRIu64, x);
+  out.append(buf, n);
+}
+
+static void
+write_string(std::string &out, const std::string &s)
+{
+  out += '"';
+  for (unsigned char c : s) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (c < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      }
+      else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
+
+static void
+write_base64(std::string &out, const uint8_t *in, size_t len)
+{
+  out += '"';
+  size_t i = 0;
+  for (; i + 3 <= len; i += 3) {
+    const uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+    out += base64_chars[(v >> 18) & 0x3f];
+    out += base64_chars[(v >> 12) & 0x3f];
+    out += base64_chars[(v >> 6) & 0x3f];
+    out += base64_chars[v & 0x3f];
+  }
+  if (i < len) {
+    const uint32_t v = (in[i] << 16) | (i + 1 < len ? in[i + 1] << 8 : 0);
+    out += base64_chars[(v >> 18) & 0x3f];
+    out += base64_chars[(v >> 12) & 0x3f];
+    out += i + 1 < len ? base64_chars[(v >> 6) & 0x3f] : '=';
+    out += '=';
+  }
+  out += '"';
+}
+
+frame_metadata::frame_metadata()
+{
+  clear();
+}
+
+/**
+ * Creates the record from a metadata dictionary
+ * @param m the PMT dictionary
+ */
+frame_metadata::frame_metadata(const pmt::pmt_t &m)
+{
+  parse(m);
+}
+
+/**
+ * Resets the record, so no field is present
+ */
+void
+frame_metadata::clear()
+{
+  pdu = pmt::PMT_NIL;
+  crc_valid = false;
+  center_freq = 0.0;
+  freq_offset = 0.0;
+  phase_delay = 0;
+  resampling_ratio = 0.0f;
+  corrected_bits = 0;
+  time = pmt::PMT_NIL;
+  sample_start = 0;
+  sample_cnt = 0;
+  symbol_erasures = 0;
+  snr = 0.0f;
+  decoder_name = pmt::PMT_NIL;
+  decoder_version = pmt::PMT_NIL;
+  antenna_azimuth = 0.0;
+  antenna_elevation = 0.0;
+  antenna_polarization = pmt::PMT_NIL;
+  symbol_timing_error = 0.0;
+  decoder_id = 0;
+  d_fields = 0;
+}
+
+/**
+ * Parses a metadata dictionary with a single pass over its items.
+ * The keys are interned PMT symbols, so they are identified by comparing
+ * them with the pre-interned keys of the metadata class. Unknown keys are
+ * ignored.
+ * @param m the PMT dictionary
+ */
+void
+frame_metadata::parse(const pmt::pmt_t &m)
+{
+  clear();
+  if (!m || !pmt::is_dict(m)) {
+    return;
+  }
+  for (pmt::pmt_t it = pmt::dict_items(m); pmt::is_pair(it);
+       it = pmt::cdr(it)) {
+    const pmt::pmt_t &item = pmt::car(it);
+    const pmt::pmt_t &k = pmt::car(item);
+    for (size_t i = 0; i < metadata::KEYS_NUM; i++) {
+      if (pmt::eq(k, metadata::key((metadata::key_t) i))) {
+        set((metadata::key_t) i, pmt::cdr(item));
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Sets the value of a field
+ * @param k the metadata key
+ * @param v the value as stored at the metadata dictionary
+ */
+void
+frame_metadata::set(metadata::key_t k, const pmt::pmt_t &v)
+{
+  switch (k) {
+  case metadata::PDU:
+    pdu = v;
+    break;
+  case metadata::DECODER_CRC_VALID:
+    crc_valid = pmt::to_bool(v);
+    break;
+  case metadata::CENTER_FREQ:
+    center_freq = pmt::to_double(v);
+    break;
+  case metadata::FREQ_OFFSET:
+    freq_offset = pmt::to_double(v);
+    break;
+  case metadata::DECODER_PHASE_DELAY:
+    phase_delay = pmt::to_uint64(v);
+    break;
+  case metadata::DECODER_RESAMPLING_RATIO:
+    resampling_ratio = pmt::to_float(v);
+    break;
+  case metadata::DECODER_CORRECTED_BITS:
+    corrected_bits = pmt::to_uint64(v);
+    break;
+  case metadata::TIME:
+    time = v;
+    break;
+  case metadata::SAMPLE_START:
+    sample_start = pmt::to_uint64(v);
+    break;
+  case metadata::SAMPLE_CNT:
+    sample_cnt = pmt::to_uint64(v);
+    break;
+  case metadata::DECODER_SYMBOL_ERASURES:
+    symbol_erasures = pmt::to_uint64(v);
+    break;
+  case metadata::SNR:
+    snr = pmt::to_float(v);
+    break;
+  case metadata::DECODER_NAME:
+    decoder_name = v;
+    break;
+  case metadata::DECODER_VERSION:
+    decoder_version = v;
+    break;
+  case metadata::ANTENNA_AZIMUTH:
+    antenna_azimuth = pmt::to_double(v);
+    break;
+  case metadata::ANTENNA_ELEVATION:
+    antenna_elevation = pmt::to_double(v);
+    break;
+  case metadata::ANTENNA_POLARIZATION:
+    antenna_polarization = v;
+    break;
+  case metadata::SYMBOL_TIMING_ERROR:
+    symbol_timing_error = pmt::to_double(v);
+    break;
+  case metadata::DECODER_ID:
+    decoder_id = pmt::to_long(v);
+    break;
+  default:
+    return;
+  }
+  d_fields |= 1U << k;
+}
+
+/**
+ *
+ * @param k the metadata key
+ * @return the PMT representation of the field @a k
+ */
+pmt::pmt_t
+frame_metadata::value(metadata::key_t k) const
+{
+  switch (k) {
+  case metadata::PDU:
+    return pdu;
+  case metadata::DECODER_CRC_VALID:
+    return pmt::from_bool(crc_valid);
+  case metadata::CENTER_FREQ:
+    return pmt::from_double(center_freq);
+  case metadata::FREQ_OFFSET:
+    return pmt::from_double(freq_offset);
+  case metadata::DECODER_PHASE_DELAY:
+    return pmt::from_uint64(phase_delay);
+  case metadata::DECODER_RESAMPLING_RATIO:
+    return pmt::from_float(resampling_ratio);
+  case metadata::DECODER_CORRECTED_BITS:
+    return pmt::from_uint64(corrected_bits);
+  case metadata::TIME:
+    return time;
+  case metadata::SAMPLE_START:
+    return pmt::from_uint64(sample_start);
+  case metadata::SAMPLE_CNT:
+    return pmt::from_uint64(sample_cnt);
+  case metadata::DECODER_SYMBOL_ERASURES:
+    return pmt::from_uint64(symbol_erasures);
+  case metadata::SNR:
+    return pmt::from_float(snr);
+  case metadata::DECODER_NAME:
+    return decoder_name;
+  case metadata::DECODER_VERSION:
+    return decoder_version;
+  case metadata::ANTENNA_AZIMUTH:
+    return pmt::from_double(antenna_azimuth);
+  case metadata::ANTENNA_ELEVATION:
+    return pmt::from_double(antenna_elevation);
+  case metadata::ANTENNA_POLARIZATION:
+    return antenna_polarization;
+  case metadata::SYMBOL_TIMING_ERROR:
+    return pmt::from_double(symbol_timing_error);
+  case metadata::DECODER_ID:
+    return pmt::from_long(decoder_id);
+  default:
+    return pmt::PMT_NIL;
+  }
+}
+
+/**
+ *
+ * @return a metadata dictionary with all the fields that are present
+ */
+pmt::pmt_t
+frame_metadata::to_pmt() const
+{
+  pmt::pmt_t m = pmt::make_dict();
+  for (size_t i = 0; i < metadata::KEYS_NUM; i++) {
+    if (has((metadata::key_t) i)) {
+      metadata::add(m, (metadata::key_t) i, value((metadata::key_t) i));
+    }
+  }
+  return m;
+}
+
+/**
+ *
+ * @return the JSON representation of the fields that are present
+ */
+nlohmann::json
+frame_metadata::to_json() const
+{
+  nlohmann::json j;
+  if (has(metadata::PDU)) {
+    j[metadata::value(metadata::PDU)] = base64_encode(
+                                          (const uint8_t *) pmt::blob_data(pdu),
+                                          pmt::blob_length(pdu));
+  }
+  if (has(metadata::TIME)) {
+    j[metadata::value(metadata::TIME)] = pmt::symbol_to_string(time);
+  }
+  if (has(metadata::DECODER_CRC_VALID)) {
+    j[metadata::value(metadata::DECODER_CRC_VALID)] = crc_valid;
+  }
+  if (has(metadata::SAMPLE_START)) {
+    j[metadata::value(metadata::SAMPLE_START)] = sample_start;
+  }
+  if (has(metadata::SAMPLE_CNT)) {
+    j[metadata::value(metadata::SAMPLE_CNT)] = sample_cnt;
+  }
+  if (has(metadata::DECODER_SYMBOL_ERASURES)) {
+    j[metadata::value(metadata::DECODER_SYMBOL_ERASURES)] = symbol_erasures;
+  }
+  if (has(metadata::DECODER_CORRECTED_BITS)) {
+    j[metadata::value(metadata::DECODER_CORRECTED_BITS)] = corrected_bits;
+  }
+  if (has(metadata::CENTER_FREQ)) {
+    j[metadata::value(metadata::CENTER_FREQ)] = center_freq;
+  }
+  if (has(metadata::FREQ_OFFSET)) {
+    j[metadata::value(metadata::FREQ_OFFSET)] = freq_offset;
+  }
+  if (has(metadata::SNR)) {
+    j[metadata::value(metadata::SNR)] = snr;
+  }
+  if (has(metadata::ANTENNA_AZIMUTH)) {
+    j[metadata::value(metadata::ANTENNA_AZIMUTH)] = antenna_azimuth;
+  }
+  if (has(metadata::ANTENNA_ELEVATION)) {
+    j[metadata::value(metadata::ANTENNA_ELEVATION)] = antenna_elevation;
+  }
+  if (has(metadata::ANTENNA_POLARIZATION)) {
+    j[metadata::value(metadata::ANTENNA_POLARIZATION)] =
+      pmt::symbol_to_string(antenna_polarization);
+  }
+  if (has(metadata::DECODER_PHASE_DELAY)) {
+    j[metadata::value(metadata::DECODER_PHASE_DELAY)] = phase_delay;
+  }
+  if (has(metadata::DECODER_RESAMPLING_RATIO)) {
+    j[metadata::value(metadata::DECODER_RESAMPLING_RATIO)] = resampling_ratio;
+  }
+  if (has(metadata::DECODER_NAME)) {
+    j[metadata::value(metadata::DECODER_NAME)] =
+      pmt::symbol_to_string(decoder_name);
+  }
+  if (has(metadata::DECODER_VERSION)) {
+    j[metadata::value(metadata::DECODER_VERSION)] =
+      pmt::symbol_to_string(decoder_version);
+  }
+  if (has(metadata::SYMBOL_TIMING_ERROR)) {
+    j[metadata::value(metadata::SYMBOL_TIMING_ERROR)] = symbol_timing_error;
+  }
+  if (has(metadata::DECODER_ID)) {
+    j[metadata::value(metadata::DECODER_ID)] = decoder_id;
+  }
+  return j;
+}
+
+/**
+ * Appends the fields that are present as a compact JSON object, without
+ * building an intermediate JSON document. The output is equivalent to
+ * to_json(), but without any whitespace.
+ *
+ * @param out the string to append to. Its capacity is kept, so the same
+ * string can be reused for every frame
+ * @param extra already serialized JSON members (e.g "\"extra\":{}")
+ * appended at the end of the object. If empty, nothing is appended
+ */
+void
+frame_metadata::write_json(std::string &out, const std::string &extra) const
+{
+  out += '{';
+  if (has(metadata::PDU)) {
+    write_key(out, metadata::PDU);
+    write_base64(out, (const uint8_t *) pmt::blob_data(pdu),
+                 pmt::blob_length(pdu));
+  }
+  if (has(metadata::TIME)) {
+    write_key(out, metadata::TIME);
+    write_string(out, pmt::symbol_to_string(time));
+  }
+  if (has(metadata::DECODER_CRC_VALID)) {
+    write_key(out, metadata::DECODER_CRC_VALID);
+    out += crc_valid ? "true" : "false";
+  }
+  if (has(metadata::SAMPLE_START)) {
+    write_key(out, metadata::SAMPLE_START);
+    write_number(out, sample_start);
+  }
+  if (has(metadata::SAMPLE_CNT)) {
+    write_key(out, metadata::SAMPLE_CNT);
+    write_number(out, sample_cnt);
+  }
+  if (has(metadata::DECODER_SYMBOL_ERASURES)) {
+    write_key(out, metadata::DECODER_SYMBOL_ERASURES);
+    write_number(out, symbol_erasures);
+  }
+  if (has(metadata::DECODER_CORRECTED_BITS)) {
+    write_key(out, metadata::DECODER_CORRECTED_BITS);
+    write_number(out, corrected_bits);
+  }
+  if (has(metadata::CENTER_FREQ)) {
+    write_key(out, metadata::CENTER_FREQ);
+    write_number(out, center_freq, 17);
+  }
+  if (has(metadata::FREQ_OFFSET)) {
+    write_key(out, metadata::FREQ_OFFSET);
+    write_number(out, freq_offset, 17);
+  }
+  if (has(metadata::SNR)) {
+    write_key(out, metadata::SNR);
+    write_number(out, snr, 9);
+  }
+  if (has(metadata::ANTENNA_AZIMUTH)) {
+    write_key(out, metadata::ANTENNA_AZIMUTH);
+    write_number(out, antenna_azimuth, 17);
+  }
+  if (has(metadata::ANTENNA_ELEVATION)) {
+    write_key(out, metadata::ANTENNA_ELEVATION);
+    write_number(out, antenna_elevation, 17);
+  }
+  if (has(metadata::ANTENNA_POLARIZATION)) {
+    write_key(out, metadata::ANTENNA_POLARIZATION);
+    write_string(out, pmt::symbol_to_string(antenna_polarization));
+  }
+  if (has(metadata::DECODER_PHASE_DELAY)) {
+    write_key(out, metadata::DECODER_PHASE_DELAY);
+    write_number(out, phase_delay);
+  }
+  if (has(metadata::DECODER_RESAMPLING_RATIO)) {
+    write_key(out, metadata::DECODER_RESAMPLING_RATIO);
+    write_number(out, resampling_ratio, 9);
+  }
+  if (has(metadata::DECODER_NAME)) {
+    write_key(out, metadata::DECODER_NAME);
+    write_string(out, pmt::symbol_to_string(decoder_name));
+  }
+  if (has(metadata::DECODER_VERSION)) {
+    write_key(out, metadata::DECODER_VERSION);
+    write_string(out, pmt::symbol_to_string(decoder_version));
+  }
+  if (has(metadata::SYMBOL_TIMING_ERROR)) {
+    write_key(out, metadata::SYMBOL_TIMING_ERROR);
+    write_number(out, symbol_timing_error, 17);
+  }
+  if (has(metadata::DECODER_ID)) {
+    write_key(out, metadata::DECODER_ID);
+    out += std::to_string(decoder_id);
+  }
+  if (!extra.empty()) {
+    if (out.back() != '{') {
+      out += ',';
+    }
+    out += extra;
+  }
+  out += '}';
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
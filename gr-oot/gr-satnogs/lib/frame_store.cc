@@ -0,0 +1,521 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <satnogs/frame_store.h>
+#include <satnogs/crc.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+namespace gr {
+namespace satnogs {
+
+static const char header_magic[4] = {'S', 'N', 'F', 'S'};
+static const char record_magic[4] = {'S', 'N', 'F', 'R'};
+static const char index_magic[4] = {'S', 'N', 'F', 'I'};
+static const uint32_t format_version = 2;
+static const size_t header_len = 8;
+static const size_t record_header_len = 24;
+static const size_t record_crc_len = 4;
+static const size_t index_entry_len = 24;
+static const size_t trailer_len = 20;
+static const uint64_t unknown_sample = UINT64_MAX;
+
+static void
+put_le(uint8_t *out, uint64_t v, size_t n)
+{
+  for (size_t i = 0; i < n; i++) {
+    out[i] = v >> (8 * i);
+  }
+}
+
+static uint64_t
+get_le(const uint8_t *in, size_t n)
+{
+  uint64_t v = 0;
+  for (size_t i = 0; i < n; i++) {
+    v |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return v;
+}
+
+/**
+ * Creates a writer that stores frames in segment files
+ * @param prefix prefix of the segment file names, including the directory
+ * path. The UTC time of the first frame and the .frames extension are
+ * appended to it
+ * @param max_segment_size the size in bytes after which the current segment
+ * is closed and a new one is started with the next frame
+ * @param flush_size records are kept in memory and written to the file once
+ * their total size exceeds this value
+ * @param flush_interval the maximum time in seconds that a record is kept in
+ * memory before it is written to the file
+ */
+frame_store_writer::frame_store_writer(const std::string &prefix,
+                                       size_t max_segment_size,
+                                       size_t flush_size,
+                                       double flush_interval) :
+  d_prefix(prefix),
+  d_max_segment_size(max_segment_size),
+  d_flush_size(flush_size),
+  d_flush_interval(flush_interval),
+  d_open(false),
+  d_filename_prev(""),
+  d_counter(0),
+  d_offset(0),
+  d_stop(false)
+{
+  if (max_segment_size < header_len + record_header_len + record_crc_len) {
+    throw std::invalid_argument("frame_store_writer: invalid segment size");
+  }
+  if (flush_interval <= 0.0) {
+    throw std::invalid_argument("frame_store_writer: invalid flush interval");
+  }
+  d_buf.reserve(flush_size + record_header_len + record_crc_len);
+  d_out.reserve(flush_size + record_header_len + record_crc_len);
+  d_flusher = std::thread(&frame_store_writer::flusher, this);
+}
+
+frame_store_writer::~frame_store_writer()
+{
+  {
+    std::lock_guard<std::mutex> lock(d_mtx);
+    d_stop = true;
+  }
+  d_cond.notify_one();
+  d_flusher.join();
+  close();
+}
+
+std::string
+frame_store_writer::filename() const
+{
+  std::lock_guard<std::mutex> lock(d_mtx);
+  return d_filename;
+}
+
+/*
+ * Starts a new segment file. The caller should hold d_mtx
+ */
+void
+frame_store_writer::open_segment(uint64_t time_us)
+{
+  char buffer[30];
+  std::time_t t = time_us / 1000000;
+  std::strftime(buffer, 30, "%FT%H-%M-%S", std::gmtime(&t));
+
+  std::string filename = d_prefix + "_" + buffer;
+  if (filename == d_filename_prev) {
+    d_counter++;
+    d_filename = filename + "_" + std::to_string(d_counter);
+  }
+  else {
+    d_filename_prev = filename;
+    d_counter = 0;
+    d_filename = filename;
+  }
+  d_filename.append(".frames");
+
+  {
+    std::lock_guard<std::mutex> io(d_io_mtx);
+    d_file.open(d_filename, std::ios::binary | std::ios::trunc);
+    if (!d_file) {
+      d_file.clear();
+      throw std::runtime_error("frame_store_writer: could not open "
+                               + d_filename);
+    }
+  }
+  d_open = true;
+  uint8_t hdr[header_len];
+  std::memcpy(hdr, header_magic, 4);
+  put_le(hdr + 4, format_version, 4);
+  d_buf.insert(d_buf.end(), hdr, hdr + header_len);
+  d_offset = header_len;
+  d_index.clear();
+}
+
+/**
+ * Appends a frame to the current segment. The frame is written to the file
+ * asynchronously
+ * @param data the frame
+ * @param len the length of the frame in bytes
+ * @param time_us the UTC time of the frame in microseconds since the epoch
+ * @param sample_start the index of the first sample of the frame.
+ * UINT64_MAX if it is not known
+ */
+void
+frame_store_writer::append(const uint8_t *data, size_t len, uint64_t time_us,
+                           uint64_t sample_start)
+{
+  if (len > UINT32_MAX) {
+    throw std::invalid_argument("frame_store_writer: frame too large");
+  }
+  const size_t record_len = record_header_len + len + record_crc_len;
+
+  std::lock_guard<std::mutex> lock(d_mtx);
+  if (d_open && d_offset + record_len > d_max_segment_size) {
+    close_segment();
+  }
+  if (!d_open) {
+    open_segment(time_us);
+  }
+
+  d_index.push_back({d_offset, time_us, sample_start});
+
+  uint8_t hdr[record_header_len];
+  std::memcpy(hdr, record_magic, 4);
+  put_le(hdr + 4, len, 4);
+  put_le(hdr + 8, time_us, 8);
+  put_le(hdr + 16, sample_start, 8);
+  const size_t start = d_buf.size();
+  d_buf.insert(d_buf.end(), hdr, hdr + record_header_len);
+  d_buf.insert(d_buf.end(), data, data + len);
+
+  /* The CRC covers the whole record, except the marker */
+  uint8_t c[record_crc_len];
+  put_le(c, crc::crc32_c(&d_buf[start + 4], record_header_len - 4 + len),
+         record_crc_len);
+  d_buf.insert(d_buf.end(), c, c + record_crc_len);
+  d_offset += record_len;
+
+  if (d_buf.size() >= d_flush_size) {
+    d_cond.notify_one();
+  }
+}
+
+/*
+ * Writes the pending records synchronously. The caller should hold d_mtx
+ */
+void
+frame_store_writer::write_pending()
+{
+  std::lock_guard<std::mutex> io(d_io_mtx);
+  d_file.write(reinterpret_cast<const char *>(d_buf.data()), d_buf.size());
+  d_file.flush();
+  d_buf.clear();
+}
+
+/**
+ * Writes the pending records to the segment file
+ */
+void
+frame_store_writer::flush()
+{
+  std::lock_guard<std::mutex> lock(d_mtx);
+  if (d_open) {
+    write_pending();
+  }
+}
+
+/*
+ * Appends the index to the current segment and closes it. The caller should
+ * hold d_mtx
+ */
+void
+frame_store_writer::close_segment()
+{
+  if (!d_open) {
+    return;
+  }
+  const uint64_t index_offset = d_offset;
+  uint8_t entry[index_entry_len];
+  for (const index_entry &e : d_index) {
+    put_le(entry, e.offset, 8);
+    put_le(entry + 8, e.time_us, 8);
+    put_le(entry + 16, e.sample_start, 8);
+    d_buf.insert(d_buf.end(), entry, entry + index_entry_len);
+  }
+  uint8_t trailer[trailer_len];
+  put_le(trailer, index_offset, 8);
+  put_le(trailer + 8, d_index.size(), 8);
+  std::memcpy(trailer + 16, index_magic, 4);
+  d_buf.insert(d_buf.end(), trailer, trailer + trailer_len);
+
+  write_pending();
+  {
+    std::lock_guard<std::mutex> io(d_io_mtx);
+    d_file.close();
+  }
+  d_open = false;
+  d_index.clear();
+}
+
+/**
+ * Appends the index to the current segment and closes it. The next frame
+ * starts a new segment.
+ */
+void
+frame_store_writer::close()
+{
+  std::lock_guard<std::mutex> lock(d_mtx);
+  close_segment();
+}
+
+/*
+ * Background thread writing the pending records, when they exceed the
+ * flush size or when the flush interval expires. The file is written
+ * without holding d_mtx, so append() is never blocked by the disk
+ */
+void
+frame_store_writer::flusher()
+{
+  std::unique_lock<std::mutex> lock(d_mtx);
+  while (!d_stop) {
+    d_cond.wait_for(lock, d_flush_interval, [this] {
+      return d_stop || d_buf.size() >= d_flush_size;
+    });
+    if (!d_open || d_buf.empty()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> io(d_io_mtx);
+    d_out.swap(d_buf);
+    lock.unlock();
+    d_file.write(reinterpret_cast<const char *>(d_out.data()), d_out.size());
+    d_file.flush();
+    d_out.clear();
+    io.unlock();
+    lock.lock();
+  }
+}
+
+/**
+ * Opens a segment file for reading
+ * @param filename the segment file
+ */
+frame_store_reader::frame_store_reader(const std::string &filename) :
+  d_file(filename, std::ios::binary)
+{
+  if (!d_file) {
+    throw std::runtime_error("frame_store_reader: could not open " + filename);
+  }
+  d_file.seekg(0, std::ios::end);
+  d_file_size = d_file.tellg();
+
+  uint8_t hdr[header_len];
+  d_file.seekg(0);
+  if (d_file_size < header_len
+      || !d_file.read(reinterpret_cast<char *>(hdr), header_len)
+      || std::memcmp(hdr, header_magic, 4) != 0) {
+    throw std::runtime_error("frame_store_reader: not a frame store segment");
+  }
+  if (get_le(hdr + 4, 4) != format_version) {
+    throw std::runtime_error("frame_store_reader: unsupported version");
+  }
+
+  if (!load_index()) {
+    d_offset.clear();
+    d_by_time.clear();
+    d_by_sample.clear();
+    scan();
+  }
+
+  /*
+   * The frames are not necessarily in time or sample order, so the seeks
+   * use sorted copies of the keys
+   */
+  std::sort(d_by_time.begin(), d_by_time.end());
+  std::sort(d_by_sample.begin(), d_by_sample.end());
+}
+
+/*
+ * Adds a record to the index and to the seek tables. Records with an
+ * unknown sample index are left out of the sample table
+ */
+void
+frame_store_reader::add(uint64_t offset, uint64_t time_us,
+                        uint64_t sample_start)
+{
+  const size_t idx = d_offset.size();
+  d_offset.push_back(offset);
+  d_by_time.push_back(key_t(time_us, idx));
+  if (sample_start != unknown_sample) {
+    d_by_sample.push_back(key_t(sample_start, idx));
+  }
+}
+
+/**
+ * Loads the index from the end of the segment
+ * @return true if the segment has a valid index
+ */
+bool
+frame_store_reader::load_index()
+{
+  if (d_file_size < header_len + trailer_len) {
+    return false;
+  }
+  uint8_t trailer[trailer_len];
+  d_file.seekg(d_file_size - trailer_len);
+  if (!d_file.read(reinterpret_cast<char *>(trailer), trailer_len)
+      || std::memcmp(trailer + 16, index_magic, 4) != 0) {
+    d_file.clear();
+    return false;
+  }
+  const uint64_t index_offset = get_le(trailer, 8);
+  const uint64_t n = get_le(trailer + 8, 8);
+  if (index_offset < header_len
+      || index_offset + n * index_entry_len + trailer_len != d_file_size) {
+    return false;
+  }
+
+  std::vector<uint8_t> index(n * index_entry_len);
+  d_file.seekg(index_offset);
+  if (!d_file.read(reinterpret_cast<char *>(index.data()), index.size())) {
+    d_file.clear();
+    return false;
+  }
+  for (uint64_t i = 0; i < n; i++) {
+    const uint8_t *e = &index[i * index_entry_len];
+    add(get_le(e, 8), get_le(e + 8, 8), get_le(e + 16, 8));
+  }
+  return true;
+}
+
+/**
+ * Reads a whole record and checks its marker and CRC
+ * @param offset the offset of the record
+ * @param rec buffer that will hold the record
+ * @return true if the record is complete and valid
+ */
+bool
+frame_store_reader::read_record(uint64_t offset, std::vector<uint8_t> &rec)
+{
+  uint8_t hdr[record_header_len];
+  if (offset + record_header_len + record_crc_len > d_file_size) {
+    return false;
+  }
+  d_file.seekg(offset);
+  if (!d_file.read(reinterpret_cast<char *>(hdr), record_header_len)
+      || std::memcmp(hdr, record_magic, 4) != 0) {
+    d_file.clear();
+    return false;
+  }
+  const uint64_t len = get_le(hdr + 4, 4);
+  if (offset + record_header_len + len + record_crc_len > d_file_size) {
+    return false;
+  }
+  rec.assign(hdr, hdr + record_header_len);
+  rec.resize(record_header_len + len + record_crc_len);
+  if (!d_file.read(reinterpret_cast<char *>(&rec[record_header_len]),
+                   len + record_crc_len)) {
+    d_file.clear();
+    return false;
+  }
+  return crc::crc32_c(&rec[4], record_header_len - 4 + len)
+         == get_le(&rec[record_header_len + len], record_crc_len);
+}
+
+/**
+ * Rebuilds the index of a segment that was not closed, from the records
+ * it contains. The scan stops at the first record that is incomplete or
+ * invalid, e.g. the partially written index of an interrupted close
+ */
+void
+frame_store_reader::scan()
+{
+  uint64_t offset = header_len;
+  std::vector<uint8_t> rec;
+  while (read_record(offset, rec)) {
+    add(offset, get_le(&rec[8], 8), get_le(&rec[16], 8));
+    offset += rec.size();
+  }
+  d_file.clear();
+}
+
+/**
+ *
+ * @return the number of frames in the segment
+ */
+size_t
+frame_store_reader::size() const
+{
+  return d_offset.size();
+}
+
+/**
+ * Reads a frame
+ * @param idx the index of the frame in the segment
+ * @return the frame and its time and sample index
+ */
+frame_store_record
+frame_store_reader::read(size_t idx)
+{
+  if (idx >= d_offset.size()) {
+    throw std::out_of_range("frame_store_reader: invalid frame index");
+  }
+  std::vector<uint8_t> rec;
+  if (!read_record(d_offset[idx], rec)) {
+    throw std::runtime_error("frame_store_reader: corrupted record");
+  }
+
+  frame_store_record r;
+  r.time_us = get_le(&rec[8], 8);
+  r.sample_start = get_le(&rec[16], 8);
+  r.data.assign(rec.begin() + record_header_len, rec.end() - record_crc_len);
+  return r;
+}
+
+/*
+ * Returns the record with the smallest key that is greater or equal to
+ * key. Among records with the same key, the first in the segment is
+ * returned
+ */
+size_t
+frame_store_reader::find(const std::vector<key_t> &v, uint64_t key, size_t n)
+{
+  std::vector<key_t>::const_iterator it = std::lower_bound(v.begin(),
+                                          v.end(), key_t(key, 0));
+  return it == v.end() ? n : it->second;
+}
+
+/**
+ * Seeks by time. The frames are not necessarily stored in time order, as
+ * the wall clock may jump backwards, so the frames stored after the one
+ * returned may include earlier ones.
+ * @param time_us UTC time in microseconds since the epoch
+ * @return the index of the earliest frame received at or after
+ * @a time_us, or size() if there is none
+ */
+size_t
+frame_store_reader::find_time(uint64_t time_us) const
+{
+  return find(d_by_time, time_us, d_offset.size());
+}
+
+/**
+ * Seeks by sample index. The frames are not necessarily stored in sample
+ * order. The seek uses the frames sorted by sample index. Frames with an
+ * unknown sample index are never returned.
+ * @param sample the index of a sample
+ * @return the index of the frame that starts first at or after
+ * @a sample, or size() if there is none
+ */
+size_t
+frame_store_reader::find_sample(uint64_t sample) const
+{
+  return find(d_by_sample, sample, d_offset.size());
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
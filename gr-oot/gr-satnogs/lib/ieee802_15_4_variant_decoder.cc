@@ -225,8 +225,8 @@ ieee802_15_4_variant_decoder::search_preamble(const uint8_t *in, int len)
 {
   for (int i = 0; i < len; i++) {
     d_preamble_shift_reg <<= in[i];
-    shift_reg tmp = d_preamble_shift_reg ^ d_preamble;
-    if (tmp.count() <= d_preamble_thrsh) {
+    if (d_preamble_shift_reg.hamming_distance(d_preamble)
+        <= d_preamble_thrsh) {
       d_state = SEARCHING_SYNC;
       d_frame_start_idx = nitems_read() + i + 1;
       d_cnt = 0;
@@ -241,9 +241,8 @@ ieee802_15_4_variant_decoder::search_sync(const uint8_t *in, int len)
 {
   for (int i = 0; i < len; i++) {
     d_sync_shift_reg <<= in[i];
-    shift_reg tmp = d_sync_shift_reg ^ d_sync;
     d_cnt++;
-    if (tmp.count() <= d_sync_thrsh) {
+    if (d_sync_shift_reg.hamming_distance(d_sync) <= d_sync_thrsh) {
       if (d_var_len) {
         d_state = DECODING_GENERIC_FRAME_LEN;
       }
@@ -25,26 +25,40 @@
 #include <gnuradio/io_signature.h>
 #include "json_converter_impl.h"
 #include <satnogs/metadata.h>
-#include <nlohmann/json.hpp>
 
 
 namespace gr {
 namespace satnogs {
 
 json_converter::sptr
-json_converter::make(const std::string &extra)
+json_converter::make(const std::string &extra, bool compact)
 {
-  return gnuradio::get_initial_sptr(new json_converter_impl(extra));
+  return gnuradio::get_initial_sptr(new json_converter_impl(extra, compact));
 }
 
 /*
  * The private constructor
  */
-json_converter_impl::json_converter_impl(const std::string &extra) :
+json_converter_impl::json_converter_impl(const std::string &extra,
+    bool compact) :
   gr::block("json_converter", gr::io_signature::make(0, 0, 0),
             gr::io_signature::make(0, 0, 0)),
-  d_extra(extra)
+  d_extra(extra),
+  d_compact(compact),
+  d_has_extra(false)
 {
+  /* The extra field is the same for all frames, so parse it only once */
+  try {
+    d_extra_json = nlohmann::json::parse(d_extra);
+    d_has_extra = true;
+  }
+  catch (std::exception &e) {
+
+  }
+  if (d_has_extra) {
+    d_extra_member = "\"extra\":" + d_extra_json.dump();
+  }
+
   message_port_register_in(pmt::mp("in"));
   message_port_register_out(pmt::mp("out"));
 
@@ -64,13 +78,23 @@ json_converter_impl::~json_converter_impl()
 void
 json_converter_impl::convert(pmt::pmt_t m)
 {
-  nlohmann::json j = metadata::to_json(m);
-  try {
-    nlohmann::json extra = nlohmann::json::parse(d_extra);
-    j["extra"] = extra;
+  d_frame.parse(m);
+  if (d_compact) {
+    /*
+     * Write the JSON directly into a buffer that is reused for every frame.
+     * The only copy is the one into the output blob
+     */
+    d_buf.clear();
+    d_frame.write_json(d_buf, d_extra_member);
+    d_buf += '\n';
+    message_port_pub(pmt::mp("out"), pmt::make_blob(d_buf.data(),
+                     d_buf.size()));
+    return;
   }
-  catch (std::exception &e) {
 
+  nlohmann::json j = d_frame.to_json();
+  if (d_has_extra) {
+    j["extra"] = d_extra_json;
   }
   /* Covert it to string ensuring ASCII conpatibility */
   const std::string &s = j.dump(4, ' ', true);
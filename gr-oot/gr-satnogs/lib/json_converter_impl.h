@@ -22,6 +22,8 @@
 #define INCLUDED_SATNOGS_JSON_CONVERTER_IMPL_H
 
 #include <satnogs/json_converter.h>
+#include <satnogs/frame_metadata.h>
+#include <nlohmann/json.hpp>
 
 namespace gr {
 namespace satnogs {
@@ -29,7 +31,7 @@ namespace satnogs {
 class json_converter_impl : public json_converter {
 
 public:
-  json_converter_impl(const std::string &extra);
+  json_converter_impl(const std::string &extra, bool compact);
   ~json_converter_impl();
 
   void
@@ -37,6 +39,12 @@ public:
 
 private:
   const std::string d_extra;
+  const bool        d_compact;
+  nlohmann::json    d_extra_json;
+  bool              d_has_extra;
+  std::string       d_extra_member;
+  frame_metadata    d_frame;
+  std::string       d_buf;
 };
 
 } // namespace satnogs
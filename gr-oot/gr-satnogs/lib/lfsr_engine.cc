@@ -0,0 +1,263 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <satnogs/lfsr_engine.h>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+namespace gr {
+namespace satnogs {
+
+/*
+ * The effect of each byte of the register and of the input on the register
+ * and on the output after 64 and 8 steps. As the LFSR is linear, the new
+ * register and the output are the XOR of the contributions of all bytes.
+ */
+struct lfsr_engine::tables {
+  uint64_t state64[8][256];
+  uint64_t out64[8][256];
+  uint64_t in_state64[8][256];
+  uint64_t in_out64[8][256];
+  uint64_t state8[8][256];
+  uint8_t  out8[8][256];
+  uint64_t in_state8[256];
+  uint8_t  in_out8[256];
+
+  tables(uint64_t mask, uint32_t order, bool msb, mode_t mode);
+};
+
+/*
+ * Runs the LFSR for nbits steps. Bit t of the input and the output words is
+ * the t-th bit in time, inside bytes ordered according to msb
+ */
+static uint64_t
+run(uint64_t &reg, uint64_t in, size_t nbits, uint64_t mask, uint32_t order,
+    bool msb, lfsr_engine::mode_t mode)
+{
+  uint64_t out = 0;
+  for (size_t t = 0; t < nbits; t++) {
+    const size_t pos = msb ? (t & ~7UL) | (7 - (t & 7)) : t;
+    const uint64_t b = (in >> pos) & 1;
+    const uint64_t fb = __builtin_parityll(reg & mask);
+    uint64_t o;
+    switch (mode) {
+    case lfsr_engine::ADDITIVE:
+      o = reg & 1;
+      reg = (reg >> 1) | (fb << order);
+      break;
+    case lfsr_engine::SCRAMBLE:
+      o = reg & 1;
+      reg = (reg >> 1) | ((fb ^ b) << order);
+      break;
+    default:
+      o = fb ^ b;
+      reg = (reg >> 1) | (b << order);
+      break;
+    }
+    out |= o << pos;
+  }
+  return out;
+}
+
+lfsr_engine::tables::tables(uint64_t mask, uint32_t order, bool msb,
+                            mode_t mode)
+{
+  for (size_t k = 0; k < 8; k++) {
+    for (uint64_t v = 0; v < 256; v++) {
+      uint64_t reg = v << (8 * k);
+      out64[k][v] = run(reg, 0, 64, mask, order, msb, mode);
+      state64[k][v] = reg;
+      reg = v << (8 * k);
+      out8[k][v] = run(reg, 0, 8, mask, order, msb, mode);
+      state8[k][v] = reg;
+
+      /* In additive mode the input is XOR-ed directly to the output */
+      if (mode == ADDITIVE) {
+        continue;
+      }
+      reg = 0;
+      in_out64[k][v] = run(reg, v << (8 * k), 64, mask, order, msb, mode);
+      in_state64[k][v] = reg;
+      if (k == 0) {
+        reg = 0;
+        in_out8[v] = run(reg, v, 8, mask, order, msb, mode);
+        in_state8[v] = reg;
+      }
+    }
+  }
+}
+
+/**
+ * Creates an LFSR
+ * @param mask the polynomial mask
+ * @param seed the initial seed
+ * @param order the order of the shift register. This is equal to the
+ * number of memory stages.
+ * @param msb set to true to process the bits of each byte starting from the
+ * most significant one
+ */
+lfsr_engine::lfsr_engine(uint64_t mask, uint64_t seed, uint32_t order,
+                         bool msb) :
+  d_mask(mask),
+  d_seed(seed),
+  d_order(order),
+  d_msb(msb),
+  d_reg_bytes(order / 8 + 1),
+  d_reg(seed)
+{
+  if (order > 63) {
+    throw std::invalid_argument("lfsr_engine: order should be less than 64");
+  }
+}
+
+/**
+ * Resets the register to the initial seed
+ */
+void
+lfsr_engine::reset()
+{
+  d_reg = d_seed;
+}
+
+/**
+ * Additive scrambling or descrambling. The input is XOR-ed with the
+ * sequence of the LFSR
+ * @param out the output buffer
+ * @param in the input buffer. It can be the same as the output buffer
+ * @param len the number of bytes
+ */
+void
+lfsr_engine::additive(uint8_t *out, const uint8_t *in, size_t len)
+{
+  process(ADDITIVE, out, in, len);
+}
+
+/**
+ * Self-synchronizing scrambling. The input is also fed to the register
+ * @param out the output buffer
+ * @param in the input buffer. It can be the same as the output buffer
+ * @param len the number of bytes
+ */
+void
+lfsr_engine::scramble(uint8_t *out, const uint8_t *in, size_t len)
+{
+  process(SCRAMBLE, out, in, len);
+}
+
+/**
+ * Self-synchronizing descrambling
+ * @param out the output buffer
+ * @param in the input buffer. It can be the same as the output buffer
+ * @param len the number of bytes
+ */
+void
+lfsr_engine::descramble(uint8_t *out, const uint8_t *in, size_t len)
+{
+  process(DESCRAMBLE, out, in, len);
+}
+
+const lfsr_engine::tables &
+lfsr_engine::get_tables(mode_t mode)
+{
+  if (!d_tables[mode]) {
+    typedef std::tuple<uint64_t, uint32_t, bool, int> key_t;
+    static std::mutex mtx;
+    static std::map<key_t, std::shared_ptr<const tables>> cache;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<const tables> &t =
+      cache[key_t(d_mask, d_order, d_msb, mode)];
+    if (!t) {
+      t = std::make_shared<const tables>(d_mask, d_order, d_msb, mode);
+    }
+    d_tables[mode] = t;
+  }
+  return *d_tables[mode];
+}
+
+void
+lfsr_engine::process(mode_t mode, uint8_t *out, const uint8_t *in,
+                     size_t len)
+{
+  const tables &t = get_tables(mode);
+
+  while (len >= 8) {
+    uint64_t x;
+    memcpy(&x, in, sizeof(x));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    uint64_t reg = 0;
+    uint64_t o = 0;
+    for (size_t k = 0; k < d_reg_bytes; k++) {
+      const uint8_t b = d_reg >> (8 * k);
+      reg ^= t.state64[k][b];
+      o ^= t.out64[k][b];
+    }
+    if (mode == ADDITIVE) {
+      o ^= x;
+    }
+    else {
+      for (size_t k = 0; k < 8; k++) {
+        const uint8_t b = x >> (8 * k);
+        reg ^= t.in_state64[k][b];
+        o ^= t.in_out64[k][b];
+      }
+    }
+    d_reg = reg;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    o = __builtin_bswap64(o);
+#endif
+    memcpy(out, &o, sizeof(o));
+    in += 8;
+    out += 8;
+    len -= 8;
+  }
+
+  while (len--) {
+    uint64_t reg = 0;
+    uint8_t o = 0;
+    for (size_t k = 0; k < d_reg_bytes; k++) {
+      const uint8_t b = d_reg >> (8 * k);
+      reg ^= t.state8[k][b];
+      o ^= t.out8[k][b];
+    }
+    if (mode == ADDITIVE) {
+      o ^= *in;
+    }
+    else {
+      reg ^= t.in_state8[*in];
+      o ^= t.in_out8[*in];
+    }
+    d_reg = reg;
+    *out++ = o;
+    in++;
+  }
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
@@ -10,15 +10,14 @@
 char *Cpu_modes[] = {"Unknown", "Portable C", "x86 Multi Media Extensions (MMX)",
                      "x86 Streaming SIMD Extensions (SSE)",
                      "x86 Streaming SIMD Extensions 2 (SSE2)",
-                     "PowerPC G4/G5 Altivec/Velocity Engine"
+                     "PowerPC G4/G5 Altivec/Velocity Engine",
+                     "x86 Advanced Vector Extensions 2 (AVX2)"
                     };
 
 enum cpu_mode Cpu_mode;
 
 void find_cpu_mode(void)
 {
-
-  int f;
   if (Cpu_mode != UNKNOWN) {
     return;
   }
@@ -26,5 +25,11 @@ void find_cpu_mode(void)
   /* According to the wikipedia entry x86-64, all x86-64 processors have SSE2 */
   /* The same assumption is also in other source files ! */
   Cpu_mode = SSE2;
-  fprintf(stderr, "CPU: x86-64, using portable C implementation\n");
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    Cpu_mode = AVX2;
+  }
+#endif
+  fprintf(stderr, "SIMD CPU detect: %s\n", Cpu_modes[Cpu_mode]);
 }
@@ -15,6 +15,12 @@ void *create_viterbi27(int len)
   case PORT:
   default:
     return create_viterbi27_port(len);
+#ifdef __x86_64__
+  case SSE2:
+    return create_viterbi27_sse2(len);
+  case AVX2:
+    return create_viterbi27_avx2(len);
+#endif
   }
 }
 
@@ -25,6 +31,14 @@ void set_viterbi27_polynomial(int polys[2])
   default:
     set_viterbi27_polynomial_port(polys);
     break;
+#ifdef __x86_64__
+  case SSE2:
+    set_viterbi27_polynomial_sse2(polys);
+    break;
+  case AVX2:
+    set_viterbi27_polynomial_avx2(polys);
+    break;
+#endif
   }
 }
 
@@ -35,6 +49,12 @@ int init_viterbi27(void *p, int starting_state)
   case PORT:
   default:
     return init_viterbi27_port(p, starting_state);
+#ifdef __x86_64__
+  case SSE2:
+    return init_viterbi27_sse2(p, starting_state);
+  case AVX2:
+    return init_viterbi27_avx2(p, starting_state);
+#endif
   }
 }
 
@@ -50,6 +70,12 @@ int chainback_viterbi27(
   case PORT:
   default:
     return chainback_viterbi27_port(p, data, nbits, endstate);
+#ifdef __x86_64__
+  case SSE2:
+    return chainback_viterbi27_sse2(p, data, nbits, endstate);
+  case AVX2:
+    return chainback_viterbi27_avx2(p, data, nbits, endstate);
+#endif
   }
 }
 
@@ -57,7 +83,17 @@ int
 chainback_viterbi27_unpacked_trunc(void *p, unsigned char *data,
                                    unsigned int nbits)
 {
-  return chainback_viterbi27_port_unpacked_trunc(p, data, nbits);
+  switch (Cpu_mode) {
+  case PORT:
+  default:
+    return chainback_viterbi27_port_unpacked_trunc(p, data, nbits);
+#ifdef __x86_64__
+  case SSE2:
+    return chainback_viterbi27_sse2_unpacked_trunc(p, data, nbits);
+  case AVX2:
+    return chainback_viterbi27_avx2_unpacked_trunc(p, data, nbits);
+#endif
+  }
 }
 
 /* Delete instance of a Viterbi decoder */
@@ -68,6 +104,14 @@ void delete_viterbi27(void *p)
   default:
     delete_viterbi27_port(p);
     break;
+#ifdef __x86_64__
+  case SSE2:
+    delete_viterbi27_sse2(p);
+    break;
+  case AVX2:
+    delete_viterbi27_avx2(p);
+    break;
+#endif
   }
 }
 
@@ -86,6 +130,14 @@ int update_viterbi27_blk(void *p, unsigned char syms[], int nbits)
   default:
     update_viterbi27_blk_port(p, syms, nbits);
     break;
+#ifdef __x86_64__
+  case SSE2:
+    update_viterbi27_blk_sse2(p, syms, nbits);
+    break;
+  case AVX2:
+    update_viterbi27_blk_avx2(p, syms, nbits);
+    break;
+#endif
   }
   return 0;
 }
@@ -0,0 +1,259 @@
+/* K=7 r=1/2 Viterbi decoder for x86-64 AVX2
+ *
+ * Based on the SSE2 version, Feb 2004, Phil Karn, KA9Q
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <immintrin.h>
+#include "fec.h"
+
+typedef union {
+  unsigned char c[64];
+  __m256i v[2];
+} metric_t;
+typedef union {
+  unsigned int w[2];
+  unsigned char c[8];
+} decision_t;
+static union branchtab27 {
+  unsigned char c[32];
+  __m256i v[1];
+} Branchtab27_avx2[2];
+static int Init = 0;
+
+/* State info for instance of Viterbi decoder */
+struct v27 {
+  metric_t metrics1; /* path metric buffer 1 */
+  metric_t metrics2; /* path metric buffer 2 */
+  decision_t *dp;          /* Pointer to current decision */
+  metric_t *old_metrics,
+           *new_metrics; /* Pointers to path metrics, swapped on every bit */
+  decision_t *decisions;   /* Beginning of decisions for block */
+};
+
+/* Initialize Viterbi decoder for start of new frame */
+int init_viterbi27_avx2(void *p, int starting_state)
+{
+  struct v27 *vp = p;
+  int i;
+
+  if (p == NULL) {
+    return -1;
+  }
+  for (i = 0; i < 64; i++) {
+    vp->metrics1.c[i] = 63;
+  }
+
+  vp->old_metrics = &vp->metrics1;
+  vp->new_metrics = &vp->metrics2;
+  vp->dp = vp->decisions;
+  vp->old_metrics->c[starting_state & 63] = 0; /* Bias known start state */
+  return 0;
+}
+
+void set_viterbi27_polynomial_avx2(int polys[2])
+{
+  int state;
+
+  for (state = 0; state < 32; state++) {
+    Branchtab27_avx2[0].c[state] = (polys[0] < 0) ^ parity((2 * state) & abs(
+                                     polys[0])) ? 255 : 0;
+    Branchtab27_avx2[1].c[state] = (polys[1] < 0) ^ parity((2 * state) & abs(
+                                     polys[1])) ? 255 : 0;
+  }
+  Init++;
+}
+
+/* Create a new instance of a Viterbi decoder */
+void *create_viterbi27_avx2(int len)
+{
+  void *p;
+  struct v27 *vp;
+
+  if (!Init) {
+    int polys[2] = { V27POLYA, V27POLYB };
+    set_viterbi27_polynomial_avx2(polys);
+  }
+  if (posix_memalign(&p, sizeof(__m256i), sizeof(struct v27))) {
+    return NULL;
+  }
+  vp = (struct v27 *)p;
+
+  if ((p = malloc((len + 6) * sizeof(decision_t))) == NULL) {
+    free(vp);
+    return NULL;
+  }
+  vp->decisions = (decision_t *)p;
+  init_viterbi27_avx2(vp, 0);
+
+  return vp;
+}
+
+/* Viterbi chainback */
+int chainback_viterbi27_avx2(
+  void *p,
+  unsigned char *data, /* Decoded output data */
+  unsigned int nbits, /* Number of data bits */
+  unsigned int endstate)  /* Terminal encoder state */
+{
+  struct v27 *vp = p;
+  decision_t *d;
+
+  if (p == NULL) {
+    return -1;
+  }
+  d = vp->decisions;
+  /* Make room beyond the end of the encoder register so we can
+   * accumulate a full byte of decoded data
+   */
+  endstate %= 64;
+  endstate <<= 2;
+
+  /* The store into data[] only needs to be done every 8 bits.
+   * But this avoids a conditional branch, and the writes will
+   * combine in the cache anyway
+   */
+  d += 6; /* Look past tail */
+  while (nbits-- != 0) {
+    int k;
+
+    k = (d[nbits].c[(endstate >> 2) / 8] >> ((endstate >> 2) % 8)) & 1;
+    data[nbits >> 3] = endstate = (endstate >> 1) | (k << 7);
+  }
+  return 0;
+}
+
+int
+chainback_viterbi27_avx2_unpacked_trunc(void *p, unsigned char *data,
+                                        unsigned int nbits)
+{
+  struct v27 *vp = p;
+  decision_t *d;
+  unsigned int endstate;
+  unsigned char min;
+  int i, min_idx = 0;
+
+  if (p == NULL) {
+    return -1;
+  }
+  d = vp->decisions;
+
+  /* Find the state with the minimum weight */
+  min = vp->old_metrics->c[0];
+  for (i = 1; i < 64; i++) {
+    if (vp->old_metrics->c[i] < min) {
+      min = vp->old_metrics->c[i];
+      min_idx = i;
+    }
+  }
+  endstate = min_idx;
+  endstate <<= 2;
+
+  while (nbits-- != 0) {
+    int k;
+
+    k = (d[nbits].c[(endstate >> 2) / 8] >> ((endstate >> 2) % 8)) & 1;
+    endstate = (endstate >> 1) | (k << 7);
+    data[nbits] = k;
+  }
+  return min_idx;
+}
+
+/* Delete instance of a Viterbi decoder */
+void delete_viterbi27_avx2(void *p)
+{
+  struct v27 *vp = p;
+
+  if (vp != NULL) {
+    free(vp->decisions);
+    free(vp);
+  }
+}
+
+/*
+ * Same metric arithmetic as the SSE2 version, but all 32 butterflies of a
+ * trellis step are computed at once. The AVX2 unpack instructions operate
+ * on each 128-bit lane separately, so the interleaved survivors and
+ * decisions are put back in state order with a cross-lane permute.
+ */
+int update_viterbi27_blk_avx2(void *p, unsigned char *syms, int nbits)
+{
+  struct v27 *vp = p;
+  decision_t *d;
+  const __m256i thirtyones = _mm256_set1_epi8(31);
+
+  if (p == NULL) {
+    return -1;
+  }
+  d = (decision_t *)vp->dp;
+  while (nbits--) {
+    __m256i sym0v, sym1v;
+    __m256i decision0, decision1, metric, m_metric, m0, m1, m2, m3, survivor0,
+            survivor1, lo, hi;
+    void *tmp;
+
+    /* Splat the 0th symbol across sym0v, the 1st symbol across sym1v */
+    sym0v = _mm256_set1_epi8(syms[0]);
+    sym1v = _mm256_set1_epi8(syms[1]);
+    syms += 2;
+
+    /* Form 5-bit branch metrics */
+    metric = _mm256_avg_epu8(_mm256_xor_si256(Branchtab27_avx2[0].v[0], sym0v),
+                             _mm256_xor_si256(Branchtab27_avx2[1].v[0], sym1v));
+    metric = _mm256_srli_epi16(metric, 3);
+    metric = _mm256_and_si256(metric, thirtyones);
+    m_metric = _mm256_xor_si256(metric, thirtyones);
+
+    /* Add branch metrics to path metrics */
+    m0 = _mm256_adds_epu8(vp->old_metrics->v[0], metric);
+    m3 = _mm256_adds_epu8(vp->old_metrics->v[1], metric);
+    m1 = _mm256_adds_epu8(vp->old_metrics->v[1], m_metric);
+    m2 = _mm256_adds_epu8(vp->old_metrics->v[0], m_metric);
+
+    /* Compare and select */
+    survivor0 = _mm256_min_epu8(m0, m1);
+    survivor1 = _mm256_min_epu8(m2, m3);
+    decision0 = _mm256_cmpeq_epi8(survivor0, m1);
+    decision1 = _mm256_cmpeq_epi8(survivor1, m3);
+
+    /* Interleave the decisions and pack them into 32 bits per half */
+    lo = _mm256_unpacklo_epi8(decision0, decision1);
+    hi = _mm256_unpackhi_epi8(decision0, decision1);
+    d->w[0] = _mm256_movemask_epi8(_mm256_permute2x128_si256(lo, hi, 0x20));
+    d->w[1] = _mm256_movemask_epi8(_mm256_permute2x128_si256(lo, hi, 0x31));
+
+    /* Interleave and store the surviving metrics */
+    lo = _mm256_unpacklo_epi8(survivor0, survivor1);
+    hi = _mm256_unpackhi_epi8(survivor0, survivor1);
+    vp->new_metrics->v[0] = _mm256_permute2x128_si256(lo, hi, 0x20);
+    vp->new_metrics->v[1] = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+    /* See if we have to normalize, same threshold as sse2bfly27.s */
+    if (vp->new_metrics->c[0] > 105) {
+      __m256i adjustv;
+      __m128i minv;
+
+      /* Find smallest metric and subtract it from all metrics */
+      adjustv = _mm256_min_epu8(vp->new_metrics->v[0], vp->new_metrics->v[1]);
+      minv = _mm_min_epu8(_mm256_castsi256_si128(adjustv),
+                          _mm256_extracti128_si256(adjustv, 1));
+      minv = _mm_min_epu8(minv, _mm_srli_si128(minv, 8));
+      minv = _mm_min_epu8(minv, _mm_srli_si128(minv, 4));
+      minv = _mm_min_epu8(minv, _mm_srli_si128(minv, 2));
+      minv = _mm_min_epu8(minv, _mm_srli_si128(minv, 1));
+      adjustv = _mm256_set1_epi8(_mm_cvtsi128_si32(minv) & 0xff);
+
+      vp->new_metrics->v[0] = _mm256_subs_epu8(vp->new_metrics->v[0], adjustv);
+      vp->new_metrics->v[1] = _mm256_subs_epu8(vp->new_metrics->v[1], adjustv);
+    }
+    d++;
+    /* Swap pointers to old and new metrics */
+    tmp = vp->old_metrics;
+    vp->old_metrics = vp->new_metrics;
+    vp->new_metrics = tmp;
+  }
+  vp->dp = d;
+  return 0;
+}
@@ -4,7 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
-#include <xmmintrin.h>
+#include <emmintrin.h>
 #include "fec.h"
 
 typedef union {
@@ -12,10 +12,9 @@ typedef union {
   __m128i v[4];
 } metric_t;
 typedef union {
-  unsigned long w[2];
+  unsigned int w[2];
   unsigned char c[8];
   unsigned short s[4];
-  __m64 v[1];
 } decision_t;
 union branchtab27 {
   unsigned char c[32];
@@ -141,15 +140,58 @@ void delete_viterbi27_sse2(void *p)
 }
 
 
-#if 0
-/* This code is turned off because it's slower than my hand-crafted assembler in sse2bfly27.s. But it does work. */
-void update_viterbi27_blk_sse2(void *p, unsigned char *syms, int nbits)
+int
+chainback_viterbi27_sse2_unpacked_trunc(void *p, unsigned char *data,
+                                        unsigned int nbits)
 {
   struct v27 *vp = p;
   decision_t *d;
+  unsigned int endstate;
+  unsigned char min;
+  int i, min_idx = 0;
 
   if (p == NULL) {
-    return;
+    return -1;
+  }
+  d = vp->decisions;
+
+  /* Find the state with the minimum weight */
+  min = vp->old_metrics->c[0];
+  for (i = 1; i < 64; i++) {
+    if (vp->old_metrics->c[i] < min) {
+      min = vp->old_metrics->c[i];
+      min_idx = i;
+    }
+  }
+  endstate = min_idx;
+  endstate <<= 2;
+
+  while (nbits-- != 0) {
+    int k;
+
+    k = (d[nbits].c[(endstate >> 2) / 8] >> ((endstate >> 2) % 8)) & 1;
+    endstate = (endstate >> 1) | (k << 7);
+    data[nbits] = k;
+  }
+  return min_idx;
+}
+
+#ifdef __x86_64__
+/*
+ * The i386 build uses the hand-crafted assembler in sse2bfly27.s. Shared
+ * libraries on x86-64 have to be position independent, so instead of porting
+ * the assembler we use the same algorithm expressed with intrinsics:
+ * saturating unsigned 8-bit path metrics with 5-bit branch metrics and
+ * renormalization when the first metric exceeds 105.
+ */
+int update_viterbi27_blk_sse2(void *p, unsigned char *syms, int nbits)
+{
+  struct v27 *vp = p;
+  decision_t *d;
+  const __m128i thirtyones = _mm_set1_epi8(31);
+
+  if (p == NULL) {
+    return -1;
   }
   d = (decision_t *)vp->dp;
   while (nbits--) {
@@ -169,26 +211,22 @@ void update_viterbi27_blk_sse2(void *p, unsigned char *syms, int nbits)
       /* Form branch metrics */
       metric = _mm_avg_epu8(_mm_xor_si128(Branchtab27_sse2[0].v[i], sym0v),
                             _mm_xor_si128(Branchtab27_sse2[1].v[i], sym1v));
-      /* There's no packed bytes right shift in SSE2, so we use the word version and mask
-       * (I'm *really* starting to like Altivec...)
-       */
+      /* There's no packed bytes right shift in SSE2, so we use the word version and mask */
       metric = _mm_srli_epi16(metric, 3);
-      metric = _mm_and_si128(metric, _mm_set1_epi8(31));
-      m_metric = _mm_sub_epi8(_mm_set1_epi8(31), metric);
+      metric = _mm_and_si128(metric, thirtyones);
+      m_metric = _mm_xor_si128(metric, thirtyones);
 
       /* Add branch metrics to path metrics */
-      m0 = _mm_add_epi8(vp->old_metrics->v[i], metric);
-      m3 = _mm_add_epi8(vp->old_metrics->v[2 + i], metric);
-      m1 = _mm_add_epi8(vp->old_metrics->v[2 + i], m_metric);
-      m2 = _mm_add_epi8(vp->old_metrics->v[i], m_metric);
-
-      /* Compare and select, using modulo arithmetic */
-      decision0 = _mm_cmpgt_epi8(_mm_sub_epi8(m0, m1), _mm_setzero_si128());
-      decision1 = _mm_cmpgt_epi8(_mm_sub_epi8(m2, m3), _mm_setzero_si128());
-      survivor0 = _mm_or_si128(_mm_and_si128(decision0, m1),
-                               _mm_andnot_si128(decision0, m0));
-      survivor1 = _mm_or_si128(_mm_and_si128(decision1, m3),
-                               _mm_andnot_si128(decision1, m2));
+      m0 = _mm_adds_epu8(vp->old_metrics->v[i], metric);
+      m3 = _mm_adds_epu8(vp->old_metrics->v[2 + i], metric);
+      m1 = _mm_adds_epu8(vp->old_metrics->v[2 + i], m_metric);
+      m2 = _mm_adds_epu8(vp->old_metrics->v[i], m_metric);
+
+      /* Compare and select */
+      survivor0 = _mm_min_epu8(m0, m1);
+      survivor1 = _mm_min_epu8(m2, m3);
+      decision0 = _mm_cmpeq_epi8(survivor0, m1);
+      decision1 = _mm_cmpeq_epi8(survivor1, m3);
 
       /* Pack each set of decisions into 16 bits */
       d->s[2 * i] = _mm_movemask_epi8(_mm_unpacklo_epi8(decision0, decision1));
@@ -198,6 +236,29 @@ void update_viterbi27_blk_sse2(void *p, unsigned char *syms, int nbits)
       vp->new_metrics->v[2 * i] = _mm_unpacklo_epi8(survivor0, survivor1);
       vp->new_metrics->v[2 * i + 1] = _mm_unpackhi_epi8(survivor0, survivor1);
     }
+
+    /*
+     * See if we have to normalize. The largest branch metric is 30 and the
+     * worst-case metric spread is 120, so checking only the first metric
+     * against 105 keeps every metric below 255 on the next iteration.
+     */
+    if (vp->new_metrics->c[0] > 105) {
+      __m128i adjustv;
+
+      /* Find smallest metric and subtract it from all metrics */
+      adjustv = _mm_min_epu8(vp->new_metrics->v[0], vp->new_metrics->v[1]);
+      adjustv = _mm_min_epu8(adjustv, vp->new_metrics->v[2]);
+      adjustv = _mm_min_epu8(adjustv, vp->new_metrics->v[3]);
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 8));
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 4));
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 2));
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 1));
+      adjustv = _mm_set1_epi8(_mm_cvtsi128_si32(adjustv) & 0xff);
+
+      for (i = 0; i < 4; i++) {
+        vp->new_metrics->v[i] = _mm_subs_epu8(vp->new_metrics->v[i], adjustv);
+      }
+    }
     d++;
     /* Swap pointers to old and new metrics */
     tmp = vp->old_metrics;
@@ -205,5 +266,6 @@ void update_viterbi27_blk_sse2(void *p, unsigned char *syms, int nbits)
     vp->new_metrics = tmp;
   }
   vp->dp = d;
+  return 0;
 }
-#endif
+#endif /* __x86_64__ */
@@ -29,7 +29,9 @@ void *create_viterbi29(int len)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return create_viterbi29_port(len);
+    return create_viterbi29_sse2(len);
+  case AVX2:
+    return create_viterbi29_avx2(len);
 #endif
   }
 }
@@ -59,7 +61,10 @@ void set_viterbi29_polynomial(int polys[2])
 #endif
 #ifdef __x86_64__
   case SSE2:
-    set_viterbi29_polynomial_port(polys);
+    set_viterbi29_polynomial_sse2(polys);
+    break;
+  case AVX2:
+    set_viterbi29_polynomial_avx2(polys);
     break;
 #endif
   }
@@ -86,7 +91,9 @@ int init_viterbi29(void *p, int starting_state)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return init_viterbi29_port(p, starting_state);
+    return init_viterbi29_sse2(p, starting_state);
+  case AVX2:
+    return init_viterbi29_avx2(p, starting_state);
 #endif
   }
 }
@@ -117,7 +124,9 @@ int chainback_viterbi29(
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return chainback_viterbi29_port(p, data, nbits, endstate);
+    return chainback_viterbi29_sse2(p, data, nbits, endstate);
+  case AVX2:
+    return chainback_viterbi29_avx2(p, data, nbits, endstate);
 #endif
   }
 }
@@ -148,7 +157,10 @@ void delete_viterbi29(void *p)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    delete_viterbi29_port(p);
+    delete_viterbi29_sse2(p);
+    break;
+  case AVX2:
+    delete_viterbi29_avx2(p);
     break;
 #endif
   }
@@ -178,7 +190,9 @@ int update_viterbi29_blk(void *p, unsigned char syms[], int nbits)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return update_viterbi29_blk_port(p, syms, nbits);
+    return update_viterbi29_blk_sse2(p, syms, nbits);
+  case AVX2:
+    return update_viterbi29_blk_avx2(p, syms, nbits);
 #endif
   }
 }
@@ -13,12 +13,13 @@ typedef union {
   __m128i v[16];
 } metric_t;
 typedef union {
-  unsigned long w[8];
+  unsigned int w[8];
   unsigned char c[32];
 } decision_t;
 
 union branchtab29 {
   unsigned char c[128];
+  __m128i v[8];
 } Branchtab29_sse2[2];
 static int Init = 0;
 
@@ -136,3 +137,93 @@ void delete_viterbi29_sse2(void *p)
     free(vp);
   }
 }
+
+#ifdef __x86_64__
+/*
+ * Intrinsics version of sse2bfly29.s, which can not be linked into a
+ * position independent shared library on x86-64
+ */
+int update_viterbi29_blk_sse2(void *p, unsigned char *syms, int nbits)
+{
+  struct v29 *vp = p;
+  decision_t *d;
+  const __m128i thirtyones = _mm_set1_epi8(31);
+
+  if (p == NULL) {
+    return -1;
+  }
+  d = (decision_t *)vp->dp;
+  while (nbits--) {
+    __m128i sym0v, sym1v;
+    void *tmp;
+    int i;
+
+    /* Splat the 0th symbol across sym0v, the 1st symbol across sym1v, etc */
+    sym0v = _mm_set1_epi8(syms[0]);
+    sym1v = _mm_set1_epi8(syms[1]);
+    syms += 2;
+
+    /* Each iteration does 16 butterflies in parallel */
+    for (i = 0; i < 8; i++) {
+      __m128i decision0, decision1, metric, m_metric, m0, m1, m2, m3, survivor0,
+              survivor1;
+
+      /* Form 5-bit branch metrics */
+      metric = _mm_avg_epu8(_mm_xor_si128(Branchtab29_sse2[0].v[i], sym0v),
+                            _mm_xor_si128(Branchtab29_sse2[1].v[i], sym1v));
+      metric = _mm_srli_epi16(metric, 3);
+      metric = _mm_and_si128(metric, thirtyones);
+      m_metric = _mm_xor_si128(metric, thirtyones);
+
+      /* Add branch metrics to path metrics */
+      m0 = _mm_adds_epu8(vp->old_metrics->v[i], metric);
+      m3 = _mm_adds_epu8(vp->old_metrics->v[8 + i], metric);
+      m1 = _mm_adds_epu8(vp->old_metrics->v[8 + i], m_metric);
+      m2 = _mm_adds_epu8(vp->old_metrics->v[i], m_metric);
+
+      /* Compare and select */
+      survivor0 = _mm_min_epu8(m0, m1);
+      survivor1 = _mm_min_epu8(m2, m3);
+      decision0 = _mm_cmpeq_epi8(survivor0, m1);
+      decision1 = _mm_cmpeq_epi8(survivor1, m3);
+
+      /* Interleave the decisions and pack them into 32 bits */
+      d->w[i] = (unsigned int)_mm_movemask_epi8(_mm_unpacklo_epi8(decision0,
+                decision1))
+                | ((unsigned int)_mm_movemask_epi8(_mm_unpackhi_epi8(decision0,
+                    decision1)) << 16);
+
+      /* Interleave and store the surviving metrics */
+      vp->new_metrics->v[2 * i] = _mm_unpacklo_epi8(survivor0, survivor1);
+      vp->new_metrics->v[2 * i + 1] = _mm_unpackhi_epi8(survivor0, survivor1);
+    }
+
+    /* See if we have to normalize */
+    if (vp->new_metrics->c[0] > 50) {
+      __m128i adjustv;
+
+      /* Find smallest metric and subtract it from all metrics */
+      adjustv = vp->new_metrics->v[0];
+      for (i = 1; i < 16; i++) {
+        adjustv = _mm_min_epu8(adjustv, vp->new_metrics->v[i]);
+      }
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 8));
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 4));
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 2));
+      adjustv = _mm_min_epu8(adjustv, _mm_srli_si128(adjustv, 1));
+      adjustv = _mm_set1_epi8(_mm_cvtsi128_si32(adjustv) & 0xff);
+
+      for (i = 0; i < 16; i++) {
+        vp->new_metrics->v[i] = _mm_subs_epu8(vp->new_metrics->v[i], adjustv);
+      }
+    }
+    d++;
+    /* Swap pointers to old and new metrics */
+    tmp = vp->old_metrics;
+    vp->old_metrics = vp->new_metrics;
+    vp->new_metrics = tmp;
+  }
+  vp->dp = d;
+  return 0;
+}
+#endif /* __x86_64__ */
@@ -29,7 +29,8 @@ void *create_viterbi39(int len)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return create_viterbi39_port(len);
+  case AVX2:
+    return create_viterbi39_sse2(len);
 #endif
   }
 }
@@ -59,7 +60,8 @@ void set_viterbi39_polynomial(int polys[3])
 #endif
 #ifdef __x86_64__
   case SSE2:
-    set_viterbi39_polynomial_port(polys);
+  case AVX2:
+    set_viterbi39_polynomial_sse2(polys);
     break;
 #endif
   }
@@ -87,7 +89,8 @@ int init_viterbi39(void *p, int starting_state)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return init_viterbi39_port(p, starting_state);
+  case AVX2:
+    return init_viterbi39_sse2(p, starting_state);
 #endif
   }
 }
@@ -118,7 +121,8 @@ int chainback_viterbi39(
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return chainback_viterbi39_port(p, data, nbits, endstate);
+  case AVX2:
+    return chainback_viterbi39_sse2(p, data, nbits, endstate);
 #endif
   }
 }
@@ -149,7 +153,8 @@ void delete_viterbi39(void *p)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    delete_viterbi39_port(p);
+  case AVX2:
+    delete_viterbi39_sse2(p);
     break;
 #endif
   }
@@ -179,7 +184,8 @@ int update_viterbi39_blk(void *p, unsigned char syms[], int nbits)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return update_viterbi39_blk_port(p, syms, nbits);
+  case AVX2:
+    return update_viterbi39_blk_sse2(p, syms, nbits);
 #endif
   }
 }
@@ -10,7 +10,7 @@
 #include "fec.h"
 
 typedef union {
-  unsigned long w[8];
+  unsigned int w[8];
   unsigned short s[16];
 } decision_t;
 typedef union {
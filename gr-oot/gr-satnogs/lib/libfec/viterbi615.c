@@ -30,7 +30,8 @@ void *create_viterbi615(int len)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return create_viterbi615_port(len);
+  case AVX2:
+    return create_viterbi615_sse2(len);
 #endif
   }
 }
@@ -61,7 +62,8 @@ void set_viterbi615_polynomial(int polys[6])
 #endif
 #ifdef __x86_64__
   case SSE2:
-    set_viterbi615_polynomial_port(polys);
+  case AVX2:
+    set_viterbi615_polynomial_sse2(polys);
     break;
 #endif
   }
@@ -88,7 +90,8 @@ int init_viterbi615(void *p, int starting_state)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return init_viterbi615_port(p, starting_state);
+  case AVX2:
+    return init_viterbi615_sse2(p, starting_state);
 #endif
   }
 }
@@ -119,7 +122,8 @@ int chainback_viterbi615(
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return chainback_viterbi615_port(p, data, nbits, endstate);
+  case AVX2:
+    return chainback_viterbi615_sse2(p, data, nbits, endstate);
 #endif
   }
 }
@@ -150,7 +154,8 @@ void delete_viterbi615(void *p)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    delete_viterbi615_port(p);
+  case AVX2:
+    delete_viterbi615_sse2(p);
     break;
 #endif
   }
@@ -180,7 +185,8 @@ int update_viterbi615_blk(void *p, unsigned char syms[], int nbits)
 #endif
 #ifdef __x86_64__
   case SSE2:
-    return update_viterbi615_blk_port(p, syms, nbits);
+  case AVX2:
+    return update_viterbi615_blk_sse2(p, syms, nbits);
 #endif
   }
 }
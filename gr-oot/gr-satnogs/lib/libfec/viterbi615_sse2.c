@@ -10,7 +10,7 @@
 #include "fec.h"
 
 typedef union {
-  unsigned long w[512];
+  unsigned int w[512];
   unsigned short s[1024];
 } decision_t;
 typedef union {
@@ -93,26 +93,33 @@ void
 lrpt_decoder_impl::decode(pmt::pmt_t m)
 {
   const uint8_t *coded_cadu = (const uint8_t *)pmt::blob_data(m);
-  if (pmt::blob_length(m) != d_coded_cadu_len) {
+  const size_t len = pmt::blob_length(m);
+  if (len != d_coded_cadu_len && len != d_coded_cadu_len * 8) {
     LOG_ERROR("Wrong CADU size");
     return;
   }
 
   init_viterbi27(d_vt, 0);
 
-  for (size_t i = 0; i < d_coded_cadu_len; i++) {
-    d_coded_cadu_syms[i * 8] = 0xFF * (coded_cadu[i] >> 7);
-    d_coded_cadu_syms[i * 8 + 1] = 0xFF * ((coded_cadu[i] >> 6) & 0x1);
-    d_coded_cadu_syms[i * 8 + 2] = 0xFF * ((coded_cadu[i] >> 5) & 0x1);
-    d_coded_cadu_syms[i * 8 + 3] = 0xFF * ((coded_cadu[i] >> 4) & 0x1);
-    d_coded_cadu_syms[i * 8 + 4] = 0xFF * ((coded_cadu[i] >> 3) & 0x1);
-    d_coded_cadu_syms[i * 8 + 5] = 0xFF * ((coded_cadu[i] >> 2) & 0x1);
-    d_coded_cadu_syms[i * 8 + 6] = 0xFF * ((coded_cadu[i] >> 1) & 0x1);
-    d_coded_cadu_syms[i * 8 + 7] = 0xFF * ((coded_cadu[i] & 0x1));
-  }
-
   /* Convolutional decoding */
-  update_viterbi27_blk(d_vt, d_coded_cadu_syms, d_cadu_len * 8);
+  if (len == d_coded_cadu_len * 8) {
+    /* Soft symbols from lrpt_sync can be used directly */
+    update_viterbi27_blk(d_vt, const_cast<uint8_t *>(coded_cadu),
+                         d_cadu_len * 8);
+  }
+  else {
+    for (size_t i = 0; i < d_coded_cadu_len; i++) {
+      d_coded_cadu_syms[i * 8] = 0xFF * (coded_cadu[i] >> 7);
+      d_coded_cadu_syms[i * 8 + 1] = 0xFF * ((coded_cadu[i] >> 6) & 0x1);
+      d_coded_cadu_syms[i * 8 + 2] = 0xFF * ((coded_cadu[i] >> 5) & 0x1);
+      d_coded_cadu_syms[i * 8 + 3] = 0xFF * ((coded_cadu[i] >> 4) & 0x1);
+      d_coded_cadu_syms[i * 8 + 4] = 0xFF * ((coded_cadu[i] >> 3) & 0x1);
+      d_coded_cadu_syms[i * 8 + 5] = 0xFF * ((coded_cadu[i] >> 2) & 0x1);
+      d_coded_cadu_syms[i * 8 + 6] = 0xFF * ((coded_cadu[i] >> 1) & 0x1);
+      d_coded_cadu_syms[i * 8 + 7] = 0xFF * ((coded_cadu[i] & 0x1));
+    }
+    update_viterbi27_blk(d_vt, d_coded_cadu_syms, d_cadu_len * 8);
+  }
   chainback_viterbi27(d_vt, d_cadu, d_cadu_len * 8, 0);
 
   /* Descrambling */
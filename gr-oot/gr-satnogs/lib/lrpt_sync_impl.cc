@@ -28,21 +28,28 @@
 #include <satnogs/utils.h>
 
 #include <volk/volk.h>
-#include <gnuradio/blocks/count_bits.h>
+#include <algorithm>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace gr {
 namespace satnogs {
 
+/* Number of QPSK symbols in the 64-bit sync shift register */
+static const int sync_syms = 32;
+
 lrpt_sync::sptr
-lrpt_sync::make(size_t threshold)
+lrpt_sync::make(size_t threshold, bool soft)
 {
-  return gnuradio::get_initial_sptr(new lrpt_sync_impl(threshold));
+  return gnuradio::get_initial_sptr(new lrpt_sync_impl(threshold, soft));
 }
 
 /*
  * The private constructor
  */
-lrpt_sync_impl::lrpt_sync_impl(size_t threshold) :
+lrpt_sync_impl::lrpt_sync_impl(size_t threshold, bool soft) :
   gr::sync_block("lrpt_sync",
                  gr::io_signature::make(1, 1, sizeof(gr_complex)),
                  gr::io_signature::make(0, 0, 0)),
@@ -64,6 +71,7 @@ lrpt_sync_impl::lrpt_sync_impl(size_t threshold) :
    * Thus, they dropped the check symbols at the end of the frame.
    */
   d_coded_cadu_len(1020 * 2 + 4 * 2 - 128 * 2),
+  d_soft(soft),
   d_frame_sync(false),
   d_received(0),
   d_rotate(1.0, 0.0),
@@ -76,41 +84,25 @@ lrpt_sync_impl::lrpt_sync_impl(size_t threshold) :
   set_output_multiple(d_window);
   const int alignment_multiple = volk_get_alignment() / sizeof(gr_complex);
   set_alignment(std::max(1, alignment_multiple));
-  d_rotate_pi2 = (gr_complex *) volk_malloc(d_window * sizeof(gr_complex),
-                 volk_get_alignment());
-  if (!d_rotate_pi2) {
-    throw std::runtime_error("lrpt_sync: Could not allocate memory");
-  }
-
-  d_rotate_2pi2 = (gr_complex *) volk_malloc(d_window * sizeof(gr_complex),
-                  volk_get_alignment());
-  if (!d_rotate_2pi2) {
-    volk_free(d_rotate_pi2);
-    throw std::runtime_error("lrpt_sync: Could not allocate memory");
-  }
-
-  d_rotate_3pi2 = (gr_complex *) volk_malloc(d_window * sizeof(gr_complex),
-                  volk_get_alignment());
-  if (!d_rotate_3pi2) {
-    volk_free(d_rotate_pi2);
-    volk_free(d_rotate_2pi2);
-    throw std::runtime_error("lrpt_sync: Could not allocate memory");
-  }
-
   d_corrected = (gr_complex *)volk_malloc(d_window * sizeof(gr_complex),
                                           volk_get_alignment());
   if (!d_corrected) {
-    volk_free(d_rotate_pi2);
-    volk_free(d_rotate_2pi2);
-    volk_free(d_rotate_3pi2);
     throw std::runtime_error("lrpt_sync: Could not allocate memory");
   }
+  d_dibits = new uint8_t[d_window];
 
   uint64_t asm_coded = utils::htonll(d_asm_coded);
   d_coded_cadu = new uint8_t[d_coded_cadu_len];
   memcpy(d_coded_cadu, &asm_coded, sizeof(uint64_t));
   d_received =  sizeof(uint64_t);
 
+  d_soft_proj = new float[d_coded_cadu_len * 8];
+  d_soft_cadu = new uint8_t[d_coded_cadu_len * 8];
+  d_sync_hist = new gr_complex[sync_syms]();
+  if (d_soft) {
+    d_received = sizeof(uint64_t) * 8;
+  }
+
   message_port_register_out(pmt::mp("cadu"));
 }
 
@@ -119,86 +111,145 @@ lrpt_sync_impl::lrpt_sync_impl(size_t threshold) :
  */
 lrpt_sync_impl::~lrpt_sync_impl()
 {
-  volk_free(d_rotate_pi2);
-  volk_free(d_rotate_2pi2);
-  volk_free(d_rotate_3pi2);
   volk_free(d_corrected);
+  delete [] d_dibits;
   delete [] d_coded_cadu;
+  delete [] d_soft_proj;
+  delete [] d_soft_cadu;
+  delete [] d_sync_hist;
 }
 
-bool
-lrpt_sync_impl::found_sync(uint64_t reg)
+/*
+ * Computes for each sample the QPSK decisions of all the four possible
+ * rotations of the constellation.
+ *
+ * The QPSK decision maker sets the MS bit if the imaginary part is positive
+ * and the LS bit if the real part is positive. Rotating by multiples of pi/2
+ * just swaps and negates the real and imaginary parts, so only the signs of
+ * the sample are needed. The dibit of the rotation by k * pi/2 is placed at
+ * bits 2k and 2k + 1 of the result.
+ */
+void
+lrpt_sync_impl::rotated_dibits(const gr_complex *in, int nitems)
 {
-  return blocks::count_bits64((reg ^ d_asm_coded) & d_asm_coded_mask)
-         <= d_thresh;
-}
+  /*
+   * Index: bit 0: re > 0, bit 1: im > 0, bit 2: re < 0, bit 3: im < 0
+   *
+   * 0:      (im > 0, re > 0)
+   * pi/2:   (re > 0, im < 0)
+   * pi:     (im < 0, re < 0)
+   * 3pi/2:  (re < 0, im > 0)
+   */
+  static const struct dibits_lut {
+    uint8_t                     v[16];
+    dibits_lut()
+    {
+      for (int i = 0; i < 16; i++) {
+        const int pr = i & 0x1;
+        const int pi = (i >> 1) & 0x1;
+        const int nr = (i >> 2) & 0x1;
+        const int ni = (i >> 3) & 0x1;
+        v[i] = ((pi << 1) | pr)
+               | (((pr << 1) | ni) << 2)
+               | (((ni << 1) | nr) << 4)
+               | (((nr << 1) | pi) << 6);
+      }
+    }
+  } lut;
 
+  const float *x = (const float *) in;
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 2 <= nitems; i += 2) {
+    const __m128 v = _mm_loadu_ps(x + 2 * i);
+    const int gt = _mm_movemask_ps(_mm_cmpgt_ps(v, zero));
+    const int lt = _mm_movemask_ps(_mm_cmplt_ps(v, zero));
+    d_dibits[i] = lut.v[(gt & 0x3) | ((lt & 0x3) << 2)];
+    d_dibits[i + 1] = lut.v[(gt >> 2) | (lt & 0xC)];
+  }
+#endif
+  for (; i < nitems; i++) {
+    const int idx = (x[2 * i] > 0) | ((x[2 * i + 1] > 0) << 1)
+                    | ((x[2 * i] < 0) << 2) | ((x[2 * i + 1] < 0) << 3);
+    d_dibits[i] = lut.v[idx];
+  }
+}
 
 int
 lrpt_sync_impl::work_no_sync(const gr_complex *in, int noutput_items)
 {
-  uint32_t bits;
+  const gr_complex rotations[4] = {
+    gr_complex(1.0, 0.0), gr_complex(0.0, 1.0),
+    gr_complex(-1.0, 0.0), gr_complex(0.0, -1.0)
+  };
   int multiple = noutput_items / d_window;
   for (int i = 0; i < multiple; i++) {
-    volk_32fc_s32fc_multiply_32fc(d_rotate_pi2, in + i * d_window,
-                                  gr_complex(0.0, 1.0), d_window);
-    volk_32fc_s32fc_multiply_32fc(d_rotate_2pi2, in + i * d_window,
-                                  gr_complex(-1.0, 0.0), d_window);
-    volk_32fc_s32fc_multiply_32fc(d_rotate_3pi2, in + i * d_window,
-                                  gr_complex(0.0, -1.0), d_window);
+    rotated_dibits(in + i * d_window, d_window);
     /*
-     * Search for the sync pattern, rotating the QPSK constellation on
-     * all possible positions
+     * Search for the sync pattern on all possible rotations of the QPSK
+     * constellation. The four correlations are branch free, only the
+     * rare case of a hit takes a branch.
      */
     for (int j = 0; j < d_window; j++) {
-      bits = d_qpsk->decision_maker(in + i * d_window + j);
-      //bits = (d_conv_deinter.decode_bit(bits >> 1) << 1) | d_conv_deinter.decode_bit(bits & 0x1);
-      d_shift_reg0 = (d_shift_reg0 << 2) | bits;
-      if (found_sync(d_shift_reg0)) {
-        d_rotate = gr_complex(1.0, 0.0);
-        d_frame_sync = true;
-        uint64_t asm_coded = utils::htonll(d_shift_reg0);
-        memcpy(d_coded_cadu, &asm_coded, sizeof(uint64_t));
-        return i * d_window + j + 1;
-      }
-
-      bits = d_qpsk->decision_maker(d_rotate_pi2 + j);
-      //bits = (d_conv_deinter.decode_bit(bits >> 1) << 1) | d_conv_deinter.decode_bit(bits & 0x1);
-      d_shift_reg1 = (d_shift_reg1 << 2) | bits;
-      if (found_sync(d_shift_reg1)) {
-        d_rotate = gr_complex(0.0, 1.0);
-        d_frame_sync = true;
-        uint64_t asm_coded = utils::htonll(d_shift_reg1);
-        memcpy(d_coded_cadu, &asm_coded, sizeof(uint64_t));
-        return i * d_window + j + 1;
-      }
-
-      bits = d_qpsk->decision_maker(d_rotate_2pi2 + j);
-      //bits = (d_conv_deinter.decode_bit(bits >> 1) << 1) | d_conv_deinter.decode_bit(bits & 0x1);
-      d_shift_reg2 = (d_shift_reg2 << 2) | bits;
-      if (found_sync(d_shift_reg2)) {
-        d_rotate = gr_complex(-1.0, 0.0);
-        d_frame_sync = true;
-        uint64_t asm_coded = utils::htonll(d_shift_reg2);
-        memcpy(d_coded_cadu, &asm_coded, sizeof(uint64_t));
-        return i * d_window + j + 1;
-      }
-
-      bits = d_qpsk->decision_maker(d_rotate_3pi2 + j);
-      //bits = (d_conv_deinter.decode_bit(bits >> 1) << 1) | d_conv_deinter.decode_bit(bits & 0x1);
-      d_shift_reg3 = (d_shift_reg3 << 2) | bits;
-      if (found_sync(d_shift_reg3)) {
-        d_rotate = gr_complex(0.0, -1.0);
+      const uint8_t b = d_dibits[j];
+      d_shift_reg0 = (d_shift_reg0 << 2) | (b & 0x3);
+      d_shift_reg1 = (d_shift_reg1 << 2) | ((b >> 2) & 0x3);
+      d_shift_reg2 = (d_shift_reg2 << 2) | ((b >> 4) & 0x3);
+      d_shift_reg3 = (d_shift_reg3 << 2) | (b >> 6);
+      const size_t d0 = __builtin_popcountll((d_shift_reg0 ^ d_asm_coded)
+                                             & d_asm_coded_mask);
+      const size_t d1 = __builtin_popcountll((d_shift_reg1 ^ d_asm_coded)
+                                             & d_asm_coded_mask);
+      const size_t d2 = __builtin_popcountll((d_shift_reg2 ^ d_asm_coded)
+                                             & d_asm_coded_mask);
+      const size_t d3 = __builtin_popcountll((d_shift_reg3 ^ d_asm_coded)
+                                             & d_asm_coded_mask);
+      const uint32_t hits = (d0 <= d_thresh) | ((d1 <= d_thresh) << 1)
+                            | ((d2 <= d_thresh) << 2)
+                            | ((d3 <= d_thresh) << 3);
+      if (hits) {
+        const uint64_t regs[4] = {
+          d_shift_reg0, d_shift_reg1, d_shift_reg2, d_shift_reg3
+        };
+        const int k = __builtin_ctz(hits);
+        d_rotate = rotations[k];
         d_frame_sync = true;
-        uint64_t asm_coded = utils::htonll(d_shift_reg3);
+        uint64_t asm_coded = utils::htonll(regs[k]);
         memcpy(d_coded_cadu, &asm_coded, sizeof(uint64_t));
+        if (d_soft) {
+          store_leading_soft(in, i * d_window + j, d_rotate);
+        }
         return i * d_window + j + 1;
       }
     }
   }
+  /* Keep the last symbols, in case the sync word spans two calls */
+  const int n = multiple * d_window;
+  if (n >= sync_syms) {
+    std::copy(in + n - sync_syms, in + n, d_sync_hist);
+  }
   return noutput_items;
 }
 
+/*
+ * Stores the soft symbols of the bits that precede the coded ASM in the
+ * sync shift register. The register ends at the sample idx and may start
+ * at the samples kept from the previous call.
+ */
+void
+lrpt_sync_impl::store_leading_soft(const gr_complex *in, int idx,
+                                   const gr_complex &rot)
+{
+  const int leading_syms = (64 - d_asm_coded_len) / 2;
+  for (int s = 0; s < leading_syms; s++) {
+    const int p = idx - (sync_syms - 1) + s;
+    const gr_complex c = (p >= 0 ? in[p] : d_sync_hist[sync_syms + p]) * rot;
+    d_soft_proj[2 * s] = c.imag();
+    d_soft_proj[2 * s + 1] = c.real();
+  }
+}
+
 int
 lrpt_sync_impl::work_sync(const gr_complex *in, int noutput_items)
 {
@@ -228,6 +279,63 @@ lrpt_sync_impl::work_sync(const gr_complex *in, int noutput_items)
 }
 
 
+/*
+ * The QPSK decision maker sets the MS bit of each symbol if the imaginary
+ * part is positive and the LS bit if the real part is positive. The soft
+ * symbols are the projections on these axes, in the same order.
+ */
+int
+lrpt_sync_impl::work_sync_soft(const gr_complex *in, int noutput_items)
+{
+  int multiple = noutput_items / d_window;
+  for (int i = 0; i < multiple; i++) {
+    volk_32fc_s32fc_multiply_32fc(d_corrected, in + i * d_window,
+                                  d_rotate, d_window);
+    for (int j = 0; j < d_window; j++) {
+      d_soft_proj[d_received++] = d_corrected[j].imag();
+      d_soft_proj[d_received++] = d_corrected[j].real();
+      if (d_received == d_coded_cadu_len * 8) {
+        d_received = sizeof(uint64_t) * 8;
+        d_frame_sync = false;
+        publish_soft_cadu();
+        return i * d_window + j + 1;
+      }
+    }
+  }
+  return noutput_items;
+}
+
+/*
+ * Quantizes the soft symbols of the CADU for the libfec Viterbi decoder,
+ * using as reference their mean amplitude. The 52 bits of the coded ASM are
+ * known, so they are set as strong decisions from d_asm_coded rather than
+ * from the received bits, that may contain errors. The bits preceding the
+ * ASM in the first 64 are quantized like the rest of the CADU.
+ */
+void
+lrpt_sync_impl::publish_soft_cadu()
+{
+  const size_t sync_bits = sizeof(uint64_t) * 8;
+  const size_t leading_bits = sync_bits - d_asm_coded_len;
+  const size_t nsyms = d_coded_cadu_len * 8;
+
+  float amplitude = 0.0f;
+  for (size_t i = sync_bits; i < nsyms; i++) {
+    amplitude += std::abs(d_soft_proj[i]);
+  }
+  amplitude /= nsyms - sync_bits;
+  const float scale = amplitude > 0.0f ? 64.0f / amplitude : 0.0f;
+  for (size_t i = 0; i < nsyms; i++) {
+    const float s = std::round(128.0f + d_soft_proj[i] * scale);
+    d_soft_cadu[i] = std::max(0.0f, std::min(255.0f, s));
+  }
+  for (size_t i = leading_bits; i < sync_bits; i++) {
+    d_soft_cadu[i] = 0xFF * ((d_asm_coded >> (sync_bits - 1 - i)) & 0x1);
+  }
+  message_port_pub(pmt::mp("cadu"), pmt::make_blob(d_soft_cadu, nsyms));
+}
+
+
 int
 lrpt_sync_impl::work(int noutput_items,
                      gr_vector_const_void_star &input_items,
@@ -238,6 +346,9 @@ lrpt_sync_impl::work(int noutput_items,
   if (!d_frame_sync) {
     return work_no_sync(in, noutput_items);
   }
+  if (d_soft) {
+    return work_sync_soft(in, noutput_items);
+  }
   return work_sync(in, noutput_items);
 }
 
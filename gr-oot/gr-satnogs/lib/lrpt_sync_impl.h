@@ -30,7 +30,7 @@ namespace satnogs {
 
 class lrpt_sync_impl : public lrpt_sync {
 public:
-  lrpt_sync_impl(size_t threshold);
+  lrpt_sync_impl(size_t threshold, bool soft);
   ~lrpt_sync_impl();
 
   int
@@ -45,6 +45,7 @@ private:
   const uint64_t                        d_asm_coded_mask;
   const int                             d_window;
   const size_t                          d_coded_cadu_len;
+  const bool                            d_soft;
   bool                                  d_frame_sync;
   size_t                                d_received;
   gr_complex                            d_rotate;
@@ -53,11 +54,12 @@ private:
   uint64_t                              d_shift_reg1;
   uint64_t                              d_shift_reg2;
   uint64_t                              d_shift_reg3;
-  gr_complex                           *d_rotate_pi2;
-  gr_complex                           *d_rotate_2pi2;
-  gr_complex                           *d_rotate_3pi2;
+  uint8_t                              *d_dibits;
   gr_complex                           *d_corrected;
   uint8_t                              *d_coded_cadu;
+  float                                *d_soft_proj;
+  uint8_t                              *d_soft_cadu;
+  gr_complex                           *d_sync_hist;
 
   int
   work_no_sync(const gr_complex *in, int noutput_items);
@@ -65,8 +67,17 @@ private:
   int
   work_sync(const gr_complex *in, int noutput_items);
 
-  bool
-  found_sync(uint64_t reg);
+  int
+  work_sync_soft(const gr_complex *in, int noutput_items);
+
+  void
+  publish_soft_cadu();
+
+  void
+  store_leading_soft(const gr_complex *in, int idx, const gr_complex &rot);
+
+  void
+  rotated_dibits(const gr_complex *in, int nitems);
 
 };
 
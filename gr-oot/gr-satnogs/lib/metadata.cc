@@ -19,7 +19,7 @@
  */
 
 #include <satnogs/metadata.h>
-#include <satnogs/base64.h>
+#include <satnogs/frame_metadata.h>
 #include <satnogs/date.h>
 #include <stdexcept>
 #include <chrono>
@@ -33,6 +33,43 @@ metadata::~metadata()
 
 }
 
+/**
+ * Returns the PMT symbol of the key @a k.
+ * The PMT symbols of the keys are created once, so adding metadata to a
+ * decoded frame does not need to look up the PMT symbol table
+ */
+const pmt::pmt_t &
+metadata::key(key_t k)
+{
+  static const struct key_table {
+    pmt::pmt_t                  v[KEYS_NUM];
+    key_table()
+    {
+      for (size_t i = 0; i < KEYS_NUM; i++) {
+        v[i] = pmt::mp(value((key_t) i));
+      }
+    }
+  } table;
+  return table.v[k];
+}
+
+/**
+ * Adds a key-value pair to a metadata dictionary. Decoders leave their
+ * metadata unset until a frame is decoded, so the dictionary is created
+ * on the first insertion
+ * @param m reference to a PMT dictionary, or a null PMT
+ * @param k the key
+ * @param v the value
+ */
+void
+metadata::add(pmt::pmt_t &m, key_t k, const pmt::pmt_t &v)
+{
+  if (!m) {
+    m = pmt::make_dict();
+  }
+  m = pmt::dict_add(m, key(k), v);
+}
+
 std::string
 metadata::keys()
 {
@@ -60,6 +97,8 @@ metadata::value(const key_t &k)
     return "pdu";
   case DECODER_CRC_VALID:
     return "decoder_crc_valid";
+  case CRC_VALID:
+    return "crc_valid";
   case CENTER_FREQ:
     return "center_freq";
   case FREQ_OFFSET:
@@ -92,6 +131,8 @@ metadata::value(const key_t &k)
     return "decoder_resampling_ratio";
   case SYMBOL_TIMING_ERROR:
     return "symbol_timing_error";
+  case DECODER_ID:
+    return "decoder_id";
   default:
     throw std::invalid_argument("metadata: invalid key");
   }
@@ -118,13 +159,13 @@ metadata::time_iso8601()
 void
 metadata::add_time_iso8601(pmt::pmt_t &m)
 {
-  m = pmt::dict_add(m, pmt::mp(value(TIME)), pmt::mp(time_iso8601()));
+  add(m, TIME, pmt::mp(time_iso8601()));
 }
 
 void
 metadata::add_pdu(pmt::pmt_t &m, const uint8_t *in, size_t len)
 {
-  m = pmt::dict_add(m, pmt::mp(value(PDU)), pmt::make_blob(in, len));
+  add(m, PDU, pmt::make_blob(in, len));
 }
 
 /**
@@ -134,101 +175,105 @@ metadata::add_pdu(pmt::pmt_t &m, const uint8_t *in, size_t len)
 void
 metadata::add_crc_valid(pmt::pmt_t &m, bool valid)
 {
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_CRC_VALID)), pmt::from_bool(valid));
+  add(m, DECODER_CRC_VALID, pmt::from_bool(valid));
 }
 
 void
 metadata::add_sample_start(pmt::pmt_t &m, uint64_t idx)
 {
-  m = pmt::dict_add(m, pmt::mp(value(SAMPLE_START)), pmt::from_uint64(idx));
+  add(m, SAMPLE_START, pmt::from_uint64(idx));
 }
 
 void
 metadata::add_sample_cnt(pmt::pmt_t &m, uint64_t cnt)
 {
-  m = pmt::dict_add(m, pmt::mp(value(SAMPLE_CNT)), pmt::from_uint64(cnt));
+  add(m, SAMPLE_CNT, pmt::from_uint64(cnt));
 }
 
 void
 metadata::add_symbol_erasures(pmt::pmt_t &m, uint32_t cnt)
 {
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_SYMBOL_ERASURES)),
-                    pmt::from_uint64(cnt));
+  add(m, DECODER_SYMBOL_ERASURES, pmt::from_uint64(cnt));
 }
 
 void
 metadata::add_corrected_bits(pmt::pmt_t &m, uint32_t cnt)
 {
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_CORRECTED_BITS)),
-                    pmt::from_uint64(cnt));
+  add(m, DECODER_CORRECTED_BITS, pmt::from_uint64(cnt));
 }
 
 void
 metadata::add_center_freq(pmt::pmt_t &m, double freq)
 {
-  m = pmt::dict_add(m, pmt::mp(value(CENTER_FREQ)), pmt::from_double(freq));
+  add(m, CENTER_FREQ, pmt::from_double(freq));
 }
 
 void
 metadata::add_freq_offset(pmt::pmt_t &m, double offset)
 {
-  m = pmt::dict_add(m, pmt::mp(value(FREQ_OFFSET)), pmt::from_double(offset));
+  add(m, FREQ_OFFSET, pmt::from_double(offset));
 }
 
 void
 metadata::add_snr(pmt::pmt_t &m, float snr)
 {
-  m = pmt::dict_add(m, pmt::mp(value(SNR)), pmt::from_float(snr));
+  add(m, SNR, pmt::from_float(snr));
 }
 
 void
 metadata::add_antenna_azimuth(pmt::pmt_t &m, double azimuth)
 {
-  m = pmt::dict_add(m, pmt::mp(value(ANTENNA_AZIMUTH)),
-                    pmt::from_double(azimuth));
+  add(m, ANTENNA_AZIMUTH, pmt::from_double(azimuth));
 }
 
 void
 metadata::add_antenna_elevation(pmt::pmt_t &m, double elevation)
 {
-  m = pmt::dict_add(m, pmt::mp(value(ANTENNA_ELEVATION)),
-                    pmt::from_double(elevation));
+  add(m, ANTENNA_ELEVATION, pmt::from_double(elevation));
 }
 
 void
 metadata::add_antenna_polarization(pmt::pmt_t &m, std::string polarization)
 {
-  m = pmt::dict_add(m, pmt::mp(value(ANTENNA_POLARIZATION)),
-                    pmt::mp(polarization));
+  add(m, ANTENNA_POLARIZATION, pmt::mp(polarization));
 }
 
 void
 metadata::add_decoder(pmt::pmt_t &m, const std::string &name,
                       const std::string &version)
 {
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_NAME)), pmt::mp(name));
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_VERSION)), pmt::mp(version));
+  add(m, DECODER_NAME, pmt::mp(name));
+  add(m, DECODER_VERSION, pmt::mp(version));
 }
 
 void
 metadata::add_phase_delay(pmt::pmt_t &m, uint64_t phase_delay)
 {
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_PHASE_DELAY)),
-                    pmt::mp(phase_delay));
+  add(m, DECODER_PHASE_DELAY, pmt::mp(phase_delay));
 }
 
 void
 metadata::add_resampling_ratio(pmt::pmt_t &m, float ratio)
 {
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_RESAMPLING_RATIO)),
-                    pmt::mp(ratio));
+  add(m, DECODER_RESAMPLING_RATIO, pmt::mp(ratio));
 }
 
 void
 metadata::add_symbol_timing_error(pmt::pmt_t &m, double error)
 {
-  m = pmt::dict_add(m, pmt::mp(value(SYMBOL_TIMING_ERROR)),
-                    pmt::from_double(error));
+  add(m, SYMBOL_TIMING_ERROR, pmt::from_double(error));
+}
+
+/**
+ * Adds the unique id of the decoder that produced the frame. This is
+ * useful when the frames of several decoders are merged
+ * @param m reference to a PMT dictionary
+ * @param id the unique id of the decoder
+ */
+void
+metadata::add_decoder_id(pmt::pmt_t &m, int id)
+{
+  add(m, DECODER_ID, pmt::from_long(id));
 }
 
 
@@ -244,107 +289,20 @@ metadata::add_decoder(pmt::pmt_t &m, const decoder *dec)
   if (!dec) {
     return;
   }
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_NAME)), pmt::mp(dec->name()));
-  m = pmt::dict_add(m, pmt::mp(value(DECODER_VERSION)), pmt::mp(dec->version()));
+  add(m, DECODER_NAME, pmt::mp(dec->name()));
+  add(m, DECODER_VERSION, pmt::mp(dec->version()));
 }
 
 
+/**
+ * Converts a metadata dictionary to JSON
+ * @param m the PMT dictionary
+ * @return the JSON object
+ */
 nlohmann::json
 metadata::to_json(const pmt::pmt_t &m)
 {
-  nlohmann::json j;
-  pmt::pmt_t v = pmt::dict_ref(m, pmt::mp(value(PDU)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    uint8_t *b = (uint8_t *) pmt::blob_data(v);
-    size_t len = pmt::blob_length(v);
-    j[value(PDU)] = base64_encode(b, len);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(TIME)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(TIME)] = pmt::symbol_to_string(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_CRC_VALID)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_CRC_VALID)] = pmt::to_bool(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(SAMPLE_START)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(SAMPLE_START)] = pmt::to_uint64(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(SAMPLE_CNT)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(SAMPLE_CNT)] = pmt::to_uint64(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_SYMBOL_ERASURES)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_SYMBOL_ERASURES)] = pmt::to_uint64(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_CORRECTED_BITS)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_CORRECTED_BITS)] = pmt::to_uint64(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(CENTER_FREQ)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(CENTER_FREQ)] = pmt::to_double(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(FREQ_OFFSET)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(FREQ_OFFSET)] = pmt::to_double(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(SNR)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(SNR)] = pmt::to_float(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(ANTENNA_AZIMUTH)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(ANTENNA_AZIMUTH)] = pmt::to_double(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(ANTENNA_ELEVATION)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(ANTENNA_ELEVATION)] = pmt::to_double(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(ANTENNA_POLARIZATION)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(ANTENNA_POLARIZATION)] = pmt::symbol_to_string(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_PHASE_DELAY)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_PHASE_DELAY)] = pmt::to_uint64(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_RESAMPLING_RATIO)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_RESAMPLING_RATIO)] = pmt::to_float(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_NAME)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_NAME)] = pmt::symbol_to_string(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_VERSION)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(DECODER_VERSION)] = pmt::symbol_to_string(v);
-  }
-
-  v = pmt::dict_ref(m, pmt::mp(value(SYMBOL_TIMING_ERROR)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    j[value(SYMBOL_TIMING_ERROR)] = pmt::to_double(v);
-  }
-  return j;
+  return frame_metadata(m).to_json();
 }
 
 }  // namespace satnogs
@@ -0,0 +1,272 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "multi_frame_decoder_impl.h"
+#include <satnogs/log.h>
+#include <satnogs/metadata.h>
+#include <algorithm>
+#include <cstring>
+
+namespace gr {
+namespace satnogs {
+
+static size_t
+gcd(size_t a, size_t b)
+{
+  while (b) {
+    const size_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+multi_frame_decoder::sptr
+multi_frame_decoder::make(const std::vector<decoder::decoder_sptr> &decoders,
+                          int input_size, size_t nthreads)
+{
+  return gnuradio::get_initial_sptr(new multi_frame_decoder_impl(decoders,
+                                    input_size, nthreads));
+}
+
+/*
+ * The private constructor
+ */
+multi_frame_decoder_impl::multi_frame_decoder_impl(
+  const std::vector<decoder::decoder_sptr> &decoders, int input_size,
+  size_t nthreads) :
+  gr::sync_block("multi_frame_decoder",
+                 gr::io_signature::make(1, 1, input_size),
+                 gr::io_signature::make(0, 0, 0)),
+  d_decoders(decoders),
+  d_itemsize(input_size),
+  d_max_hist(0),
+  d_hist_len(0),
+  d_offset(decoders.size(), 0),
+  d_frames(decoders.size()),
+  d_round(0),
+  d_stop(false),
+  d_in(nullptr),
+  d_nitems(0),
+  d_next(0),
+  d_done(0)
+{
+  if (d_decoders.empty()) {
+    throw std::invalid_argument("multi_frame_decoder: No decoders specified");
+  }
+
+  /*
+   * The number of input items should satisfy the requirements of all
+   * decoders
+   */
+  size_t multiple = 1;
+  for (const decoder::decoder_sptr &d : d_decoders) {
+    if (!d) {
+      throw std::invalid_argument("multi_frame_decoder: Invalid decoder");
+    }
+    if (input_size != d->sizeof_input_item()) {
+      throw std::invalid_argument(
+        "multi_frame_decoder: Size mismatch between the block input and the decoder "
+        + d->name());
+    }
+    multiple = multiple / gcd(multiple, d->input_multiple())
+               * d->input_multiple();
+    d_max_hist = std::max(d_max_hist, 16 * d->max_frame_len());
+  }
+  set_output_multiple(multiple);
+  d_max_hist = std::max(d_max_hist, 2 * multiple);
+
+  if (nthreads == 0) {
+    nthreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  nthreads = std::min(nthreads, d_decoders.size());
+
+  /* The thread executing the work() participates too */
+  for (size_t i = 1; i < nthreads; i++) {
+    d_workers.emplace_back(&multi_frame_decoder_impl::worker, this);
+  }
+
+  message_port_register_in(pmt::mp("reset"));
+  message_port_register_out(pmt::mp("out"));
+
+  set_msg_handler(pmt::mp("reset"),
+  [this](pmt::pmt_t msg) {
+    this->reset(msg);
+  });
+}
+
+/*
+ * Our virtual destructor.
+ */
+multi_frame_decoder_impl::~multi_frame_decoder_impl()
+{
+  {
+    std::lock_guard<std::mutex> lock(d_mtx);
+    d_stop = true;
+  }
+  d_start_cv.notify_all();
+  for (std::thread &t : d_workers) {
+    t.join();
+  }
+}
+
+void
+multi_frame_decoder_impl::reset(pmt::pmt_t m)
+{
+  for (const decoder::decoder_sptr &d : d_decoders) {
+    d->reset();
+  }
+}
+
+void
+multi_frame_decoder_impl::worker()
+{
+  uint64_t round = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(d_mtx);
+      d_start_cv.wait(lock, [this, round] {
+        return d_stop || d_round != round;
+      });
+      if (d_stop) {
+        return;
+      }
+      round = d_round;
+    }
+    run_decoders();
+  }
+}
+
+/*
+ * Each thread picks the next decoder that has not been claimed yet, so
+ * the load is balanced even if some decoders are much slower than others
+ */
+void
+multi_frame_decoder_impl::run_decoders()
+{
+  size_t idx;
+  while ((idx = d_next.fetch_add(1)) < d_decoders.size()) {
+    run_decoder(idx);
+    if (d_done.fetch_add(1) + 1 == d_decoders.size()) {
+      std::lock_guard<std::mutex> lock(d_mtx);
+      d_done_cv.notify_one();
+    }
+  }
+}
+
+/**
+ * Feeds a decoder with all the input items it has not consumed yet.
+ * Decoders may consume only a part of the input on each call, so the
+ * decoder is called repeatedly until it cannot make any progress
+ *
+ * @param idx the index of the decoder
+ */
+void
+multi_frame_decoder_impl::run_decoder(size_t idx)
+{
+  const decoder::decoder_sptr &d = d_decoders[idx];
+  const size_t multiple = d->input_multiple();
+  size_t offset = d_offset[idx];
+  while (offset < d_nitems && d_nitems - offset >= multiple) {
+    const size_t n = (d_nitems - offset) / multiple * multiple;
+    decoder_status_t status = d->decode(d_in + offset * d_itemsize, n);
+    status.next_frame();
+    for (pmt::pmt_t &f : status.frames) {
+      d_frames[idx].push_back(f);
+    }
+    if (status.consumed <= 0) {
+      break;
+    }
+    offset += status.consumed;
+  }
+  d_offset[idx] = offset;
+}
+
+int
+multi_frame_decoder_impl::work(int noutput_items,
+                               gr_vector_const_void_star &input_items,
+                               gr_vector_void_star &output_items)
+{
+  /*
+   * The input is appended to the items that some decoders have not
+   * processed yet, so the whole input can be consumed
+   */
+  const size_t len = (d_hist_len + noutput_items) * d_itemsize;
+  if (d_hist.size() < len) {
+    d_hist.resize(len);
+  }
+  memcpy(&d_hist[d_hist_len * d_itemsize], input_items[0],
+         noutput_items * d_itemsize);
+  d_hist_len += noutput_items;
+
+  d_in = d_hist.data();
+  d_nitems = d_hist_len;
+  d_done = 0;
+  d_next = 0;
+  {
+    std::lock_guard<std::mutex> lock(d_mtx);
+    d_round++;
+  }
+  d_start_cv.notify_all();
+  run_decoders();
+  {
+    std::unique_lock<std::mutex> lock(d_mtx);
+    d_done_cv.wait(lock, [this] {
+      return d_done == d_decoders.size();
+    });
+  }
+
+  /*
+   * Decoders may keep a few items that are not enough for a new decoding
+   * step. A decoder that keeps too many is reset, so the history stays
+   * bounded and the other decoders are not held back
+   */
+  for (size_t i = 0; i < d_decoders.size(); i++) {
+    if (d_hist_len - d_offset[i] > d_max_hist) {
+      LOG_WARN("multi_frame_decoder: decoder %s is too far behind, resetting",
+               d_decoders[i]->name().c_str());
+      d_decoders[i]->reset();
+      d_offset[i] = d_hist_len;
+    }
+    for (pmt::pmt_t &f : d_frames[i]) {
+      metadata::add_decoder_id(f, d_decoders[i]->unique_id());
+      message_port_pub(pmt::mp("out"), f);
+    }
+    d_frames[i].clear();
+  }
+
+  /* Keep only the items that some decoders have not processed yet */
+  const size_t consumed = *std::min_element(d_offset.begin(), d_offset.end());
+  for (size_t &o : d_offset) {
+    o -= consumed;
+  }
+  d_hist_len -= consumed;
+  memmove(d_hist.data(), &d_hist[consumed * d_itemsize],
+          d_hist_len * d_itemsize);
+  return noutput_items;
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
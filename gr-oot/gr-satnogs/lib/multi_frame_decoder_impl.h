@@ -0,0 +1,82 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_SATNOGS_MULTI_FRAME_DECODER_IMPL_H
+#define INCLUDED_SATNOGS_MULTI_FRAME_DECODER_IMPL_H
+
+#include <satnogs/multi_frame_decoder.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace gr {
+namespace satnogs {
+
+class multi_frame_decoder_impl : public multi_frame_decoder {
+
+public:
+  multi_frame_decoder_impl(const std::vector<decoder::decoder_sptr> &decoders,
+                           int input_size, size_t nthreads);
+  ~multi_frame_decoder_impl();
+
+  int
+  work(int noutput_items, gr_vector_const_void_star &input_items,
+       gr_vector_void_star &output_items);
+
+private:
+  const std::vector<decoder::decoder_sptr>      d_decoders;
+  const size_t                                  d_itemsize;
+  /* Maximum number of items kept for the decoders that are behind */
+  size_t                                        d_max_hist;
+  /* Items not yet consumed by all the decoders */
+  std::vector<uint8_t>                          d_hist;
+  size_t                                        d_hist_len;
+  /* Items consumed by each decoder, relative to the start of d_hist */
+  std::vector<size_t>                           d_offset;
+  std::vector<std::vector<pmt::pmt_t> >         d_frames;
+  std::vector<std::thread>                      d_workers;
+  std::mutex                                    d_mtx;
+  std::condition_variable                       d_start_cv;
+  std::condition_variable                       d_done_cv;
+  uint64_t                                      d_round;
+  bool                                          d_stop;
+  const uint8_t                                *d_in;
+  size_t                                        d_nitems;
+  std::atomic<size_t>                           d_next;
+  std::atomic<size_t>                           d_done;
+
+  void
+  worker();
+
+  void
+  run_decoders();
+
+  void
+  run_decoder(size_t idx);
+
+  void
+  reset(pmt::pmt_t m);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_MULTI_FRAME_DECODER_IMPL_H */
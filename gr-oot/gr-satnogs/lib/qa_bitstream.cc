@@ -0,0 +1,115 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <satnogs/bitstream.h>
+#include <deque>
+#include <random>
+
+namespace gr {
+namespace satnogs {
+
+BOOST_AUTO_TEST_CASE(bitstream_capacity)
+{
+  bitstream b(100);
+  BOOST_REQUIRE(b.capacity() == 128);
+  BOOST_REQUIRE(b.empty());
+  BOOST_REQUIRE(b.space() == 128);
+  BOOST_REQUIRE_THROW(bitstream(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(bitstream_fifo)
+{
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<size_t> len(0, 300);
+  std::uniform_int_distribution<uint8_t> uni(0, 1);
+  std::uniform_int_distribution<size_t> nbits(1, 64);
+  bitstream b(512);
+  std::deque<uint8_t> ref;
+  uint8_t in[300];
+
+  for (size_t iter = 0; iter < 2000; iter++) {
+    size_t n = len(mt);
+    for (size_t i = 0; i < n; i++) {
+      in[i] = uni(mt);
+    }
+    size_t ret = b.push_back(in, n);
+    BOOST_REQUIRE(ret == std::min(n, 512 - ref.size()));
+    ref.insert(ref.end(), in, in + ret);
+    BOOST_REQUIRE(b.size() == ref.size());
+
+    for (size_t i = 0; i < ref.size(); i++) {
+      BOOST_REQUIRE(b[i] == ref[i]);
+    }
+    for (size_t i = 0; i < ref.size(); i++) {
+      size_t nb = std::min(nbits(mt), ref.size() - i);
+      uint64_t expected = 0;
+      for (size_t j = 0; j < nb; j++) {
+        expected |= static_cast<uint64_t>(ref[i + j]) << j;
+      }
+      BOOST_REQUIRE(b.get(i, nb) == expected);
+    }
+
+    size_t c = std::min(len(mt), ref.size());
+    b.consume(c);
+    ref.erase(ref.begin(), ref.begin() + c);
+    BOOST_REQUIRE(b.size() == ref.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bitstream_words)
+{
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<uint8_t> uni(0, 1);
+  std::uniform_int_distribution<size_t> nbits(1, 64);
+  bitstream b(256);
+  std::deque<uint8_t> ref;
+  uint8_t in[64];
+
+  for (size_t iter = 0; iter < 2000; iter++) {
+    size_t n = std::min(nbits(mt), b.space());
+    for (size_t i = 0; i < n; i++) {
+      in[i] = uni(mt);
+    }
+    uint64_t w = bitstream::pack(in, n);
+    for (size_t i = 0; i < n; i++) {
+      BOOST_REQUIRE(((w >> i) & 0x1) == in[i]);
+    }
+    /* Garbage above nbits should be ignored */
+    if (n < 64) {
+      w |= ~0ULL << n;
+    }
+    b.push_back_bits(w, n);
+    ref.insert(ref.end(), in, in + n);
+    BOOST_REQUIRE(b.size() == ref.size());
+    for (size_t i = 0; i < ref.size(); i++) {
+      BOOST_REQUIRE(b[i] == ref[i]);
+    }
+
+    size_t c = std::min(nbits(mt), ref.size());
+    b.consume(c);
+    ref.erase(ref.begin(), ref.begin() + c);
+  }
+}
+
+} // namespace satnogs
+} // namespace gr
+
@@ -0,0 +1,124 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <satnogs/chirp_rotator.h>
+#include <satnogs/doppler_fit.h>
+#include <complex>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace gr {
+
+namespace satnogs {
+
+BOOST_AUTO_TEST_CASE(chirp_rotator_shift_polynomial)
+{
+  double c[4] = {1.0, -2.0, 0.5, 0.25};
+  double s[4] = {1.0, -2.0, 0.5, 0.25};
+  const double x0 = 3.5;
+  chirp_rotator::shift_polynomial(s, 4, x0);
+  for (double x = -4.0; x < 4.0; x += 0.5) {
+    const double p = ((c[3] * (x + x0) + c[2]) * (x + x0) + c[1]) * (x + x0)
+                     + c[0];
+    const double q = ((s[3] * x + s[2]) * x + s[1]) * x + s[0];
+    BOOST_REQUIRE_CLOSE(p, q, 1e-9);
+  }
+}
+
+/*
+ * The output should follow the integral of the frequency polynomial,
+ * regardless of how the stream is split into buffers
+ */
+BOOST_AUTO_TEST_CASE(chirp_rotator_continuous_phase)
+{
+  const size_t len = 500000;
+  const double fs = 48e3;
+  const double f[4] = {1200.0, 100.0 / fs, 2.0 / fs / fs, 0.01 / fs / fs / fs};
+  double w[4];
+  for (size_t k = 0; k < 4; k++) {
+    w[k] = 2 * M_PI * f[k] / fs;
+  }
+
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<size_t> uni(1, 3000);
+  std::vector<gr_complex> in(len, gr_complex(1.0, 0.0));
+  std::vector<gr_complex> out(len);
+  chirp_rotator r;
+  size_t done = 0;
+  while (done < len) {
+    const size_t n = std::min(uni(mt), len - done);
+    double c[4] = {w[0], w[1], w[2], w[3]};
+    chirp_rotator::shift_polynomial(c, 4, done);
+    r.rotate(out.data() + done, in.data() + done, n, c, 4);
+    done += n;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    const double x = i;
+    const double phase = (((w[3] / 4 * x + w[2] / 3) * x + w[1] / 2) * x + w[0])
+                         * x;
+    const std::complex<double> ref = std::polar(1.0, phase);
+    BOOST_REQUIRE(std::abs(std::complex<double>(out[i]) - ref) < 1e-3);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(doppler_fit_polynomial)
+{
+  doppler_fit fit(4);
+  double c[4];
+  BOOST_REQUIRE(!fit.polynomial(c, 0));
+
+  /* A cubic is fitted exactly by four points */
+  auto f = [](double x) {
+    return -1500.0 + 0.01 * x + 2e-8 * x * x - 1e-14 * x * x * x;
+  };
+  for (uint64_t x = 100000; x <= 400000; x += 100000) {
+    fit.fit(x, f(x));
+  }
+  BOOST_REQUIRE(fit.polynomial(c, 400000));
+  for (double x = 0; x < 200000; x += 1000) {
+    const double y = ((c[3] * x + c[2]) * x + c[1]) * x + c[0];
+    BOOST_REQUIRE_CLOSE(y, f(400000 + x), 1e-6);
+  }
+
+  double freqs[10];
+  fit.predict_freqs(freqs, 10, 4800, 400000);
+  for (size_t i = 0; i < 10; i++) {
+    BOOST_REQUIRE_CLOSE(freqs[i], f(400000 + i * 4800.0), 1e-6);
+  }
+
+  /* After a reset the fit needs four new points */
+  fit.reset();
+  BOOST_REQUIRE(!fit.polynomial(c, 0));
+  for (uint64_t x = 500000; x < 800000; x += 100000) {
+    fit.fit(x, -f(x));
+    BOOST_REQUIRE(!fit.polynomial(c, 0));
+  }
+  fit.fit(800000, -f(800000));
+  BOOST_REQUIRE(fit.polynomial(c, 800000));
+  BOOST_REQUIRE_CLOSE(c[0], -f(800000), 1e-6);
+}
+
+}  // namespace satnogs
+
+}  // namespace gr
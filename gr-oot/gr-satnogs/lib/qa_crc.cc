@@ -82,6 +82,72 @@ BOOST_AUTO_TEST_CASE(CRC32_C)
   BOOST_REQUIRE(crc1 != crc2);
 }
 
+/*
+ * Bit at a time reference implementation, used to check all the table and
+ * SIMD code paths
+ */
+static uint32_t
+crc_bitwise(const uint8_t *data, size_t len, size_t width, uint32_t poly,
+            bool reflected, uint32_t init, uint32_t xorout)
+{
+  const uint32_t mask = width == 32 ? 0xFFFFFFFF : (1U << width) - 1;
+  uint32_t reg = init;
+  for (size_t i = 0; i < len; i++) {
+    for (size_t j = 0; j < 8; j++) {
+      uint32_t bit;
+      if (reflected) {
+        bit = ((data[i] >> j) ^ reg) & 1;
+        reg = (reg >> 1) ^ (bit ? poly : 0);
+      }
+      else {
+        bit = ((data[i] >> (7 - j)) ^ (reg >> (width - 1))) & 1;
+        reg = ((reg << 1) ^ (bit ? poly : 0)) & mask;
+      }
+    }
+  }
+  return reg ^ xorout;
+}
+
+BOOST_AUTO_TEST_CASE(crc_check_values)
+{
+  const uint8_t msg[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  BOOST_REQUIRE(crc::crc16_ccitt(msg, sizeof(msg)) == 0x31C3);
+  BOOST_REQUIRE(crc::crc16_aug_ccitt(msg, sizeof(msg)) == 0x1A33);
+  BOOST_REQUIRE(crc::crc16_ccitt_reversed(msg, sizeof(msg)) == 0x906E);
+  BOOST_REQUIRE(crc::crc16_ax25(msg, sizeof(msg)) == 0x906E);
+  BOOST_REQUIRE(crc::crc16_ibm(msg, sizeof(msg)) == 0xAEE7);
+  BOOST_REQUIRE(crc::crc32_c(msg, sizeof(msg)) == 0xE3069283);
+}
+
+BOOST_AUTO_TEST_CASE(crc_lengths)
+{
+  std::mt19937 mt(42);
+  std::uniform_int_distribution<uint16_t> uni(0, 0xFF);
+  std::vector<uint8_t> d(600);
+  std::generate(d.begin(), d.end(), [&] {
+    return uni(mt);
+  });
+
+  for (size_t len = 0; len < 520; len++) {
+    for (size_t off = 0; off < 4; off++) {
+      const uint8_t *p = d.data() + off;
+      BOOST_REQUIRE(crc::crc16_ccitt(p, len)
+                    == crc_bitwise(p, len, 16, 0x1021, false, 0, 0));
+      BOOST_REQUIRE(crc::crc16_aug_ccitt(p, len)
+                    == crc_bitwise(p, len, 16, 0x1021, false, 0x1D0F, 0xFFFF));
+      BOOST_REQUIRE(crc::crc16_ccitt_reversed(p, len)
+                    == crc_bitwise(p, len, 16, 0x8408, true, 0xFFFF, 0xFFFF));
+      BOOST_REQUIRE(crc::crc16_ax25(p, len)
+                    == crc_bitwise(p, len, 16, 0x8408, true, 0xFFFF, 0xFFFF));
+      BOOST_REQUIRE(crc::crc16_ibm(p, len)
+                    == crc_bitwise(p, len, 16, 0x8005, false, 0xFFFF, 0));
+      BOOST_REQUIRE(crc::crc32_c(p, len)
+                    == crc_bitwise(p, len, 32, 0x82F63B78, true, 0xFFFFFFFF,
+                                   0xFFFFFFFF));
+    }
+  }
+}
+
 }  // namespace satnogs
 
 }  // namespace gr
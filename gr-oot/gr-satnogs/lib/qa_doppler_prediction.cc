@@ -0,0 +1,125 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <satnogs/chirp_rotator.h>
+#include <satnogs/doppler_fit.h>
+#include "doppler_prediction.h"
+#include <thread>
+
+namespace gr {
+
+namespace satnogs {
+
+BOOST_AUTO_TEST_CASE(doppler_prediction_latest)
+{
+  doppler_prediction p;
+  doppler_prediction::slot s = doppler_prediction::slot();
+  BOOST_REQUIRE(!p.consume(s));
+
+  for (size_t i = 1; i <= 3; i++) {
+    doppler_prediction::slot &b = p.back();
+    b.start = i * 100;
+    b.origin = i;
+    b.valid = true;
+    b.coeffs[0] = i;
+    p.publish();
+  }
+  BOOST_REQUIRE(p.consume(s));
+  BOOST_REQUIRE_EQUAL(s.seq, 3);
+  BOOST_REQUIRE_EQUAL(s.start, 300);
+  BOOST_REQUIRE_EQUAL(s.eval(1000), 3.0);
+  BOOST_REQUIRE(!p.consume(s));
+}
+
+/*
+ * The measurements stop at index 3000. The fit is followed up to the
+ * horizon, one measurement interval later, and then its frequency is held
+ */
+BOOST_AUTO_TEST_CASE(doppler_prediction_gap)
+{
+  doppler_fit f(4);
+  for (uint64_t x = 0; x <= 3000; x += 1000) {
+    f.fit(x, 10.0 + 0.01 * x - 1e-6 * x * x);
+  }
+  BOOST_REQUIRE_EQUAL(f.horizon(), 4000);
+
+  doppler_prediction::slot s = doppler_prediction::slot();
+  s.origin = 3000;
+  s.end = f.horizon();
+  s.valid = f.polynomial(s.coeffs, s.origin);
+  BOOST_REQUIRE(s.valid);
+  BOOST_REQUIRE_CLOSE(s.eval(3500), 10.0 + 35.0 - 12.25, 1e-6);
+  BOOST_REQUIRE_CLOSE(s.eval(4000), 10.0 + 40.0 - 16.0, 1e-6);
+  BOOST_REQUIRE_EQUAL(s.eval(100000), s.eval(4000));
+
+  /* A run across the horizon is split there */
+  double c[chirp_rotator::max_coeffs];
+  BOOST_REQUIRE_EQUAL(s.polynomial(c, 3500, 1000), 501);
+  BOOST_REQUIRE_CLOSE(c[0], s.eval(3500), 1e-6);
+  BOOST_REQUIRE_EQUAL(s.polynomial(c, 4001, 1000), 1000);
+  BOOST_REQUIRE_EQUAL(c[0], s.eval(4000));
+  for (size_t i = 1; i < chirp_rotator::max_coeffs; i++) {
+    BOOST_REQUIRE_EQUAL(c[i], 0.0);
+  }
+}
+
+/*
+ * Each published slot is filled with values derived from its sequence
+ * number, so a slot modified while the reader copies it is detected
+ */
+BOOST_AUTO_TEST_CASE(doppler_prediction_concurrent)
+{
+  const uint64_t n = 200000;
+  doppler_prediction p;
+
+  std::thread writer([&p, n]() {
+    for (uint64_t i = 1; i <= n; i++) {
+      doppler_prediction::slot &b = p.back();
+      b.start = i;
+      b.origin = 2 * i;
+      b.valid = true;
+      for (size_t k = 0; k < chirp_rotator::max_coeffs; k++) {
+        b.coeffs[k] = i + k;
+      }
+      p.publish();
+    }
+  });
+
+  doppler_prediction::slot s = doppler_prediction::slot();
+  uint64_t last = 0;
+  while (last < n) {
+    if (!p.consume(s)) {
+      continue;
+    }
+    BOOST_REQUIRE_GT(s.seq, last);
+    BOOST_REQUIRE_EQUAL(s.start, s.seq);
+    BOOST_REQUIRE_EQUAL(s.origin, 2 * s.seq);
+    for (size_t k = 0; k < chirp_rotator::max_coeffs; k++) {
+      BOOST_REQUIRE_EQUAL(s.coeffs[k], s.seq + k);
+    }
+    last = s.seq;
+  }
+  writer.join();
+}
+
+}  // namespace satnogs
+
+}  // namespace gr
@@ -0,0 +1,147 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <satnogs/doppler_resampler_cc.h>
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/vector_source.h>
+#include <gnuradio/blocks/vector_sink.h>
+#include <complex>
+#include <cmath>
+#include <vector>
+
+namespace gr {
+
+namespace satnogs {
+
+static const double samp_rate = 2.4e6;
+static const double out_samp_rate = 48e3;
+static const double lo_offset = 100e3;
+static const double sat_freq = 437e6;
+static const double duration = 3.0;
+
+/* The Doppler shift of the test signal, in Hz */
+static double
+doppler(double t)
+{
+  return 5000.0 + 200.0 * t - 10.0 * t * t;
+}
+
+/*
+ * Passes a tone at the LO offset plus the Doppler shift through the block,
+ * after posting the predictions of the first npred seconds
+ */
+static std::vector<gr_complex>
+run(size_t npred, double len_s = duration)
+{
+  const size_t len = samp_rate * len_s;
+  std::vector<gr_complex> in(len);
+  double phase = 0.0;
+  for (size_t i = 0; i < len; i++) {
+    in[i] = std::polar(1.0, phase);
+    phase += 2 * M_PI * (lo_offset + doppler(i / samp_rate)) / samp_rate;
+    phase = std::remainder(phase, 2 * M_PI);
+  }
+
+  top_block_sptr tb = make_top_block("doppler_resampler_cc");
+  blocks::vector_source_c::sptr src = blocks::vector_source_c::make(in);
+  doppler_resampler_cc::sptr r = doppler_resampler_cc::make(samp_rate,
+                                 sat_freq, lo_offset, out_samp_rate);
+  blocks::vector_sink_c::sptr sink = blocks::vector_sink_c::make();
+  for (size_t k = 0; k < npred; k++) {
+    r->_post(pmt::mp("doppler"),
+             pmt::cons(pmt::from_uint64(k * samp_rate),
+                       pmt::from_double(sat_freq + doppler(k))));
+  }
+  tb->connect(src, 0, r, 0);
+  tb->connect(r, 0, sink, 0);
+  tb->run();
+  return sink->data();
+}
+
+/*
+ * Checks the output rate and gain and returns the frequency of the output,
+ * averaged over blocks of 10 ms. The first 100 ms are skipped, as the
+ * filters settle
+ */
+static std::vector<double>
+check(const std::vector<gr_complex> &out, double len_s = duration)
+{
+  const size_t block = out_samp_rate / 100;
+  BOOST_REQUIRE(std::abs(out.size() - out_samp_rate * len_s) < block);
+
+  std::vector<double> freqs;
+  for (size_t i = out_samp_rate / 10; i + block < out.size(); i += block) {
+    std::complex<double> d(0.0, 0.0);
+    for (size_t j = i; j < i + block; j++) {
+      BOOST_REQUIRE_CLOSE(std::abs(out[j]), 1.0, 2.0);
+      d += std::complex<double>(out[j + 1] * std::conj(out[j]));
+    }
+    freqs.push_back(std::arg(d) * out_samp_rate / (2 * M_PI));
+  }
+  return freqs;
+}
+
+/*
+ * With less than four predictions the Doppler fit is not ready, so only the
+ * LO offset is removed and the output carries the Doppler shift
+ */
+BOOST_AUTO_TEST_CASE(doppler_resampler_cc_lo_offset)
+{
+  const std::vector<double> freqs = check(run(3));
+  const size_t block = out_samp_rate / 100;
+  for (size_t i = 0; i < freqs.size(); i++) {
+    const double t = (out_samp_rate / 10 + (i + 0.5) * block) / out_samp_rate;
+    BOOST_REQUIRE(std::abs(freqs[i] - doppler(t)) < 1.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(doppler_resampler_cc_doppler)
+{
+  const std::vector<double> freqs = check(run(4));
+  for (double f : freqs) {
+    BOOST_REQUIRE(std::abs(f) < 0.2);
+  }
+}
+
+/*
+ * The predictions stop after 3 s. The fit is followed for one more
+ * prediction interval and then its frequency is held, so the output drifts
+ * only by the Doppler change since then, instead of following the diverging
+ * extrapolation of the fit
+ */
+BOOST_AUTO_TEST_CASE(doppler_resampler_cc_gap)
+{
+  const double len_s = 5.5;
+  const double horizon = 4.0;
+  const std::vector<double> freqs = check(run(4, len_s), len_s);
+  const size_t block = out_samp_rate / 100;
+  for (size_t i = 0; i < freqs.size(); i++) {
+    const double t = (out_samp_rate / 10 + (i + 0.5) * block) / out_samp_rate;
+    if (std::abs(t - horizon) < 0.02) {
+      continue;
+    }
+    const double expected = t < horizon ? 0.0 : doppler(t) - doppler(horizon);
+    BOOST_REQUIRE(std::abs(freqs[i] - expected) < 1.0);
+  }
+}
+
+}  // namespace satnogs
+
+}  // namespace gr
@@ -0,0 +1,121 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <satnogs/frame_metadata.h>
+#include <vector>
+
+namespace gr {
+namespace satnogs {
+
+static frame_metadata
+make_frame(const std::vector<uint8_t> &pdu)
+{
+  frame_metadata f;
+  f.set(metadata::PDU, pmt::make_blob(pdu.data(), pdu.size()));
+  f.set(metadata::DECODER_CRC_VALID, pmt::from_bool(true));
+  f.set(metadata::CENTER_FREQ, pmt::from_double(435.123456789e6));
+  f.set(metadata::FREQ_OFFSET, pmt::from_double(-1234.5678901234));
+  f.set(metadata::DECODER_PHASE_DELAY, pmt::from_uint64(7));
+  f.set(metadata::DECODER_RESAMPLING_RATIO, pmt::from_float(1.00012f));
+  f.set(metadata::DECODER_CORRECTED_BITS, pmt::from_uint64(UINT64_MAX));
+  f.set(metadata::TIME, pmt::mp("2021-03-04T05:06:07.123456Z"));
+  f.set(metadata::SAMPLE_START, pmt::from_uint64(123456789012345ULL));
+  f.set(metadata::SAMPLE_CNT, pmt::from_uint64(4096));
+  f.set(metadata::DECODER_SYMBOL_ERASURES, pmt::from_uint64(0));
+  f.set(metadata::SNR, pmt::from_float(12.3f));
+  f.set(metadata::DECODER_NAME, pmt::mp("name \"quoted\" \\ back\\slash"));
+  f.set(metadata::DECODER_VERSION, pmt::mp("1.0\n\r\t\x01\x1f end"));
+  f.set(metadata::ANTENNA_AZIMUTH, pmt::from_double(359.99999999999));
+  f.set(metadata::ANTENNA_ELEVATION, pmt::from_double(1e-300));
+  f.set(metadata::ANTENNA_POLARIZATION, pmt::mp("RHCP \xce\xb1"));
+  f.set(metadata::SYMBOL_TIMING_ERROR, pmt::from_double(-0.000123));
+  f.set(metadata::DECODER_ID, pmt::from_long(-42));
+  return f;
+}
+
+/*
+ * The float fields are written with float precision, so they are compared
+ * after the conversion back to float
+ */
+static void
+check_equal(const nlohmann::json &a, const nlohmann::json &b)
+{
+  BOOST_REQUIRE(a.size() == b.size());
+  for (auto it = a.begin(); it != a.end(); ++it) {
+    BOOST_REQUIRE(b.contains(it.key()));
+    const nlohmann::json &v = b[it.key()];
+    if (it.key() == metadata::value(metadata::SNR)
+        || it.key() == metadata::value(metadata::DECODER_RESAMPLING_RATIO)) {
+      BOOST_REQUIRE(it->get<float>() == v.get<float>());
+    }
+    else {
+      BOOST_REQUIRE(*it == v);
+    }
+  }
+}
+
+/*
+ * The compact output of the json_converter, written by write_json(), should
+ * match the indented output, created by to_json()
+ */
+BOOST_AUTO_TEST_CASE(frame_metadata_write_json)
+{
+  const nlohmann::json extra = nlohmann::json::parse(
+                                 "{\"station\": \"a \\\"b\\\"\", \"id\": 3}");
+  const std::string extra_member = "\"extra\":" + extra.dump();
+
+  for (size_t len = 0; len < 8; len++) {
+    std::vector<uint8_t> pdu(len);
+    for (size_t i = 0; i < len; i++) {
+      pdu[i] = 0xff - 37 * i;
+    }
+    const frame_metadata f = make_frame(pdu);
+
+    nlohmann::json ref = f.to_json();
+    ref["extra"] = extra;
+    const nlohmann::json indented = nlohmann::json::parse(ref.dump(4, ' ',
+                                    true));
+
+    std::string s;
+    f.write_json(s, extra_member);
+    const nlohmann::json compact = nlohmann::json::parse(s);
+    check_equal(indented, compact);
+    check_equal(compact, indented);
+
+    s.clear();
+    f.write_json(s);
+    check_equal(f.to_json(), nlohmann::json::parse(s));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(frame_metadata_write_json_empty)
+{
+  frame_metadata f;
+  std::string s;
+  f.write_json(s);
+  BOOST_REQUIRE(s == "{}");
+
+  s.clear();
+  f.write_json(s, "\"extra\":null");
+  BOOST_REQUIRE(nlohmann::json::parse(s)["extra"].is_null());
+}
+
+}  // namespace satnogs
+}  // namespace gr
@@ -0,0 +1,268 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <satnogs/frame_store.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+namespace gr {
+namespace satnogs {
+
+/*
+ * Creates an empty directory for the segments of a test and removes it,
+ * together with the segments, at the end
+ */
+class segment_dir {
+public:
+  segment_dir()
+  {
+    char tmpl[] = "/tmp/qa_frame_store_XXXXXX";
+    BOOST_REQUIRE(mkdtemp(tmpl));
+    d_path = tmpl;
+  }
+
+  ~segment_dir()
+  {
+    for (const std::string &f : d_files) {
+      std::remove(f.c_str());
+    }
+    rmdir(d_path.c_str());
+  }
+
+  std::string
+  prefix() const
+  {
+    return d_path + "/test";
+  }
+
+  std::string
+  add(const std::string &f)
+  {
+    d_files.insert(f);
+    return f;
+  }
+
+private:
+  std::string           d_path;
+  std::set<std::string> d_files;
+};
+
+static std::vector<uint8_t>
+make_frame(size_t len, uint8_t seed)
+{
+  std::vector<uint8_t> f(len);
+  for (size_t i = 0; i < len; i++) {
+    f[i] = seed + i * 7;
+  }
+  return f;
+}
+
+static std::vector<uint8_t>
+load(const std::string &filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(in),
+                              std::istreambuf_iterator<char>());
+}
+
+static void
+store(const std::string &filename, const std::vector<uint8_t> &b)
+{
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(b.data()), b.size());
+}
+
+static const uint64_t t0 = 1614834367000000ULL;
+
+BOOST_AUTO_TEST_CASE(frame_store_round_trip)
+{
+  segment_dir dir;
+  std::string filename;
+  {
+    frame_store_writer w(dir.prefix());
+    for (size_t i = 0; i < 32; i++) {
+      std::vector<uint8_t> f = make_frame(i, i);
+      w.append(f.data(), f.size(), t0 + i * 1000, i * 4096);
+    }
+    filename = dir.add(w.filename());
+    w.close();
+  }
+
+  frame_store_reader r(filename);
+  BOOST_REQUIRE_EQUAL(r.size(), 32);
+  for (size_t i = 0; i < 32; i++) {
+    frame_store_record rec = r.read(i);
+    BOOST_REQUIRE(rec.data == make_frame(i, i));
+    BOOST_REQUIRE_EQUAL(rec.time_us, t0 + i * 1000);
+    BOOST_REQUIRE_EQUAL(rec.sample_start, i * 4096);
+  }
+  BOOST_CHECK_THROW(r.read(32), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(frame_store_rotation)
+{
+  /* Header, record header, 10 bytes of data and CRC */
+  const size_t record_len = 24 + 10 + 4;
+  const size_t segment_size = 8 + 3 * record_len;
+  segment_dir dir;
+  std::vector<std::string> files;
+  {
+    frame_store_writer w(dir.prefix(), segment_size);
+    for (size_t i = 0; i < 7; i++) {
+      std::vector<uint8_t> f = make_frame(10, i);
+      w.append(f.data(), f.size(), t0 + i * 1000000, i);
+      if (files.empty() || files.back() != w.filename()) {
+        files.push_back(dir.add(w.filename()));
+      }
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(files.size(), 3);
+  size_t idx = 0;
+  for (const std::string &f : files) {
+    frame_store_reader r(f);
+    BOOST_REQUIRE_EQUAL(r.size(), idx < 6 ? 3 : 1);
+    for (size_t i = 0; i < r.size(); i++, idx++) {
+      BOOST_REQUIRE(r.read(i).data == make_frame(10, idx));
+      BOOST_REQUIRE_EQUAL(r.read(i).sample_start, idx);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(idx, 7);
+}
+
+BOOST_AUTO_TEST_CASE(frame_store_unclosed)
+{
+  segment_dir dir;
+  const std::string copy = dir.add(dir.prefix() + "_copy.frames");
+  std::string filename;
+  {
+    frame_store_writer w(dir.prefix());
+    for (size_t i = 0; i < 10; i++) {
+      std::vector<uint8_t> f = make_frame(100 + i, i);
+      w.append(f.data(), f.size(), t0 + i, i);
+    }
+    w.flush();
+    filename = dir.add(w.filename());
+    /* A segment that was never closed, e.g. after a crash */
+    store(copy, load(filename));
+  }
+
+  frame_store_reader r(copy);
+  BOOST_REQUIRE_EQUAL(r.size(), 10);
+  for (size_t i = 0; i < 10; i++) {
+    BOOST_REQUIRE(r.read(i).data == make_frame(100 + i, i));
+  }
+
+  /* A partially written record at the end is dropped */
+  std::vector<uint8_t> b = load(copy);
+  b.resize(b.size() - 10);
+  store(copy, b);
+  BOOST_REQUIRE_EQUAL(frame_store_reader(copy).size(), 9);
+
+  /*
+   * An interrupted close leaves part of the index without a trailer. It
+   * should not be parsed as records
+   */
+  b = load(filename);
+  b.resize(b.size() - 30);
+  store(copy, b);
+  frame_store_reader s(copy);
+  BOOST_REQUIRE_EQUAL(s.size(), 10);
+  BOOST_REQUIRE(s.read(9).data == make_frame(109, 9));
+
+  /* A corrupted record ends the scan */
+  b = load(filename);
+  b.resize(b.size() - 20);
+  b[8 + 24 + 100 + 4 + 30] ^= 1;
+  store(copy, b);
+  BOOST_REQUIRE_EQUAL(frame_store_reader(copy).size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(frame_store_flush_interval)
+{
+  segment_dir dir;
+  frame_store_writer w(dir.prefix(), 1024 * 1024, 1024 * 1024, 0.05);
+  std::vector<uint8_t> f = make_frame(64, 1);
+  w.append(f.data(), f.size(), t0, 0);
+  const std::string filename = dir.add(w.filename());
+
+  /* No more frames are appended, so only the timer can write the record */
+  for (size_t i = 0; i < 100 && load(filename).size() < 8 + 24 + 64 + 4;
+       i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  frame_store_reader r(filename);
+  BOOST_REQUIRE_EQUAL(r.size(), 1);
+  BOOST_REQUIRE(r.read(0).data == f);
+}
+
+static void
+check_seek(frame_store_reader &r)
+{
+  BOOST_REQUIRE_EQUAL(r.size(), 5);
+  /* Times 100, 300, 200, 400, 200 */
+  BOOST_CHECK_EQUAL(r.find_time(t0), 0);
+  BOOST_CHECK_EQUAL(r.find_time(t0 + 100), 0);
+  BOOST_CHECK_EQUAL(r.find_time(t0 + 150), 2);
+  BOOST_CHECK_EQUAL(r.find_time(t0 + 201), 1);
+  BOOST_CHECK_EQUAL(r.find_time(t0 + 400), 3);
+  BOOST_CHECK_EQUAL(r.find_time(t0 + 401), 5);
+
+  /* Samples 10, unknown, 5, 40, unknown */
+  BOOST_CHECK_EQUAL(r.find_sample(0), 2);
+  BOOST_CHECK_EQUAL(r.find_sample(6), 0);
+  BOOST_CHECK_EQUAL(r.find_sample(11), 3);
+  BOOST_CHECK_EQUAL(r.find_sample(41), 5);
+  BOOST_CHECK_EQUAL(r.find_sample(UINT64_MAX), 5);
+}
+
+BOOST_AUTO_TEST_CASE(frame_store_seek)
+{
+  const uint64_t time[] = {100, 300, 200, 400, 200};
+  const uint64_t sample[] = {10, UINT64_MAX, 5, 40, UINT64_MAX};
+  segment_dir dir;
+  const std::string copy = dir.add(dir.prefix() + "_copy.frames");
+  std::string filename;
+  {
+    frame_store_writer w(dir.prefix());
+    for (size_t i = 0; i < 5; i++) {
+      std::vector<uint8_t> f = make_frame(16, i);
+      w.append(f.data(), f.size(), t0 + time[i], sample[i]);
+    }
+    w.flush();
+    filename = dir.add(w.filename());
+    store(copy, load(filename));
+  }
+
+  /* Through the index and through the scan of an unclosed segment */
+  frame_store_reader r(filename);
+  check_seek(r);
+  frame_store_reader s(copy);
+  check_seek(s);
+}
+
+}  // namespace satnogs
+}  // namespace gr
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <satnogs/sgp4.h>
+#include <cmath>
+#include <stdexcept>
+
+namespace gr {
+
+namespace satnogs {
+
+/*
+ * Test case of the Spacetrack Report #3, with the reference values of
+ * Vallado et al., "Revisiting Spacetrack Report #3"
+ */
+BOOST_AUTO_TEST_CASE(sgp4_str3)
+{
+  const double ref[][7] = {
+    {0.0, 2328.96975262, -5995.22051338, 1719.97297192, 2.91207328, -0.98341796, -7.09081621},
+    {360.0, 2456.10706533, -6071.93855503, 1222.89768554, 2.67939004, -0.44829081, -7.22879215},
+    {720.0, 2567.56229695, -6112.50383922, 713.96374435, 2.44024575, 0.09810900, -7.31995926},
+    {1080.0, 2663.08964352, -6115.48290885, 196.40072866, 2.19612156, 0.65241509, -7.36282415},
+    {1440.0, 2742.55398832, -6079.67009123, -326.39012649, 1.94849765, 1.21107268, -7.35619313}
+  };
+  sgp4 s("1 88888U          80275.98708465  .00073094  13844-3  66816-4 0    8",
+         "2 88888  72.8435 115.9689 0086731  52.6988 110.5714 16.05824518  105");
+  for (size_t i = 0; i < 5; i++) {
+    double pos[3];
+    double vel[3];
+    s.propagate(ref[i][0], pos, vel);
+    for (size_t j = 0; j < 3; j++) {
+      BOOST_REQUIRE(std::abs(pos[j] - ref[i][j + 1]) < 1e-3);
+      BOOST_REQUIRE(std::abs(vel[j] - ref[i][j + 4]) < 1e-6);
+    }
+  }
+  /* 1980-10-01 23:41:24 UTC */
+  BOOST_REQUIRE(std::abs(s.epoch() - 339291684.11376) < 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(sgp4_gmst)
+{
+  /* J2000.0, 2000-01-01 12:00:00 UTC */
+  BOOST_REQUIRE(std::abs(sgp4::gmst(946728000.0)
+                         - 280.46061837 * M_PI / 180.0) < 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(sgp4_invalid)
+{
+  /* Geostationary orbits need the deep space model */
+  BOOST_REQUIRE_THROW(
+    sgp4("1 28884U 05041A   21001.00000000 -.00000280  00000-0  00000-0 0  9990",
+         "2 28884   0.0195 279.3780 0002479 102.6270 316.4426  1.00273094 55800"),
+    std::invalid_argument);
+  BOOST_REQUIRE_THROW(sgp4("1 88888U", "2 88888"), std::invalid_argument);
+}
+
+}  // namespace satnogs
+
+}  // namespace gr
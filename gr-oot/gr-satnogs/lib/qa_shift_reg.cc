@@ -0,0 +1,109 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <satnogs/shift_reg.h>
+#include <deque>
+#include <random>
+
+namespace gr {
+namespace satnogs {
+
+static void
+check_reg(const shift_reg &r, const std::deque<bool> &ref)
+{
+  size_t cnt = 0;
+  for (size_t i = 0; i < ref.size(); i++) {
+    BOOST_REQUIRE(r[i] == ref[i]);
+    cnt += ref[i];
+  }
+  BOOST_REQUIRE(r.count() == cnt);
+  BOOST_REQUIRE(r.front() == ref.front());
+  BOOST_REQUIRE(r.back() == ref.back());
+}
+
+BOOST_AUTO_TEST_CASE(shift_reg_shift)
+{
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<uint8_t> uni(0, 1);
+  const size_t lens[] = {1, 8, 32, 63, 64, 65, 100, 128, 200};
+
+  for (size_t len : lens) {
+    shift_reg r(len);
+    std::deque<bool> ref(len, false);
+    check_reg(r, ref);
+    r.set();
+    BOOST_REQUIRE(r.count() == len);
+    r.reset();
+    BOOST_REQUIRE(r.count() == 0);
+
+    for (size_t i = 0; i < 1000; i++) {
+      bool b = uni(mt);
+      if (uni(mt)) {
+        r <<= b;
+        ref.pop_front();
+        ref.push_back(b);
+      }
+      else {
+        r >>= b;
+        ref.pop_back();
+        ref.push_front(b);
+      }
+      check_reg(r, ref);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(shift_reg_hamming_distance)
+{
+  std::random_device rd;
+  std::mt19937 mt(rd());
+  std::uniform_int_distribution<uint8_t> uni(0, 1);
+  const size_t lens[] = {8, 32, 64, 96, 150};
+
+  for (size_t len : lens) {
+    shift_reg a(len);
+    shift_reg b(len);
+    for (size_t i = 0; i < 1000; i++) {
+      a <<= uni(mt);
+      b <<= uni(mt);
+      size_t dist = 0;
+      for (size_t j = 0; j < len; j++) {
+        dist += a[j] != b[j];
+      }
+      BOOST_REQUIRE(a.hamming_distance(b) == dist);
+      BOOST_REQUIRE((a ^ b).count() == dist);
+
+      shift_reg c(a);
+      c &= b;
+      shift_reg d(a);
+      d |= b;
+      for (size_t j = 0; j < len; j++) {
+        BOOST_REQUIRE(c[j] == (a[j] & b[j]));
+        BOOST_REQUIRE(d[j] == (a[j] | b[j]));
+        BOOST_REQUIRE((a & b)[j] == c[j]);
+        BOOST_REQUIRE((a | b)[j] == d[j]);
+      }
+    }
+  }
+}
+
+} // namespace satnogs
+} // namespace gr
@@ -126,6 +126,92 @@ BOOST_AUTO_TEST_CASE(whitening_ccsds_unpacked)
 }
 
 
+/*
+ * The packed methods process several bits at a time, so check them against
+ * the bit by bit methods
+ */
+static void
+whitening_packed_unpacked(whitening::whitening_sptr packed,
+                          whitening::whitening_sptr unpacked, bool msb)
+{
+  std::mt19937 mt(42);
+  std::uniform_int_distribution<uint8_t> uni(0, 0xFF);
+
+  uint8_t orig[LEN];
+  uint8_t orig_bits[LEN * 8];
+  uint8_t out[LEN];
+  uint8_t out_bits[LEN * 8];
+
+  for (size_t i = 0; i < LEN; i++) {
+    orig[i] = uni(mt);
+    for (size_t j = 0; j < 8; j++) {
+      orig_bits[i * 8 + j] = (orig[i] >> (msb ? 7 - j : j)) & 0x1;
+    }
+  }
+
+  for (size_t pass = 0; pass < 2; pass++) {
+    /* Odd lengths exercise the byte and the word steps */
+    if (pass == 0) {
+      packed->scramble(out, orig, LEN / 2 + 3);
+      packed->scramble(out + LEN / 2 + 3, orig + LEN / 2 + 3, LEN / 2 - 3);
+      unpacked->scramble_one_bit_per_byte(out_bits, orig_bits, LEN * 8);
+    }
+    else {
+      packed->reset();
+      unpacked->reset();
+      packed->descramble(out, orig, LEN / 2 + 3);
+      packed->descramble(out + LEN / 2 + 3, orig + LEN / 2 + 3, LEN / 2 - 3);
+      unpacked->descramble_one_bit_per_byte(out_bits, orig_bits, LEN * 8);
+    }
+    for (size_t i = 0; i < LEN; i++) {
+      for (size_t j = 0; j < 8; j++) {
+        BOOST_REQUIRE(((out[i] >> (msb ? 7 - j : j)) & 0x1)
+                      == out_bits[i * 8 + j]);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(whitening_ccsds_packed)
+{
+  whitening_packed_unpacked(whitening::make_ccsds(true),
+                            whitening::make_ccsds(true), true);
+  whitening_packed_unpacked(whitening::make_ccsds(false),
+                            whitening::make_ccsds(false), false);
+}
+
+BOOST_AUTO_TEST_CASE(whitening_g3ruh_packed)
+{
+  whitening_packed_unpacked(whitening::make_g3ruh(true),
+                            whitening::make_g3ruh(true), true);
+  whitening_packed_unpacked(whitening::make_g3ruh(false),
+                            whitening::make_g3ruh(false), false);
+}
+
+BOOST_AUTO_TEST_CASE(whitening_g3ruh_roundtrip)
+{
+  std::mt19937 mt(42);
+  std::uniform_int_distribution<uint8_t> uni(0, 0xFF);
+  whitening::whitening_sptr scr = whitening::make_g3ruh(true);
+  whitening::whitening_sptr descr = whitening::make_g3ruh(true);
+
+  uint8_t orig[LEN];
+  uint8_t scrambled[LEN];
+  uint8_t descrambled[LEN];
+  for (size_t i = 0; i < LEN; i++) {
+    orig[i] = uni(mt);
+  }
+  scr->scramble(scrambled, orig, LEN);
+  descr->descramble(descrambled, scrambled, LEN);
+
+  /* The output of the scrambler is delayed by the 17 stages of the LFSR */
+  for (size_t i = 17; i < LEN * 8; i++) {
+    const size_t j = i - 17;
+    BOOST_REQUIRE(((descrambled[i / 8] >> (7 - i % 8)) & 0x1)
+                  == ((orig[j / 8] >> (7 - j % 8)) & 0x1));
+  }
+}
+
 }  // namespace satnogs
 
 }  // namespace gr
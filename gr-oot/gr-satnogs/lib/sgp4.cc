@@ -0,0 +1,397 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <satnogs/sgp4.h>
+#include <cmath>
+#include <stdexcept>
+
+namespace gr {
+namespace satnogs {
+
+/* WGS-72 constants, as used for the generation of the TLEs */
+static const double mu = 398600.8;
+static const double re = 6378.135;
+static const double j2 = 0.001082616;
+static const double j3 = -0.00000253881;
+static const double j4 = -0.00000165597;
+static const double j3oj2 = j3 / j2;
+static const double twopi = 2.0 * M_PI;
+static const double x2o3 = 2.0 / 3.0;
+
+/* Earth radii per minute */
+static inline double
+xke()
+{
+  return 60.0 / std::sqrt(re * re * re / mu);
+}
+
+static double
+tle_field(const std::string &line, size_t pos, size_t len)
+{
+  try {
+    return std::stod(line.substr(pos, len));
+  }
+  catch (std::exception &e) {
+    throw std::invalid_argument("sgp4: invalid TLE field: "
+                                + line.substr(pos, len));
+  }
+}
+
+/*
+ * Parses the fields of the TLE that have an implied leading decimal point
+ * and optionally an exponent, like the BSTAR (" 66816-4")
+ */
+static double
+tle_exp_field(const std::string &line, size_t pos, bool has_exp)
+{
+  const double sign = line[pos] == '-' ? -1.0 : 1.0;
+  const double mantissa = tle_field(line, pos + 1, has_exp ? 5 : 7);
+  if (!has_exp) {
+    return sign * mantissa * 1e-7;
+  }
+  const double exp = tle_field(line, pos + 6, 2);
+  return sign * mantissa * 1e-5 * std::pow(10.0, exp);
+}
+
+/**
+ * Creates an SGP4 propagator
+ * @param line1 the first line of the TLE
+ * @param line2 the second line of the TLE
+ */
+sgp4::sgp4(const std::string &line1, const std::string &line2)
+{
+  if (line1.size() < 61 || line1[0] != '1'
+      || line2.size() < 63 || line2[0] != '2') {
+    throw std::invalid_argument("sgp4: invalid TLE");
+  }
+
+  /* TLE years 57-99 belong to the 20th century */
+  int year = static_cast<int>(tle_field(line1, 18, 2));
+  year += year < 57 ? 2000 : 1900;
+  const double doy = tle_field(line1, 20, 12);
+  const int y = year - 1;
+  const long days = 365L * (year - 1970)
+                    + (y / 4 - y / 100 + y / 400) - 477;
+  d_epoch = (days + doy - 1.0) * 86400.0;
+
+  d_bstar = tle_exp_field(line1, 53, true);
+  d_inclo = tle_field(line2, 8, 8) * M_PI / 180.0;
+  d_nodeo = tle_field(line2, 17, 8) * M_PI / 180.0;
+  d_ecco = tle_exp_field(line2, 25, false);
+  d_argpo = tle_field(line2, 34, 8) * M_PI / 180.0;
+  d_mo = tle_field(line2, 43, 8) * M_PI / 180.0;
+  d_no = tle_field(line2, 52, 11) * twopi / 1440.0;
+  if (d_ecco < 0.0 || d_ecco >= 1.0 || d_no <= 0.0) {
+    throw std::invalid_argument("sgp4: invalid orbital elements");
+  }
+  init();
+}
+
+/**
+ *
+ * @return the epoch of the TLE as UNIX time in seconds
+ */
+double
+sgp4::epoch() const
+{
+  return d_epoch;
+}
+
+void
+sgp4::init()
+{
+  /* Recover the original mean motion and semi-major axis */
+  const double eccsq = d_ecco * d_ecco;
+  const double omeosq = 1.0 - eccsq;
+  const double rteosq = std::sqrt(omeosq);
+  d_cosio = std::cos(d_inclo);
+  d_sinio = std::sin(d_inclo);
+  const double cosio2 = d_cosio * d_cosio;
+
+  const double ak = std::pow(xke() / d_no, x2o3);
+  const double d1 = 0.75 * j2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+  double del = d1 / (ak * ak);
+  const double adel = ak * (1.0 - del * del - del
+                            * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+  del = d1 / (adel * adel);
+  d_no = d_no / (1.0 + del);
+
+  if (twopi / d_no >= 225.0) {
+    throw std::invalid_argument("sgp4: deep space orbits are not supported");
+  }
+
+  d_ao = std::pow(xke() / d_no, x2o3);
+  const double po = d_ao * omeosq;
+  const double con42 = 1.0 - 5.0 * cosio2;
+  d_con41 = -con42 - cosio2 - cosio2;
+  const double posq = po * po;
+  const double rp = d_ao * (1.0 - d_ecco);
+
+  /* The atmospheric drag terms depend on the perigee height */
+  d_isimp = rp < (220.0 / re + 1.0);
+  double sfour = 78.0 / re + 1.0;
+  double qzms24 = std::pow((120.0 - 78.0) / re, 4);
+  const double perige = (rp - 1.0) * re;
+  if (perige < 156.0) {
+    sfour = perige < 98.0 ? 20.0 : perige - 78.0;
+    qzms24 = std::pow((120.0 - sfour) / re, 4);
+    sfour = sfour / re + 1.0;
+  }
+
+  const double pinvsq = 1.0 / posq;
+  const double tsi = 1.0 / (d_ao - sfour);
+  d_eta = d_ao * d_ecco * tsi;
+  const double etasq = d_eta * d_eta;
+  const double eeta = d_ecco * d_eta;
+  const double psisq = std::fabs(1.0 - etasq);
+  const double coef = qzms24 * std::pow(tsi, 4);
+  const double coef1 = coef / std::pow(psisq, 3.5);
+  const double cc2 = coef1 * d_no
+                     * (d_ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq))
+                        + 0.375 * j2 * tsi / psisq * d_con41
+                        * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+  d_cc1 = d_bstar * cc2;
+  double cc3 = 0.0;
+  if (d_ecco > 1.0e-4) {
+    cc3 = -2.0 * coef * tsi * j3oj2 * d_no * d_sinio / d_ecco;
+  }
+  d_x1mth2 = 1.0 - cosio2;
+  d_cc4 = 2.0 * d_no * coef1 * d_ao * omeosq
+          * (d_eta * (2.0 + 0.5 * etasq) + d_ecco * (0.5 + 2.0 * etasq)
+             - j2 * tsi / (d_ao * psisq)
+             * (-3.0 * d_con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta))
+                + 0.75 * d_x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq))
+                * std::cos(2.0 * d_argpo)));
+  d_cc5 = 2.0 * coef1 * d_ao * omeosq
+          * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+
+  /* Secular rates of the mean anomaly, the perigee and the node */
+  const double cosio4 = cosio2 * cosio2;
+  const double temp1 = 1.5 * j2 * pinvsq * d_no;
+  const double temp2 = 0.5 * temp1 * j2 * pinvsq;
+  const double temp3 = -0.46875 * j4 * pinvsq * pinvsq * d_no;
+  d_mdot = d_no + 0.5 * temp1 * rteosq * d_con41
+           + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+  d_argpdot = -0.5 * temp1 * con42
+              + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4)
+              + temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+  const double xhdot1 = -temp1 * d_cosio;
+  d_nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2)
+                        + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * d_cosio;
+
+  d_omgcof = d_bstar * cc3 * std::cos(d_argpo);
+  d_xmcof = 0.0;
+  if (d_ecco > 1.0e-4) {
+    d_xmcof = -x2o3 * coef * d_bstar / eeta;
+  }
+  d_nodecf = 3.5 * omeosq * xhdot1 * d_cc1;
+  d_t2cof = 1.5 * d_cc1;
+  const double cosio1 = std::fabs(d_cosio + 1.0) > 1.5e-12 ? 1.0 + d_cosio
+                        : 1.5e-12;
+  d_xlcof = -0.25 * j3oj2 * d_sinio * (3.0 + 5.0 * d_cosio) / cosio1;
+  d_aycof = -0.5 * j3oj2 * d_sinio;
+  d_delmo = std::pow(1.0 + d_eta * std::cos(d_mo), 3);
+  d_sinmao = std::sin(d_mo);
+  d_x7thm1 = 7.0 * cosio2 - 1.0;
+
+  d_d2 = d_d3 = d_d4 = 0.0;
+  d_t3cof = d_t4cof = d_t5cof = 0.0;
+  if (!d_isimp) {
+    const double cc1sq = d_cc1 * d_cc1;
+    d_d2 = 4.0 * d_ao * tsi * cc1sq;
+    const double temp = d_d2 * tsi * d_cc1 / 3.0;
+    d_d3 = (17.0 * d_ao + sfour) * temp;
+    d_d4 = 0.5 * temp * d_ao * tsi * (221.0 * d_ao + 31.0 * sfour) * d_cc1;
+    d_t3cof = d_d2 + 2.0 * cc1sq;
+    d_t4cof = 0.25 * (3.0 * d_d3 + d_cc1 * (12.0 * d_d2 + 10.0 * cc1sq));
+    d_t5cof = 0.2 * (3.0 * d_d4 + 12.0 * d_cc1 * d_d3 + 6.0 * d_d2 * d_d2
+                     + 15.0 * cc1sq * (2.0 * d_d2 + cc1sq));
+  }
+}
+
+/**
+ * Propagates the orbit
+ * @param tsince the time since the epoch of the TLE in minutes
+ * @param pos the TEME position in km
+ * @param vel the TEME velocity in km/s
+ */
+void
+sgp4::propagate(double tsince, double pos[3], double vel[3]) const
+{
+  const double t = tsince;
+
+  /* Secular gravity and atmospheric drag */
+  const double xmdf = d_mo + d_mdot * t;
+  const double argpdf = d_argpo + d_argpdot * t;
+  const double nodedf = d_nodeo + d_nodedot * t;
+  double argpm = argpdf;
+  double mm = xmdf;
+  const double t2 = t * t;
+  double nodem = nodedf + d_nodecf * t2;
+  double tempa = 1.0 - d_cc1 * t;
+  double tempe = d_bstar * d_cc4 * t;
+  double templ = d_t2cof * t2;
+
+  if (!d_isimp) {
+    const double delomg = d_omgcof * t;
+    const double delmtemp = 1.0 + d_eta * std::cos(xmdf);
+    const double delm = d_xmcof * (delmtemp * delmtemp * delmtemp - d_delmo);
+    const double temp = delomg + delm;
+    mm = xmdf + temp;
+    argpm = argpdf - temp;
+    const double t3 = t2 * t;
+    const double t4 = t3 * t;
+    tempa = tempa - d_d2 * t2 - d_d3 * t3 - d_d4 * t4;
+    tempe = tempe + d_bstar * d_cc5 * (std::sin(mm) - d_sinmao);
+    templ = templ + d_t3cof * t3 + t4 * (d_t4cof + t * d_t5cof);
+  }
+
+  const double am = std::pow(xke() / d_no, x2o3) * tempa * tempa;
+  const double nm = xke() / std::pow(am, 1.5);
+  double em = d_ecco - tempe;
+  if (em >= 1.0 || em < -0.001) {
+    throw std::runtime_error("sgp4: eccentricity out of range");
+  }
+  em = std::max(em, 1.0e-6);
+  mm = mm + d_no * templ;
+  double xlm = mm + argpm + nodem;
+  nodem = std::fmod(nodem, twopi);
+  argpm = std::fmod(argpm, twopi);
+  xlm = std::fmod(xlm, twopi);
+  mm = std::fmod(xlm - argpm - nodem, twopi);
+
+  /* Long period periodics */
+  const double axnl = em * std::cos(argpm);
+  double temp = 1.0 / (am * (1.0 - em * em));
+  const double aynl = em * std::sin(argpm) + temp * d_aycof;
+  const double xl = mm + argpm + nodem + temp * d_xlcof * axnl;
+
+  /* Solve Kepler's equation */
+  const double u = std::fmod(xl - nodem, twopi);
+  double eo1 = u;
+  double tem5 = 9999.9;
+  double sineo1 = 0.0;
+  double coseo1 = 0.0;
+  for (int ktr = 0; std::fabs(tem5) >= 1.0e-12 && ktr < 10; ktr++) {
+    sineo1 = std::sin(eo1);
+    coseo1 = std::cos(eo1);
+    tem5 = 1.0 - coseo1 * axnl - sineo1 * aynl;
+    tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+    if (std::fabs(tem5) >= 0.95) {
+      tem5 = tem5 > 0.0 ? 0.95 : -0.95;
+    }
+    eo1 = eo1 + tem5;
+  }
+
+  /* Short period periodics */
+  const double ecose = axnl * coseo1 + aynl * sineo1;
+  const double esine = axnl * sineo1 - aynl * coseo1;
+  const double el2 = axnl * axnl + aynl * aynl;
+  const double pl = am * (1.0 - el2);
+  if (pl < 0.0) {
+    throw std::runtime_error("sgp4: semi-latus rectum is negative");
+  }
+  const double rl = am * (1.0 - ecose);
+  const double rdotl = std::sqrt(am) * esine / rl;
+  const double rvdotl = std::sqrt(pl) / rl;
+  const double betal = std::sqrt(1.0 - el2);
+  temp = esine / (1.0 + betal);
+  const double sinu = am / rl * (sineo1 - aynl - axnl * temp);
+  const double cosu = am / rl * (coseo1 - axnl + aynl * temp);
+  double su = std::atan2(sinu, cosu);
+  const double sin2u = (cosu + cosu) * sinu;
+  const double cos2u = 1.0 - 2.0 * sinu * sinu;
+  temp = 1.0 / pl;
+  const double temp1 = 0.5 * j2 * temp;
+  const double temp2 = temp1 * temp;
+
+  const double mrt = rl * (1.0 - 1.5 * temp2 * betal * d_con41)
+                     + 0.5 * temp1 * d_x1mth2 * cos2u;
+  if (mrt < 1.0) {
+    throw std::runtime_error("sgp4: the satellite has decayed");
+  }
+  su = su - 0.25 * temp2 * d_x7thm1 * sin2u;
+  const double xnode = nodem + 1.5 * temp2 * d_cosio * sin2u;
+  const double xinc = d_inclo + 1.5 * temp2 * d_cosio * d_sinio * cos2u;
+  const double mvt = rdotl - nm * temp1 * d_x1mth2 * sin2u / xke();
+  const double rvdot = rvdotl + nm * temp1 * (d_x1mth2 * cos2u
+                       + 1.5 * d_con41) / xke();
+
+  /* Orientation vectors */
+  const double sinsu = std::sin(su);
+  const double cossu = std::cos(su);
+  const double snod = std::sin(xnode);
+  const double cnod = std::cos(xnode);
+  const double sini = std::sin(xinc);
+  const double cosi = std::cos(xinc);
+  const double xmx = -snod * cosi;
+  const double xmy = cnod * cosi;
+  const double ux = xmx * sinsu + cnod * cossu;
+  const double uy = xmy * sinsu + snod * cossu;
+  const double uz = sini * sinsu;
+  const double vx = xmx * cossu - cnod * sinsu;
+  const double vy = xmy * cossu - snod * sinsu;
+  const double vz = sini * cossu;
+
+  const double vkmpersec = re * xke() / 60.0;
+  pos[0] = mrt * ux * re;
+  pos[1] = mrt * uy * re;
+  pos[2] = mrt * uz * re;
+  vel[0] = (mvt * ux + rvdot * vx) * vkmpersec;
+  vel[1] = (mvt * uy + rvdot * vy) * vkmpersec;
+  vel[2] = (mvt * uz + rvdot * vz) * vkmpersec;
+}
+
+/**
+ * Propagates the orbit at an absolute time
+ * @param t the UNIX time in seconds
+ * @param pos the TEME position in km
+ * @param vel the TEME velocity in km/s
+ */
+void
+sgp4::position(double t, double pos[3], double vel[3]) const
+{
+  propagate((t - d_epoch) / 60.0, pos, vel);
+}
+
+/**
+ * Computes the Greenwich Mean Sidereal Time (IAU-82), which rotates the
+ * TEME frame to the Earth fixed frame
+ * @param t the UNIX time in seconds. The difference between UTC and UT1 is
+ * ignored
+ * @return the GMST in radians, in the range [0, 2pi)
+ */
+double
+sgp4::gmst(double t)
+{
+  const double tut1 = (t / 86400.0 + 2440587.5 - 2451545.0) / 36525.0;
+  double g = -6.2e-6 * tut1 * tut1 * tut1 + 0.093104 * tut1 * tut1
+             + (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841;
+  g = std::fmod(g * M_PI / 180.0 / 240.0, twopi);
+  return g < 0.0 ? g + twopi : g;
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
@@ -0,0 +1,189 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "sgp4_doppler_msg_source_impl.h"
+#include <satnogs/log.h>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace gr {
+namespace satnogs {
+
+/* WGS-84 ellipsoid */
+static const double wgs84_a = 6378.137;
+static const double wgs84_f = 1.0 / 298.257223563;
+/* Earth rotation rate in rad/s */
+static const double earth_rate = 7.292115e-5;
+/* Speed of light in km/s */
+static const double light_speed = 299792.458;
+
+/*
+ * The predictions are published a few intervals ahead of the samples being
+ * processed. doppler_fit needs four predictions to start and then
+ * interpolates between them, instead of extrapolating. The correction block
+ * reads the same buffer, so it cannot get ahead of this block by more than
+ * the buffer size
+ */
+static const size_t lead_intervals = 3;
+
+sgp4_doppler_msg_source::sptr
+sgp4_doppler_msg_source::make(const std::string &tle1,
+                              const std::string &tle2,
+                              double lat, double lon, double alt,
+                              double target_freq, double sampling_rate,
+                              double start_time, size_t interval_ms)
+{
+  return gnuradio::get_initial_sptr(
+           new sgp4_doppler_msg_source_impl(tle1, tle2, lat, lon, alt,
+               target_freq, sampling_rate,
+               start_time, interval_ms));
+}
+
+/*
+ * The private constructor
+ */
+sgp4_doppler_msg_source_impl::sgp4_doppler_msg_source_impl(
+  const std::string &tle1, const std::string &tle2,
+  double lat, double lon, double alt, double target_freq,
+  double sampling_rate, double start_time, size_t interval_ms) :
+  gr::sync_block("sgp4_doppler_msg_source",
+                 gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                 gr::io_signature::make(0, 0, 0)),
+  d_sgp4(tle1, tle2),
+  d_target_freq(target_freq),
+  d_samp_rate(sampling_rate),
+  d_start_time(start_time),
+  d_interval_ms(interval_ms),
+  d_port(pmt::mp("freq")),
+  d_t0(start_time),
+  d_next(0),
+  d_failed(false)
+{
+  if (sampling_rate <= 0.0) {
+    throw std::invalid_argument(
+      "sgp4_doppler_msg_source: invalid sampling rate");
+  }
+  if (interval_ms == 0) {
+    throw std::invalid_argument("sgp4_doppler_msg_source: invalid interval");
+  }
+
+  /* Geodetic to Earth fixed coordinates */
+  const double phi = lat * M_PI / 180.0;
+  const double lambda = lon * M_PI / 180.0;
+  const double h = alt / 1e3;
+  const double e2 = wgs84_f * (2.0 - wgs84_f);
+  const double n = wgs84_a / std::sqrt(1.0 - e2 * std::sin(phi) * std::sin(phi));
+  d_station[0] = (n + h) * std::cos(phi) * std::cos(lambda);
+  d_station[1] = (n + h) * std::cos(phi) * std::sin(lambda);
+  d_station[2] = (n * (1.0 - e2) + h) * std::sin(phi);
+
+  message_port_register_out(d_port);
+}
+
+sgp4_doppler_msg_source_impl::~sgp4_doppler_msg_source_impl()
+{
+}
+
+/**
+ * Computes the frequency that the ground station receives
+ * @param t the UNIX time in seconds
+ * @return the Doppler shifted frequency in Hz
+ */
+double
+sgp4_doppler_msg_source_impl::frequency(double t) const
+{
+  double pos[3];
+  double vel[3];
+  d_sgp4.position(t, pos, vel);
+
+  /* Rotate the station to the TEME frame, where the satellite state is */
+  const double g = sgp4::gmst(t);
+  const double st[3] = {
+    std::cos(g) * d_station[0] - std::sin(g) * d_station[1],
+    std::sin(g) * d_station[0] + std::cos(g) * d_station[1],
+    d_station[2]
+  };
+  const double stv[3] = {-earth_rate * st[1], earth_rate * st[0], 0.0};
+
+  double range = 0.0;
+  double range_rate = 0.0;
+  for (size_t i = 0; i < 3; i++) {
+    range += (pos[i] - st[i]) * (pos[i] - st[i]);
+    range_rate += (pos[i] - st[i]) * (vel[i] - stv[i]);
+  }
+  range_rate /= std::sqrt(range);
+  return d_target_freq * (1.0 - range_rate / light_speed);
+}
+
+bool
+sgp4_doppler_msg_source_impl::start()
+{
+  if (d_start_time <= 0.0) {
+    d_t0 = std::chrono::duration<double>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+  d_next = 0;
+  d_failed = false;
+  return true;
+}
+
+/*
+ * Publishes the predictions up to a few intervals after the last sample of
+ * this call. Each prediction is computed for the time of the sample it
+ * refers to, so the rate that the stream is processed at does not matter
+ */
+int
+sgp4_doppler_msg_source_impl::work(int noutput_items,
+                                   gr_vector_const_void_star &input_items,
+                                   gr_vector_void_star &output_items)
+{
+  if (d_failed) {
+    return noutput_items;
+  }
+
+  const double interval = d_interval_ms / 1e3 * d_samp_rate;
+  const double last = nitems_read(0) + noutput_items;
+  while (d_next * interval <= last + lead_intervals * interval) {
+    const uint64_t idx = std::llround(d_next * interval);
+    double freq;
+    try {
+      freq = frequency(d_t0 + idx / d_samp_rate);
+    }
+    catch (std::runtime_error &e) {
+      LOG_ERROR("%s", e.what());
+      d_failed = true;
+      return noutput_items;
+    }
+    message_port_pub(d_port, pmt::cons(pmt::from_uint64(idx),
+                                       pmt::from_double(freq)));
+    d_next++;
+  }
+  return noutput_items;
+}
+
+} /* namespace satnogs */
+} /* namespace gr */
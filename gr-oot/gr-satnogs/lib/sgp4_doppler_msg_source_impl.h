@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * gr-satnogs: SatNOGS GNU Radio Out-Of-Tree Module
+ *
+ *  Copyright (C) 2021, Libre Space Foundation <http://libre.space>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_SATNOGS_SGP4_DOPPLER_MSG_SOURCE_IMPL_H
+#define INCLUDED_SATNOGS_SGP4_DOPPLER_MSG_SOURCE_IMPL_H
+
+#include <satnogs/sgp4_doppler_msg_source.h>
+#include <satnogs/sgp4.h>
+
+namespace gr {
+namespace satnogs {
+
+class sgp4_doppler_msg_source_impl : public sgp4_doppler_msg_source {
+private:
+  const sgp4 d_sgp4;
+  const double d_target_freq;
+  const double d_samp_rate;
+  const double d_start_time;
+  const size_t d_interval_ms;
+  const pmt::pmt_t d_port;
+  /* Station position in the Earth fixed frame, in km */
+  double d_station[3];
+  double d_t0;
+  /* Index of the next prediction */
+  uint64_t d_next;
+  bool d_failed;
+
+public:
+  sgp4_doppler_msg_source_impl(const std::string &tle1,
+                               const std::string &tle2,
+                               double lat, double lon, double alt,
+                               double target_freq, double sampling_rate,
+                               double start_time, size_t interval_ms);
+  ~sgp4_doppler_msg_source_impl();
+
+  double
+  frequency(double t) const;
+
+  bool
+  start();
+
+  int
+  work(int noutput_items, gr_vector_const_void_star &input_items,
+       gr_vector_void_star &output_items);
+};
+
+} // namespace satnogs
+} // namespace gr
+
+#endif /* INCLUDED_SATNOGS_SGP4_DOPPLER_MSG_SOURCE_IMPL_H */
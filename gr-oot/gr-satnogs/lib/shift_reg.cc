@@ -24,17 +24,25 @@
 
 #include <gnuradio/io_signature.h>
 #include <satnogs/shift_reg.h>
+#include <algorithm>
 
 namespace gr {
 namespace satnogs {
 
+static uint64_t
+last_word_mask(size_t len)
+{
+  return (len % 64) ? (1ULL << (len % 64)) - 1 : ~0ULL;
+}
+
 /**
- * Creates a new shift register
- * @param len the number of the memory stages
+ * Creates a new shift register with all bits cleared
+ * @param len the number of bits of the register
  */
 shift_reg::shift_reg(size_t len)
   : d_len(len),
-    d_reg(len, 0)
+    d_last_mask(last_word_mask(len)),
+    d_reg(len / 64 + (len % 64 ? 1 : 0), 0)
 {
 }
 
@@ -48,9 +56,7 @@ shift_reg::~shift_reg()
 void
 shift_reg::reset()
 {
-  for (size_t i = 0; i < d_len; i++) {
-    d_reg[i] = 0;
-  }
+  std::fill(d_reg.begin(), d_reg.end(), 0);
 }
 
 /**
@@ -59,9 +65,11 @@ shift_reg::reset()
 void
 shift_reg::set()
 {
-  for (size_t i = 0; i < d_len; i++) {
-    d_reg[i] = 1;
+  if (d_reg.empty()) {
+    return;
   }
+  std::fill(d_reg.begin(), d_reg.end(), ~0ULL);
+  d_reg.back() = d_last_mask;
 }
 
 /**
@@ -86,74 +94,120 @@ shift_reg::size() const
 
 /**
  *
- * @return the number of 1 bits
+ * @return the number of bits set
  */
 size_t
-shift_reg::count()
+shift_reg::count() const
 {
   size_t cnt = 0;
-  for (bool i : d_reg) {
-    cnt += i;
+  for (uint64_t w : d_reg) {
+    cnt += __builtin_popcountll(w);
   }
   return cnt;
 }
 
-shift_reg
-shift_reg::operator | (const shift_reg &rhs)
+/**
+ * Computes the number of different bits between two registers of the same
+ * length, without creating any intermediate register
+ * @param rhs the other register
+ * @return the Hamming distance
+ */
+size_t
+shift_reg::hamming_distance(const shift_reg &rhs) const
 {
-  shift_reg ret(d_len);
-  for (size_t i = 0; i < d_len; i++) {
-    ret[i] = d_reg[i] | rhs[i];
+  size_t cnt = 0;
+  for (size_t i = 0; i < d_reg.size(); i++) {
+    cnt += __builtin_popcountll(d_reg[i] ^ rhs.d_reg[i]);
   }
+  return cnt;
+}
+
+shift_reg
+shift_reg::operator | (const shift_reg &rhs) const
+{
+  shift_reg ret(*this);
+  ret |= rhs;
   return ret;
 }
 
 shift_reg
-shift_reg::operator & (const shift_reg &rhs)
+shift_reg::operator & (const shift_reg &rhs) const
 {
-  shift_reg ret(d_len);
-  for (size_t i = 0; i < d_len; i++) {
-    ret[i] = d_reg[i] & rhs[i];
-  }
+  shift_reg ret(*this);
+  ret &= rhs;
   return ret;
 }
 
 shift_reg
-shift_reg::operator ^ (const shift_reg &rhs)
+shift_reg::operator ^ (const shift_reg &rhs) const
 {
-  shift_reg ret(d_len);
-  for (size_t i = 0; i < d_len; i++) {
-    ret[i] = d_reg[i] ^ rhs[i];
-  }
+  shift_reg ret(*this);
+  ret ^= rhs;
   return ret;
 }
 
 shift_reg &
-shift_reg::operator >>= (bool bit)
+shift_reg::operator |= (const shift_reg &rhs)
 {
-  push_front(bit);
+  for (size_t i = 0; i < d_reg.size(); i++) {
+    d_reg[i] |= rhs.d_reg[i];
+  }
   return *this;
 }
 
-bool &
-shift_reg::operator [](size_t pos)
+shift_reg &
+shift_reg::operator &= (const shift_reg &rhs)
 {
-  return d_reg[pos];
+  for (size_t i = 0; i < d_reg.size(); i++) {
+    d_reg[i] &= rhs.d_reg[i];
+  }
+  return *this;
 }
 
-bool
-shift_reg::operator[](size_t pos) const
+shift_reg &
+shift_reg::operator ^= (const shift_reg &rhs)
 {
-  return d_reg[pos];
+  for (size_t i = 0; i < d_reg.size(); i++) {
+    d_reg[i] ^= rhs.d_reg[i];
+  }
+  return *this;
 }
 
 shift_reg &
-shift_reg::operator <<= (bool bit)
+shift_reg::operator >>= (bool bit)
 {
-  push_back(bit);
+  push_front(bit);
   return *this;
 }
 
+bool
+shift_reg::operator[](size_t pos) const
+{
+  const size_t b = d_len - 1 - pos;
+  return (d_reg[b / 64] >> (b % 64)) & 0x1;
+}
+
+void
+shift_reg::set(size_t pos, bool bit)
+{
+  const size_t b = d_len - 1 - pos;
+  const uint64_t m = 1ULL << (b % 64);
+  d_reg[b / 64] = (d_reg[b / 64] & ~m) | (bit ? m : 0);
+}
+
+void
+shift_reg::shift_left(bool bit)
+{
+  if (d_reg.empty()) {
+    return;
+  }
+  for (size_t i = d_reg.size() - 1; i > 0; i--) {
+    d_reg[i] = (d_reg[i] << 1) | (d_reg[i - 1] >> 63);
+  }
+  d_reg[0] = (d_reg[0] << 1) | bit;
+  d_reg.back() &= d_last_mask;
+}
+
 /**
  * Push at the front a new value and pops from the back
  * @param bit the new value
@@ -161,8 +215,14 @@ shift_reg::operator <<= (bool bit)
 void
 shift_reg::push_front(bool bit)
 {
-  d_reg.pop_back();
-  d_reg.push_front(bit);
+  if (d_reg.empty()) {
+    return;
+  }
+  for (size_t i = 0; i + 1 < d_reg.size(); i++) {
+    d_reg[i] = (d_reg[i] >> 1) | (d_reg[i + 1] << 63);
+  }
+  d_reg.back() >>= 1;
+  set(0, bit);
 }
 
 /**
@@ -172,8 +232,7 @@ shift_reg::push_front(bool bit)
 void
 shift_reg::push_back(bool bit)
 {
-  d_reg.pop_front();
-  d_reg.push_back(bit);
+  *this <<= bit;
 }
 
 /**
@@ -181,9 +240,9 @@ shift_reg::push_back(bool bit)
  * @return the first element in the queue from right to left
  */
 bool
-shift_reg::front()
+shift_reg::front() const
 {
-  return d_reg.front();
+  return (*this)[0];
 }
 
 /**
@@ -191,20 +250,19 @@ shift_reg::front()
  * @return the last element in the queue from right to left
  */
 bool
-shift_reg::back()
+shift_reg::back() const
 {
-  return d_reg.back();
+  return (*this)[d_len - 1];
 }
 
 std::ostream &
 operator<<(std::ostream &os, const shift_reg &reg)
 {
-  for (bool bit : reg.d_reg) {
-    os << " " << bit;
+  for (size_t i = 0; i < reg.len(); i++) {
+    os << " " << reg[i];
   }
   return os;
 }
 
 } /* namespace satnogs */
 } /* namespace gr */
-
@@ -26,6 +26,7 @@
 #include <string>
 #include <gnuradio/io_signature.h>
 #include <satnogs/base64.h>
+#include <satnogs/frame_metadata.h>
 #include "sigmf_metadata_impl.h"
 
 namespace gr {
@@ -54,18 +55,16 @@ sigmf_metadata_impl::transform(pmt::pmt_t &m)
        ::satnogs::DescrT> ();
   auto new_capture = sigmf::Capture<core::DescrT> ();
 
-  pmt::pmt_t v;
+  const frame_metadata f(m);
 
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_PHASE_DELAY)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
+  if (f.has(DECODER_PHASE_DELAY)) {
     d_sigmf.global.access<::satnogs::GlobalT> ().decoder_phase =
-      pmt::to_uint64(v);
+      f.phase_delay;
   }
 
-  v = pmt::dict_ref(m, pmt::mp(value(DECODER_RESAMPLING_RATIO)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
+  if (f.has(DECODER_RESAMPLING_RATIO)) {
     d_sigmf.global.access<::satnogs::GlobalT> ().decoder_resampling_ratio =
-      pmt::to_float(v);
+      f.resampling_ratio;
   }
 
   /*
@@ -79,21 +78,16 @@ sigmf_metadata_impl::transform(pmt::pmt_t &m)
    * a capture segment and we also search for sample_start, datetime and
    * global_index in the received pmt.
    */
-  v = pmt::dict_ref(m, pmt::mp(value(CENTER_FREQ)), pmt::PMT_NIL);
   // The key frequency of capture segment found inside received pmt.
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
-    new_capture.access<core::CaptureT> ().frequency =
-      pmt::to_double(v);
+  if (f.has(CENTER_FREQ)) {
+    new_capture.access<core::CaptureT> ().frequency = f.center_freq;
     // Now search for datetime and sample_start
-    v = pmt::dict_ref(m, pmt::mp(value(SAMPLE_START)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
-      new_capture.access<core::CaptureT> ().sample_start =
-        pmt::to_uint64(v);
+    if (f.has(SAMPLE_START)) {
+      new_capture.access<core::CaptureT> ().sample_start = f.sample_start;
     }
-    v = pmt::dict_ref(m, pmt::mp(value(TIME)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(TIME)) {
       new_capture.access<core::CaptureT> ().datetime =
-        pmt::symbol_to_string(v);
+        pmt::symbol_to_string(f.time);
     }
     d_sigmf.captures.emplace_back(new_capture);
   }
@@ -105,95 +99,79 @@ sigmf_metadata_impl::transform(pmt::pmt_t &m)
    * pmt, then we are sure that we need to append a new annotation segment. Then
    * we try to find every other annotation key inside the pmt.
    */
-  v = pmt::dict_ref(m, pmt::mp(value(SAMPLE_CNT)), pmt::PMT_NIL);
-  if (!pmt::equal(v, pmt::PMT_NIL)) {
+  if (f.has(SAMPLE_CNT)) {
     // The sample_count key of the annotation segment found inside pmt
-    new_annotation.access<core::AnnotationT> ().sample_count =
-      pmt::to_uint64(v);
+    new_annotation.access<core::AnnotationT> ().sample_count = f.sample_cnt;
     // Search for every other possible annotation key of different namespaces
-    v = pmt::dict_ref(m, pmt::mp(value(PDU)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
-      uint8_t *b = (uint8_t *) pmt::blob_data(v);
-      size_t len = pmt::blob_length(v);
+    if (f.has(PDU)) {
+      uint8_t *b = (uint8_t *) pmt::blob_data(f.pdu);
+      size_t len = pmt::blob_length(f.pdu);
       new_annotation.access<::satnogs::AnnotationT> ().pdu =
         base64_encode(b, len);
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(TIME)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(TIME)) {
       new_annotation.access<::satnogs::AnnotationT> ().time =
-        pmt::symbol_to_string(v);
+        pmt::symbol_to_string(f.time);
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(DECODER_CRC_VALID)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(DECODER_CRC_VALID)) {
       new_annotation.access<::satnogs::AnnotationT> ().decoder_crc_valid =
-        pmt::to_bool(v);
+        f.crc_valid;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(SAMPLE_START)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(SAMPLE_START)) {
       new_annotation.access<core::AnnotationT> ().sample_start =
-        pmt::to_uint64(v);
+        f.sample_start;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(DECODER_SYMBOL_ERASURES)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(DECODER_SYMBOL_ERASURES)) {
       new_annotation.access<::satnogs::AnnotationT> ().decoder_symbol_erasures =
-        pmt::to_uint64(v);
+        f.symbol_erasures;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(DECODER_CORRECTED_BITS)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(DECODER_CORRECTED_BITS)) {
       new_annotation.access<::satnogs::AnnotationT> ().decoder_corrected_bits =
-        pmt::to_uint64(v);
+        f.corrected_bits;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(FREQ_OFFSET)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(FREQ_OFFSET)) {
       new_annotation.access<::satnogs::AnnotationT> ().frequency_offset =
-        pmt::to_double(v);
+        f.freq_offset;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(SNR)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
-      new_annotation.access<::satnogs::AnnotationT> ().snr = pmt::to_float(v);
+    if (f.has(SNR)) {
+      new_annotation.access<::satnogs::AnnotationT> ().snr = f.snr;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(SYMBOL_TIMING_ERROR)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(SYMBOL_TIMING_ERROR)) {
       new_annotation.access<::satnogs::AnnotationT> ().symbol_timing_error =
-        pmt::to_double(v);
+        f.symbol_timing_error;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(DECODER_NAME)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(DECODER_NAME)) {
       new_annotation.access<::satnogs::AnnotationT> ().decoder_name =
-        pmt::symbol_to_string(v);
+        pmt::symbol_to_string(f.decoder_name);
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(DECODER_VERSION)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(DECODER_VERSION)) {
       new_annotation.access<::satnogs::AnnotationT> ().decoder_version =
-        pmt::symbol_to_string(v);
+        pmt::symbol_to_string(f.decoder_version);
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(ANTENNA_AZIMUTH)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(ANTENNA_AZIMUTH)) {
       new_annotation.access<antenna::AnnotationT> ().azimuth_angle =
-        pmt::to_double(v);
+        f.antenna_azimuth;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(ANTENNA_ELEVATION)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(ANTENNA_ELEVATION)) {
       new_annotation.access<antenna::AnnotationT> ().elevation_angle =
-        pmt::to_double(v);
+        f.antenna_elevation;
     }
 
-    v = pmt::dict_ref(m, pmt::mp(value(ANTENNA_POLARIZATION)), pmt::PMT_NIL);
-    if (!pmt::equal(v, pmt::PMT_NIL)) {
+    if (f.has(ANTENNA_POLARIZATION)) {
       new_annotation.access<antenna::AnnotationT> ().polarization =
-        pmt::symbol_to_string(v);
+        pmt::symbol_to_string(f.antenna_polarization);
     }
 
     d_sigmf.annotations.emplace_back(new_annotation);
@@ -25,58 +25,149 @@
 #include <gnuradio/io_signature.h>
 #include "udp_msg_sink_impl.h"
 #include <satnogs/log.h>
+#include <satnogs/metadata.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 
 namespace gr {
 namespace satnogs {
 
+/* Maximum number of queued messages sent with a single sendmmsg() call */
+static const size_t max_batch = 64;
+
 udp_msg_sink::sptr
-udp_msg_sink::make(const std::string &addr, uint16_t port, size_t mtu)
+udp_msg_sink::make(const std::string &addr, uint16_t port, size_t mtu,
+                   bool batch, double latency_ms, size_t queue_size)
 {
   return gnuradio::get_initial_sptr
-         (new udp_msg_sink_impl(addr, port, mtu));
+         (new udp_msg_sink_impl(addr, port, mtu, batch, latency_ms,
+                                queue_size));
 }
 
-/*
- * The private constructor
- */
 udp_msg_sink_impl::udp_msg_sink_impl(const std::string &addr,
-                                     uint16_t port, size_t mtu) :
+                                     uint16_t port, size_t mtu,
+                                     bool batch, double latency_ms,
+                                     size_t queue_size) :
   gr::block("udp_msg_sink",
             gr::io_signature::make(0, 0, 0),
             gr::io_signature::make(0, 0, 0)),
   d_iface_addr(addr),
   d_udp_port(port),
-  d_mtu(mtu)
+  d_mtu(mtu),
+  d_batch(batch),
+  d_latency(latency_ms),
+  d_queue_size(queue_size),
+  d_head(0),
+  d_tail(0),
+  d_running(false),
+  d_dropped(0),
+  d_oversized(0),
+  d_send_errors(0)
 {
+  if (latency_ms < 0.0) {
+    throw std::invalid_argument("udp_msg_sink: latency should be positive");
+  }
+  if (batch && queue_size == 0) {
+    throw std::invalid_argument("udp_msg_sink: invalid queue size");
+  }
+
   message_port_register_in(pmt::mp("in"));
   set_msg_handler(pmt::mp("in"),
   [this](pmt::pmt_t msg) {
     this->msg_handler(msg);
   });
 
+  parse_destinations(addr);
+
   /* Open the socket */
   if ((d_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
     perror("opening UDP socket");
     throw std::runtime_error("Could not open UDP socket");
   }
 
-  memset(&d_sin, 0, sizeof(struct sockaddr_in));
-  d_sin.sin_family = AF_INET;
-  d_sin.sin_port = htons(d_udp_port);
+  if (d_batch) {
+    d_slots.resize(d_queue_size * d_mtu);
+    d_slot_len.resize(d_queue_size);
+    d_iov.resize(max_batch);
+    d_msgs.resize(max_batch * d_dest.size());
+  }
+}
+
+void
+udp_msg_sink_impl::parse_destinations(const std::string &addr)
+{
+  size_t start = 0;
+  while (start <= addr.size()) {
+    size_t end = addr.find(',', start);
+    if (end == std::string::npos) {
+      end = addr.size();
+    }
+    std::string dest = addr.substr(start, end - start);
+    dest.erase(0, dest.find_first_not_of(" \t"));
+    dest.erase(dest.find_last_not_of(" \t") + 1);
+    start = end + 1;
+
+    uint16_t port = d_udp_port;
+    const size_t colon = dest.find(':');
+    if (colon != std::string::npos) {
+      const std::string p = dest.substr(colon + 1);
+      char *endp;
+      errno = 0;
+      const unsigned long v = std::strtoul(p.c_str(), &endp, 10);
+      if (p.empty() || !std::isdigit(static_cast<unsigned char>(p[0]))
+          || *endp != '\0' || errno || v < 1 || v > 65535) {
+        LOG_ERROR("Wrong UDP port %s", p.c_str());
+        throw std::runtime_error("Wrong UDP port");
+      }
+      port = v;
+      dest.erase(colon);
+    }
 
-  if (inet_aton(d_iface_addr.c_str(), &(d_sin.sin_addr)) == 0) {
-    LOG_ERROR("Wrong IP address");
-    close(d_sock);
-    throw std::runtime_error("Wrong IP address");
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(struct sockaddr_in));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    if (inet_aton(dest.c_str(), &(sin.sin_addr)) == 0) {
+      LOG_ERROR("Wrong IP address %s", dest.c_str());
+      throw std::runtime_error("Wrong IP address");
+    }
+    d_dest.push_back(sin);
   }
 }
 
+bool
+udp_msg_sink_impl::start()
+{
+  if (d_batch) {
+    d_running = true;
+    d_sender = std::thread(&udp_msg_sink_impl::sender, this);
+  }
+  return true;
+}
+
+bool
+udp_msg_sink_impl::stop()
+{
+  if (d_sender.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(d_mtx);
+      d_running = false;
+    }
+    d_cond.notify_one();
+    d_sender.join();
+  }
+  return true;
+}
+
 void udp_msg_sink_impl::msg_handler(pmt::pmt_t msg)
 {
   size_t len;
   const void *buf;
   if (pmt::is_dict(msg)) {
-    pmt::pmt_t pdu_v = pmt::dict_ref(msg, pmt::mp("pdu"), pmt::PMT_NIL);
+    pmt::pmt_t pdu_v = pmt::dict_ref(msg, metadata::key(metadata::PDU),
+                                     pmt::PMT_NIL);
     len = pmt::blob_length(pdu_v);
     buf = pmt::blob_data(pdu_v);
   }
@@ -84,16 +175,135 @@ void udp_msg_sink_impl::msg_handler(pmt::pmt_t msg)
     buf = pmt::blob_data(msg);
     len = pmt::blob_length(msg);
   }
-  if (len < d_mtu) {
-    sendto(d_sock, buf, len, 0, (sockaddr *) &d_sin, sizeof(sockaddr_in));
+  if (len > d_mtu) {
+    d_oversized++;
+    return;
+  }
+
+  if (!d_batch) {
+    for (const struct sockaddr_in &sin : d_dest) {
+      if (sendto(d_sock, buf, len, 0, (sockaddr *) &sin,
+                 sizeof(sockaddr_in)) < 0) {
+        d_send_errors++;
+      }
+    }
+    return;
+  }
+
+  const size_t head = d_head.load(std::memory_order_relaxed);
+  if (head - d_tail.load(std::memory_order_acquire) == d_queue_size) {
+    d_dropped++;
+    return;
+  }
+  const size_t slot = head % d_queue_size;
+  memcpy(&d_slots[slot * d_mtu], buf, len);
+  d_slot_len[slot] = len;
+  d_head.store(head + 1);
+
+  /*
+   * Wake up the sender if the queue was empty or if there are enough
+   * messages for a full batch. Taking the lock only waits for the sender
+   * to check the queue, never for the socket
+   */
+  const size_t pending = head + 1 - d_tail.load();
+  if (pending == 1 || pending == max_batch) {
+    {
+      std::lock_guard<std::mutex> lock(d_mtx);
+    }
+    d_cond.notify_one();
   }
 }
 
 /*
- * Our virtual destructor.
+ * Sends n queued messages starting from the tail, to all destinations
  */
+size_t
+udp_msg_sink_impl::send_batch(size_t tail, size_t n)
+{
+  const size_t ndest = d_dest.size();
+  for (size_t i = 0; i < n; i++) {
+    const size_t slot = (tail + i) % d_queue_size;
+    d_iov[i].iov_base = &d_slots[slot * d_mtu];
+    d_iov[i].iov_len = d_slot_len[slot];
+    for (size_t j = 0; j < ndest; j++) {
+      struct msghdr &h = d_msgs[i * ndest + j].msg_hdr;
+      memset(&h, 0, sizeof(struct msghdr));
+      h.msg_name = &d_dest[j];
+      h.msg_namelen = sizeof(struct sockaddr_in);
+      h.msg_iov = &d_iov[i];
+      h.msg_iovlen = 1;
+    }
+  }
+
+  const size_t total = n * ndest;
+  size_t sent = 0;
+  while (sent < total) {
+    int ret = sendmmsg(d_sock, &d_msgs[sent], total - sent, 0);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      /* Skip the datagram that failed */
+      d_send_errors++;
+      sent++;
+    }
+    else {
+      sent += ret;
+    }
+  }
+  return n;
+}
+
+void
+udp_msg_sink_impl::sender()
+{
+  size_t tail = d_tail.load(std::memory_order_relaxed);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(d_mtx);
+      d_cond.wait(lock, [&] {
+        return d_head.load() != tail || !d_running;
+      });
+      /* Coalesce the messages that arrive within the latency window */
+      if (d_running && d_head.load() - tail < max_batch) {
+        d_cond.wait_for(lock, d_latency, [&] {
+          return d_head.load() - tail >= max_batch || !d_running;
+        });
+      }
+    }
+
+    const size_t head = d_head.load(std::memory_order_acquire);
+    if (head == tail) {
+      return;
+    }
+    while (tail != head) {
+      tail += send_batch(tail, std::min(head - tail, max_batch));
+      d_tail.store(tail);
+    }
+  }
+}
+
+uint64_t
+udp_msg_sink_impl::dropped() const
+{
+  return d_dropped;
+}
+
+uint64_t
+udp_msg_sink_impl::oversized() const
+{
+  return d_oversized;
+}
+
+uint64_t
+udp_msg_sink_impl::send_errors() const
+{
+  return d_send_errors;
+}
+
 udp_msg_sink_impl::~udp_msg_sink_impl()
 {
+  stop();
   close(d_sock);
 }
 
@@ -30,6 +30,12 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace gr {
 namespace satnogs {
@@ -39,14 +45,63 @@ private:
   const std::string d_iface_addr;
   const uint16_t d_udp_port;
   const size_t d_mtu;
+  const bool d_batch;
+  const std::chrono::duration<double, std::milli> d_latency;
   int d_sock;
-  struct sockaddr_in d_sin;
+  std::vector<struct sockaddr_in> d_dest;
+
+  /*
+   * Single producer, single consumer ring of d_mtu sized slots. The
+   * message handler is the producer and the sender thread the consumer
+   */
+  const size_t d_queue_size;
+  std::vector<uint8_t> d_slots;
+  std::vector<size_t> d_slot_len;
+  std::atomic<size_t> d_head;
+  std::atomic<size_t> d_tail;
+
+  std::thread d_sender;
+  std::atomic<bool> d_running;
+  std::mutex d_mtx;
+  std::condition_variable d_cond;
+
+  std::atomic<uint64_t> d_dropped;
+  std::atomic<uint64_t> d_oversized;
+  std::atomic<uint64_t> d_send_errors;
+
+  std::vector<struct mmsghdr> d_msgs;
+  std::vector<struct iovec> d_iov;
 
   void msg_handler(pmt::pmt_t msg);
 
+  void
+  parse_destinations(const std::string &addr);
+
+  void
+  sender();
+
+  size_t
+  send_batch(size_t tail, size_t n);
+
 public:
-  udp_msg_sink_impl(const std::string &addr, uint16_t port, size_t mtu);
+  udp_msg_sink_impl(const std::string &addr, uint16_t port, size_t mtu,
+                    bool batch, double latency_ms, size_t queue_size);
   ~udp_msg_sink_impl();
+
+  bool
+  start();
+
+  bool
+  stop();
+
+  uint64_t
+  dropped() const;
+
+  uint64_t
+  oversized() const;
+
+  uint64_t
+  send_errors() const;
 };
 
 } // namespace satnogs
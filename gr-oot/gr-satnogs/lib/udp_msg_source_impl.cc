@@ -32,127 +32,257 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
 
 namespace gr {
 namespace satnogs {
 
+/* Maximum number of datagrams received with a single recvmmsg() call */
+static const size_t max_batch = 32;
+
+/* Poll timeout of the streaming mode, so the scheduler can stop the block */
+static const int stream_timeout_ms = 100;
+
 udp_msg_source::sptr
 udp_msg_source::make(const std::string &addr, uint16_t port, size_t mtu,
-                     size_t type)
+                     size_t type, bool stream)
 {
   return gnuradio::get_initial_sptr(
-           new udp_msg_source_impl(addr, port, mtu, type));
+           new udp_msg_source_impl(addr, port, mtu, type, stream));
 }
 
-/*
- * The private constructor
- */
 udp_msg_source_impl::udp_msg_source_impl(const std::string &addr,
     uint16_t port, size_t mtu,
-    size_t type) :
+    size_t type, bool stream) :
   gr::block("udp_msg_source", gr::io_signature::make(0, 0, 0),
-            gr::io_signature::make(0, 0, 0)),
+            gr::io_signature::make(stream ? 1 : 0, stream ? 1 : 0,
+                                   sizeof(uint8_t))),
   d_iface_addr(addr),
   d_udp_port(port),
   d_mtu(mtu),
   d_type(type),
-  d_running(true)
-{
-  message_port_register_out(pmt::mp("msg"));
-  boost::shared_ptr<boost::thread> (
-    new boost::thread(
-      boost::bind(&udp_msg_source_impl::udp_msg_accepter, this)));
-}
-
-void
-udp_msg_source_impl::udp_msg_accepter()
+  d_stream(stream),
+  d_port(pmt::mp("msg")),
+  d_pool(max_batch * mtu),
+  d_iov(max_batch),
+  d_msgs(max_batch),
+  d_pending_cnt(0),
+  d_pending_idx(0),
+  d_pending_off(0)
 {
-  int sock;
-  struct sockaddr_in sin;
-  struct sockaddr client_addr;
-  socklen_t client_addr_len;
-  ssize_t ret;
-  uint8_t *buf;
-  uint32_t bytes_num;
-  uint32_t uint_val;
-  uint32_t int_val;
-
-  if ((sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
-    perror("opening UDP socket");
-    exit(EXIT_FAILURE);
+  if (d_type > 2) {
+    throw std::invalid_argument("udp_msg_source: Unsupported message type");
+  }
+  if (d_mtu == 0) {
+    throw std::invalid_argument("udp_msg_source: Invalid MTU");
   }
+  message_port_register_out(d_port);
 
-  memset(&client_addr, 0, sizeof(struct sockaddr));
+  struct sockaddr_in sin;
   memset(&sin, 0, sizeof(struct sockaddr_in));
   sin.sin_family = AF_INET;
   sin.sin_port = htons(d_udp_port);
-
   if (inet_aton(d_iface_addr.c_str(), &(sin.sin_addr)) == 0) {
     LOG_ERROR("Wrong IP address");
-    close(sock);
-    exit(EXIT_FAILURE);
+    throw std::runtime_error("Wrong IP address");
   }
 
-  if (bind(sock, (struct sockaddr *) &sin, sizeof(struct sockaddr_in))
+  if ((d_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
+    perror("opening UDP socket");
+    throw std::runtime_error("Could not open UDP socket");
+  }
+  if (bind(d_sock, (struct sockaddr *) &sin, sizeof(struct sockaddr_in))
       == -1) {
     perror("UDP bind");
-    close(sock);
-    exit(EXIT_FAILURE);
-  }
-
-  /* All good until now. Allocate buffer memory and proceed */
-  buf = new uint8_t[d_mtu];
-
-  while (d_running) {
-    ret = recvfrom(sock, buf, d_mtu, 0, &client_addr, &client_addr_len);
-    if (ret > 0) {
-      bytes_num = (uint32_t) ret;
-      switch (d_type) {
-      case 0:
-        message_port_pub(pmt::mp("msg"), pmt::make_blob(buf, bytes_num));
-        break;
-      case 1:
-        if (bytes_num < sizeof(uint32_t)) {
-          continue;
-        }
-        memcpy(&uint_val, buf, sizeof(uint32_t));
-        message_port_pub(pmt::mp("msg"),
-                         pmt::from_uint64(ntohl(uint_val)));
-        break;
-      case 2:
-        if (bytes_num < sizeof(int32_t)) {
-          continue;
-        }
-        memcpy(&int_val, buf, sizeof(int32_t));
-        message_port_pub(pmt::mp("msg"),
-                         pmt::from_long(ntohl(int_val)));
-        break;
-      default:
-        LOG_ERROR("Unsupported message type");
-        close(sock);
-        delete[] buf;
-        exit(EXIT_FAILURE);
-      }
-    }
-    else {
-      perror("UDP recvfrom");
-      close(sock);
-      delete[] buf;
-      exit(EXIT_FAILURE);
-    }
+    close(d_sock);
+    throw std::runtime_error("Could not bind UDP socket");
   }
-  close(sock);
-  delete[] buf;
-  exit(EXIT_SUCCESS);
+
+  /* The read end becomes readable when the block should stop */
+  if (pipe2(d_wakeup, O_NONBLOCK | O_CLOEXEC) == -1) {
+    close(d_sock);
+    throw std::runtime_error("Could not create the wakeup pipe");
+  }
+
+  for (size_t i = 0; i < max_batch; i++) {
+    d_iov[i].iov_base = &d_pool[i * d_mtu];
+    d_iov[i].iov_len = d_mtu;
+    memset(&d_msgs[i], 0, sizeof(struct mmsghdr));
+    d_msgs[i].msg_hdr.msg_iov = &d_iov[i];
+    d_msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+bool
+udp_msg_source_impl::start()
+{
+  /* Drain any wakeup left by a previous stop() */
+  char c;
+  while (read(d_wakeup[0], &c, 1) > 0);
+
+  if (!d_stream) {
+    d_thread = std::thread(&udp_msg_source_impl::udp_msg_accepter, this);
+  }
+  return true;
+}
+
+bool
+udp_msg_source_impl::stop()
+{
+  const char c = 0;
+  if (write(d_wakeup[1], &c, 1) < 0) {
+    LOG_ERROR("Could not wake up the UDP receiver");
+  }
+  if (d_thread.joinable()) {
+    d_thread.join();
+  }
+  return true;
 }
 
 /*
- * Our virtual destructor.
+ * Waits for datagrams and receives as many as possible in the pool
+ * @param timeout_ms the poll timeout, -1 to wait indefinitely
+ * @return the number of datagrams received, 0 on timeout and -1 if the
+ * block is stopping or the socket failed
  */
+int
+udp_msg_source_impl::receive(int timeout_ms)
+{
+  struct pollfd fds[2];
+  fds[0].fd = d_sock;
+  fds[0].events = POLLIN;
+  fds[1].fd = d_wakeup[0];
+  fds[1].events = POLLIN;
+
+  int ret = poll(fds, 2, timeout_ms);
+  if (ret < 0) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    perror("UDP poll");
+    return -1;
+  }
+  if (fds[1].revents) {
+    return -1;
+  }
+  if (fds[0].revents & (POLLHUP | POLLNVAL)) {
+    LOG_ERROR("UDP socket closed");
+    return -1;
+  }
+  /*
+   * A pending error keeps the socket readable for poll() until it is
+   * retrieved, so read it here rather than spinning on it. Errors like an
+   * ICMP unreachable are transient and the socket can still be used
+   */
+  if (fds[0].revents & POLLERR) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(d_sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+      perror("UDP getsockopt");
+      return -1;
+    }
+    if (err == 0) {
+      LOG_ERROR("UDP socket failed");
+      return -1;
+    }
+    LOG_WARN("UDP socket error: %s", strerror(err));
+  }
+  if ((fds[0].revents & POLLIN) == 0) {
+    return 0;
+  }
+
+  ret = recvmmsg(d_sock, d_msgs.data(), max_batch, MSG_DONTWAIT, nullptr);
+  if (ret < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0;
+    }
+    perror("UDP recvmmsg");
+    return -1;
+  }
+  return ret;
+}
+
+void
+udp_msg_source_impl::publish(const uint8_t *buf, size_t len)
+{
+  uint32_t val;
+  switch (d_type) {
+  case 0:
+    message_port_pub(d_port, pmt::make_blob(buf, len));
+    break;
+  case 1:
+    if (len < sizeof(uint32_t)) {
+      return;
+    }
+    memcpy(&val, buf, sizeof(uint32_t));
+    message_port_pub(d_port, pmt::from_uint64(ntohl(val)));
+    break;
+  case 2:
+    if (len < sizeof(int32_t)) {
+      return;
+    }
+    memcpy(&val, buf, sizeof(int32_t));
+    message_port_pub(d_port, pmt::from_long(ntohl(val)));
+    break;
+  }
+}
+
+void
+udp_msg_source_impl::udp_msg_accepter()
+{
+  int n;
+  while ((n = receive(-1)) >= 0) {
+    for (int i = 0; i < n; i++) {
+      publish(&d_pool[i * d_mtu], d_msgs[i].msg_len);
+    }
+  }
+}
+
+int
+udp_msg_source_impl::general_work(int noutput_items,
+                                  gr_vector_int &ninput_items,
+                                  gr_vector_const_void_star &input_items,
+                                  gr_vector_void_star &output_items)
+{
+  uint8_t *out = (uint8_t *) output_items[0];
+
+  if (d_pending_idx == d_pending_cnt) {
+    int n = receive(stream_timeout_ms);
+    if (n < 0) {
+      return WORK_DONE;
+    }
+    d_pending_cnt = n;
+    d_pending_idx = 0;
+    d_pending_off = 0;
+  }
+
+  size_t produced = 0;
+  while (d_pending_idx < d_pending_cnt && produced < (size_t) noutput_items) {
+    const size_t len = d_msgs[d_pending_idx].msg_len;
+    const size_t cnt = std::min(len - d_pending_off,
+                                noutput_items - produced);
+    memcpy(out + produced, &d_pool[d_pending_idx * d_mtu + d_pending_off],
+           cnt);
+    produced += cnt;
+    d_pending_off += cnt;
+    if (d_pending_off == len) {
+      d_pending_idx++;
+      d_pending_off = 0;
+    }
+  }
+  return produced;
+}
+
 udp_msg_source_impl::~udp_msg_source_impl()
 {
-  d_running = false;
-  d_thread->join();
+  stop();
+  close(d_wakeup[0]);
+  close(d_wakeup[1]);
+  close(d_sock);
 }
 
 } /* namespace satnogs */
@@ -22,7 +22,9 @@
 #define INCLUDED_SATNOGS_UDP_MSG_SOURCE_IMPL_H
 
 #include <satnogs/udp_msg_source.h>
-#include <boost/thread.hpp>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
 
 namespace gr {
 namespace satnogs {
@@ -33,16 +35,46 @@ private:
   const uint16_t d_udp_port;
   const size_t d_mtu;
   const size_t d_type;
-  bool d_running;
-  boost::shared_ptr<boost::thread> d_thread;
+  const bool d_stream;
+  const pmt::pmt_t d_port;
+  int d_sock;
+  int d_wakeup[2];
+  std::thread d_thread;
+
+  /* Preallocated buffers of the datagrams received by each recvmmsg() */
+  std::vector<uint8_t> d_pool;
+  std::vector<struct iovec> d_iov;
+  std::vector<struct mmsghdr> d_msgs;
+
+  /* Datagrams received but not yet copied to the output stream */
+  size_t d_pending_cnt;
+  size_t d_pending_idx;
+  size_t d_pending_off;
+
+  int
+  receive(int timeout_ms);
+
+  void
+  publish(const uint8_t *buf, size_t len);
 
   void
   udp_msg_accepter();
 
 public:
   udp_msg_source_impl(const std::string &addr, uint16_t port,
-                      size_t mtu, size_t type);
+                      size_t mtu, size_t type, bool stream);
   ~udp_msg_source_impl();
+
+  bool
+  start();
+
+  bool
+  stop();
+
+  int
+  general_work(int noutput_items, gr_vector_int &ninput_items,
+               gr_vector_const_void_star &input_items,
+               gr_vector_void_star &output_items);
 };
 
 } // namespace satnogs
@@ -27,10 +27,14 @@
 #include <satnogs/log.h>
 #include <satnogs/utils.h>
 #include <satnogs/date.h>
+#include <algorithm>
 
 namespace gr {
 namespace satnogs {
 
+/* The number of rows that can be queued for the writer thread */
+static const size_t ring_rows = 128;
+
 waterfall_sink::sptr
 waterfall_sink::make(float samp_rate, float center_freq, float rps,
                      size_t fft_size, const std::string &filename, int mode)
@@ -58,20 +62,18 @@ waterfall_sink_impl::waterfall_sink_impl(float samp_rate, float center_freq,
   d_fft_cnt(0),
   d_fft_shift((size_t)(ceil(fft_size / 2.0))),
   d_samples_cnt(0),
-  d_fft(fft_size)
+  d_fft(fft_size),
+  /* The max hold is performed before the normalization */
+  d_hold_floor(1.0e-20f * fft_size * fft_size),
+  d_head(0),
+  d_tail(0),
+  d_running(false)
 {
   const int alignment_multiple = volk_get_alignment()
                                  / (fft_size * sizeof(gr_complex));
   set_alignment(std::max(1, alignment_multiple));
   set_output_multiple(fft_size);
 
-  d_shift_buffer = (gr_complex *) volk_malloc(fft_size * sizeof(gr_complex),
-                   volk_get_alignment());
-  if (!d_shift_buffer) {
-    LOG_ERROR("Could not allocate aligned memory");
-    throw std::runtime_error("Could not allocate aligned memory");
-  }
-
   d_hold_buffer = (float *) volk_malloc(fft_size * sizeof(gr_complex),
                                         volk_get_alignment());
   if (!d_hold_buffer) {
@@ -79,6 +81,9 @@ waterfall_sink_impl::waterfall_sink_impl(float samp_rate, float center_freq,
     throw std::runtime_error("Could not allocate aligned memory");
   }
   memset(d_hold_buffer, 0, fft_size * sizeof(gr_complex));
+  if (d_mode == WATERFALL_MODE_MAX_HOLD) {
+    std::fill(d_hold_buffer, d_hold_buffer + fft_size, d_hold_floor);
+  }
 
   d_tmp_buffer = (float *) volk_malloc(fft_size * sizeof(float),
                                        volk_get_alignment());
@@ -87,6 +92,14 @@ waterfall_sink_impl::waterfall_sink_impl(float samp_rate, float center_freq,
     throw std::runtime_error("Could not allocate aligned memory");
   }
 
+  d_rows = (float *) volk_malloc(ring_rows * fft_size * sizeof(float),
+                                 volk_get_alignment());
+  if (!d_rows) {
+    LOG_ERROR("Could not allocate aligned memory");
+    throw std::runtime_error("Could not allocate aligned memory");
+  }
+  d_row_ts.resize(ring_rows);
+
   d_fos.open(filename, std::ios::binary | std::ios::trunc);
   if (d_fos.fail()) {
     throw std::runtime_error("Could not create file for writing");
@@ -102,6 +115,24 @@ waterfall_sink_impl::start()
    * and the fist invocation of the work() method.
    */
   apply_header();
+  d_running = true;
+  d_writer = std::thread(&waterfall_sink_impl::writer, this);
+  return true;
+}
+
+bool
+waterfall_sink_impl::stop()
+{
+  if (d_writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(d_mtx);
+      d_running = false;
+    }
+    d_cond.notify_one();
+    /* The writer drains any pending rows before exiting */
+    d_writer.join();
+    d_fos.flush();
+  }
   return true;
 }
 
@@ -110,10 +141,11 @@ waterfall_sink_impl::start()
  */
 waterfall_sink_impl::~waterfall_sink_impl()
 {
+  stop();
   d_fos.close();
-  volk_free(d_shift_buffer);
   volk_free(d_hold_buffer);
   volk_free(d_tmp_buffer);
+  volk_free(d_rows);
 }
 
 int
@@ -142,6 +174,61 @@ waterfall_sink_impl::work(int noutput_items,
   return n_fft * d_fft_size;
 }
 
+/*
+ * Returns the next free row of the ring. The work() blocks only if the
+ * writer thread falls behind by the whole ring
+ */
+float *
+waterfall_sink_impl::acquire_row()
+{
+  const size_t head = d_head.load(std::memory_order_relaxed);
+  if (head - d_tail.load(std::memory_order_acquire) == ring_rows) {
+    std::unique_lock<std::mutex> lock(d_mtx);
+    d_space_cond.wait(lock, [&] {
+      return head - d_tail.load() < ring_rows;
+    });
+  }
+  return d_rows + (head % ring_rows) * d_fft_size;
+}
+
+/*
+ * Queues the row returned by acquire_row() to the writer. The timestamp is
+ * derived from the number of samples up to the end of the current FFT, so
+ * it does not depend on the scheduling of the work()
+ */
+void
+waterfall_sink_impl::commit_row()
+{
+  const size_t head = d_head.load(std::memory_order_relaxed);
+  d_row_ts[head % ring_rows] = (d_samples_cnt + d_fft_size) * 1e6
+                               / d_samp_rate;
+  d_head.store(head + 1);
+
+  /* Wake up the writer if the ring was empty */
+  if (head + 1 - d_tail.load() == 1) {
+    {
+      std::lock_guard<std::mutex> lock(d_mtx);
+    }
+    d_cond.notify_one();
+  }
+}
+
+/*
+ * Computes the energy in dB of a spectrum in FFT order, storing it with the
+ * DC at the center. The FFT shift is performed by the indexing of the
+ * kernel, without any intermediate copy
+ */
+void
+waterfall_sink_impl::shift_psd(float *row, const gr_complex *spectrum,
+                               float norm)
+{
+  const size_t n = d_fft_size - d_fft_shift;
+  volk_32fc_s32f_x2_power_spectral_density_32f(row, spectrum + d_fft_shift,
+      norm, 1.0, n);
+  volk_32fc_s32f_x2_power_spectral_density_32f(row + n, spectrum, norm, 1.0,
+      d_fft_shift);
+}
+
 void
 waterfall_sink_impl::compute_decimation(const gr_complex *in, size_t n_fft)
 {
@@ -153,20 +240,10 @@ waterfall_sink_impl::compute_decimation(const gr_complex *in, size_t n_fft)
       fft_in = d_fft.get_inbuf();
       memcpy(fft_in, in + i * d_fft_size, d_fft_size * sizeof(gr_complex));
       d_fft.execute();
-      /* Perform FFT shift */
-      memcpy(d_shift_buffer, &d_fft.get_outbuf()[d_fft_shift],
-             sizeof(gr_complex) * (d_fft_size - d_fft_shift));
-      memcpy(&d_shift_buffer[d_fft_size - d_fft_shift],
-             &d_fft.get_outbuf()[0], sizeof(gr_complex) * d_fft_shift);
 
       /* Compute the energy in dB */
-      volk_32fc_s32f_x2_power_spectral_density_32f(d_hold_buffer,
-          d_shift_buffer,
-          (float) d_fft_size, 1.0,
-          d_fft_size);
-      /* Write the result to the file */
-      write_timestamp();
-      d_fos.write((char *) d_hold_buffer, d_fft_size * sizeof(float));
+      shift_psd(acquire_row(), d_fft.get_outbuf(), (float) d_fft_size);
+      commit_row();
       d_fft_cnt = 0;
     }
     d_samples_cnt += d_fft_size;
@@ -177,41 +254,35 @@ void
 waterfall_sink_impl::compute_max_hold(const gr_complex *in, size_t n_fft)
 {
   size_t i;
-  size_t j;
   gr_complex *fft_in;
   for (i = 0; i < n_fft; i++) {
     fft_in = d_fft.get_inbuf();
     memcpy(fft_in, in + i * d_fft_size, d_fft_size * sizeof(gr_complex));
     d_fft.execute();
-    /* Perform FFT shift */
-    memcpy(d_shift_buffer, &d_fft.get_outbuf()[d_fft_shift],
-           sizeof(gr_complex) * (d_fft_size - d_fft_shift));
-    memcpy(&d_shift_buffer[d_fft_size - d_fft_shift], &d_fft.get_outbuf()[0],
-           sizeof(gr_complex) * d_fft_shift);
-
-    /* Normalization factor */
-    volk_32fc_s32fc_multiply_32fc(d_shift_buffer, d_shift_buffer,
-                                  1.0 / d_fft_size, d_fft_size);
-
-    /* Compute the mag^2 */
-    volk_32fc_magnitude_squared_32f(d_tmp_buffer, d_shift_buffer, d_fft_size);
-    /* Max hold */
+
+    /*
+     * Compute the mag^2 and the max hold in FFT order. The normalization
+     * and the FFT shift are applied only once per row
+     */
+    volk_32fc_magnitude_squared_32f(d_tmp_buffer, d_fft.get_outbuf(),
+                                    d_fft_size);
     volk_32f_x2_max_32f(d_hold_buffer, d_hold_buffer, d_tmp_buffer,
                         d_fft_size);
     d_fft_cnt++;
     if (d_fft_cnt == d_refresh) {
-      /* Compute the energy in dB */
-      for (j = 0; j < d_fft_size; j++) {
-        d_hold_buffer[j] = 10.0 * log10f(d_hold_buffer[j] + 1.0e-20);
-      }
-
-      /* Write the result to the file */
-      write_timestamp();
-      d_fos.write((char *) d_hold_buffer, d_fft_size * sizeof(float));
+      /* Compute the energy in dB, as 10 * log10(2) * log2(x) */
+      float *row = acquire_row();
+      const size_t n = d_fft_size - d_fft_shift;
+      volk_32f_s32f_multiply_32f(d_hold_buffer, d_hold_buffer,
+                                 1.0 / (d_fft_size * d_fft_size), d_fft_size);
+      volk_32f_log2_32f(row, d_hold_buffer + d_fft_shift, n);
+      volk_32f_log2_32f(row + n, d_hold_buffer, d_fft_shift);
+      volk_32f_s32f_multiply_32f(row, row, 10.0 * log10(2.0), d_fft_size);
+      commit_row();
 
       /* Reset */
       d_fft_cnt = 0;
-      memset(d_hold_buffer, 0, d_fft_size * sizeof(float));
+      std::fill(d_hold_buffer, d_hold_buffer + d_fft_size, d_hold_floor);
     }
     d_samples_cnt += d_fft_size;
   }
@@ -223,7 +294,6 @@ waterfall_sink_impl::apply_header()
   header_t h;
   memset(h.start_time, 0, 32);
   std::chrono::system_clock::time_point tp = std::chrono::system_clock::now();
-  d_start = tp;
   std::string s = date::format("%FT%TZ",
                                date::floor<std::chrono::microseconds> (tp));
   std::strncpy(h.start_time, s.c_str(), 32);
@@ -249,13 +319,39 @@ waterfall_sink_impl::apply_header()
   d_fos.write((char *)&h.endianness, sizeof(uint32_t));
 }
 
+/*
+ * Writes the queued rows to the file, until the block is stopped and
+ * the ring is empty
+ */
 void
-waterfall_sink_impl::write_timestamp()
+waterfall_sink_impl::writer()
 {
-  std::chrono::system_clock::time_point tp = std::chrono::system_clock::now();
-  int64_t x = std::chrono::duration_cast<std::chrono::microseconds> (
-                tp - d_start).count();
-  d_fos.write((char *)&x, sizeof(int64_t));
+  size_t tail = d_tail.load(std::memory_order_relaxed);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(d_mtx);
+      d_cond.wait(lock, [&] {
+        return d_head.load() != tail || !d_running;
+      });
+    }
+
+    const size_t head = d_head.load(std::memory_order_acquire);
+    if (head == tail) {
+      return;
+    }
+    while (tail != head) {
+      const size_t slot = tail % ring_rows;
+      d_fos.write((char *) &d_row_ts[slot], sizeof(int64_t));
+      d_fos.write((char *)(d_rows + slot * d_fft_size),
+                  d_fft_size * sizeof(float));
+      tail++;
+      d_tail.store(tail);
+    }
+    {
+      std::lock_guard<std::mutex> lock(d_mtx);
+    }
+    d_space_cond.notify_one();
+  }
 }
 
 void
@@ -267,28 +363,19 @@ waterfall_sink_impl::compute_mean(const gr_complex *in, size_t n_fft)
     fft_in = d_fft.get_inbuf();
     memcpy(fft_in, in + i * d_fft_size, d_fft_size * sizeof(gr_complex));
     d_fft.execute();
-    /* Perform FFT shift */
-    memcpy(d_shift_buffer, &d_fft.get_outbuf()[d_fft_shift],
-           sizeof(gr_complex) * (d_fft_size - d_fft_shift));
-    memcpy(&d_shift_buffer[d_fft_size - d_fft_shift], &d_fft.get_outbuf()[0],
-           sizeof(gr_complex) * d_fft_shift);
-
-    /* Accumulate the complex numbers  */
-    volk_32f_x2_add_32f(d_hold_buffer, d_hold_buffer, (float *) d_shift_buffer,
-                        2 * d_fft_size);
+
+    /* Accumulate the complex numbers in FFT order */
+    volk_32f_x2_add_32f(d_hold_buffer, d_hold_buffer,
+                        (float *) d_fft.get_outbuf(), 2 * d_fft_size);
     d_fft_cnt++;
     if (d_fft_cnt == d_refresh) {
       /*
        * Compute the energy in dB performing the proper normalization
        * before any dB calculation, emulating the mean
        */
-      volk_32fc_s32f_x2_power_spectral_density_32f(
-        d_hold_buffer, (gr_complex *) d_hold_buffer,
-        (float) d_fft_cnt * d_fft_size, 1.0, d_fft_size);
-
-      /* Write the result to the file */
-      write_timestamp();
-      d_fos.write((char *) d_hold_buffer, d_fft_size * sizeof(float));
+      shift_psd(acquire_row(), (gr_complex *) d_hold_buffer,
+                (float) d_fft_cnt * d_fft_size);
+      commit_row();
 
       /* Reset */
       d_fft_cnt = 0;
@@ -300,4 +387,3 @@ waterfall_sink_impl::compute_mean(const gr_complex *in, size_t n_fft)
 
 } /* namespace satnogs */
 } /* namespace gr */
-
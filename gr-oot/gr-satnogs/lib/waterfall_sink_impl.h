@@ -26,7 +26,12 @@
 #include <gnuradio/fft/fft.h>
 #include <iostream>
 #include <fstream>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace gr {
 namespace satnogs {
@@ -66,17 +71,41 @@ private:
   size_t d_fft_shift;
   size_t d_samples_cnt;
   fft::fft_complex d_fft;
-  gr_complex *d_shift_buffer;
+  const float d_hold_floor;
   float *d_hold_buffer;
   float *d_tmp_buffer;
   std::ofstream d_fos;
-  std::chrono::system_clock::time_point d_start;
+
+  /*
+   * Single producer, single consumer ring of waterfall rows. The work() is
+   * the producer and the writer thread the consumer, so the file I/O never
+   * blocks the signal processing
+   */
+  float *d_rows;
+  std::vector<int64_t> d_row_ts;
+  std::atomic<size_t> d_head;
+  std::atomic<size_t> d_tail;
+
+  std::thread d_writer;
+  std::atomic<bool> d_running;
+  std::mutex d_mtx;
+  std::condition_variable d_cond;
+  std::condition_variable d_space_cond;
 
   void
   apply_header();
 
+  float *
+  acquire_row();
+
+  void
+  commit_row();
+
+  void
+  shift_psd(float *row, const gr_complex *spectrum, float norm);
+
   void
-  write_timestamp();
+  writer();
 
 public:
   waterfall_sink_impl(float samp_rate, float center_freq, float rps,
@@ -86,6 +115,9 @@ public:
   bool
   start();
 
+  bool
+  stop();
+
   int
   work(int noutput_items, gr_vector_const_void_star &input_items,
        gr_vector_void_star &output_items);
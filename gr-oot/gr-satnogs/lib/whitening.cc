@@ -90,7 +90,7 @@ whitening::whitening(uint32_t mask, uint32_t seed, uint32_t order, bool msb,
                      bool self_sync) :
   d_msb(msb),
   d_self_sync(self_sync),
-  d_lfsr(mask, seed, order),
+  d_lfsr(mask, seed, order, msb),
   d_id(0)
 {
   d_id = base_unique_id++;
@@ -125,65 +125,11 @@ whitening::reset()
 void
 whitening::scramble(uint8_t *out, const uint8_t *in, size_t len)
 {
-  if (d_msb) {
-    if (d_self_sync) {
-      for (size_t i = 0; i < len; i++) {
-        uint8_t b;
-        b = d_lfsr.next_bit_scramble(in[i] >> 7) << 7;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 6) & 0x1) << 6;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 5) & 0x1) << 5;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 4) & 0x1) << 4;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 3) & 0x1) << 3;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 2) & 0x1) << 2;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 1) & 0x1) << 1;
-        b |= d_lfsr.next_bit_scramble(in[i] & 0x1);
-        out[i] = b;
-      }
-    }
-    else {
-      for (size_t i = 0; i < len; i++) {
-        uint8_t b;
-        b = d_lfsr.next_bit() << 7;
-        b |= d_lfsr.next_bit() << 6;
-        b |= d_lfsr.next_bit() << 5;
-        b |= d_lfsr.next_bit() << 4;
-        b |= d_lfsr.next_bit() << 3;
-        b |= d_lfsr.next_bit() << 2;
-        b |= d_lfsr.next_bit() << 1;
-        b |= d_lfsr.next_bit();
-        out[i] = in[i] ^ b;
-      }
-    }
+  if (d_self_sync) {
+    d_lfsr.scramble(out, in, len);
   }
   else {
-    if (d_self_sync) {
-      for (size_t i = 0; i < len; i++) {
-        uint8_t b;
-        b = d_lfsr.next_bit_scramble(in[i] & 0x1);
-        b |= d_lfsr.next_bit_scramble((in[i] >> 1) & 0x1) << 1;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 2) & 0x1) << 2;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 3) & 0x1) << 3;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 4) & 0x1) << 4;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 5) & 0x1) << 5;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 6) & 0x1) << 6;
-        b |= d_lfsr.next_bit_scramble((in[i] >> 7) & 0x1) << 7;
-        out[i] = b;
-      }
-    }
-    else {
-      for (size_t i = 0; i < len; i++) {
-        uint8_t b;
-        b = d_lfsr.next_bit();
-        b |= d_lfsr.next_bit() << 1;
-        b |= d_lfsr.next_bit() << 2;
-        b |= d_lfsr.next_bit() << 3;
-        b |= d_lfsr.next_bit() << 4;
-        b |= d_lfsr.next_bit() << 5;
-        b |= d_lfsr.next_bit() << 6;
-        b |= d_lfsr.next_bit() << 7;
-        out[i] = in[i] ^ b;
-      }
-    }
+    d_lfsr.additive(out, in, len);
   }
 }
 
@@ -196,7 +142,12 @@ whitening::scramble(uint8_t *out, const uint8_t *in, size_t len)
 void
 whitening::descramble(uint8_t *out, const uint8_t *in, size_t len)
 {
-  scramble(out, in, len);
+  if (d_self_sync) {
+    d_lfsr.descramble(out, in, len);
+  }
+  else {
+    d_lfsr.additive(out, in, len);
+  }
 }
 
 /**
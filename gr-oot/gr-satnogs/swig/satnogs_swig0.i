@@ -12,6 +12,7 @@
 %template(whitening_sptr) boost::shared_ptr<gr::satnogs::whitening>;
 %nodefaultctor gr::satnogs::decoder;
 %template(decoder_sptr) boost::shared_ptr<gr::satnogs::decoder>;
+%template(decoder_sptr_vector) std::vector<boost::shared_ptr<gr::satnogs::decoder> >;
 
 %nodefaultctor gr::satnogs::encoder;
 %template(encoder_sptr) boost::shared_ptr<gr::satnogs::encoder>;
@@ -33,10 +34,13 @@
 #include "satnogs/cw_decoder.h"
 #include "satnogs/udp_msg_source.h"
 #include "satnogs/tcp_rigctl_msg_source.h"
+#include "satnogs/sgp4_doppler_msg_source.h"
 #include "satnogs/decoder.h"
 #include "satnogs/doppler_correction_cc.h"
+#include "satnogs/doppler_resampler_cc.h"
 #include "satnogs/encoder.h"
 #include "satnogs/frame_decoder.h"
+#include "satnogs/multi_frame_decoder.h"
 #include "satnogs/frame_encoder.h"
 #include "satnogs/whitening.h"
 #include "satnogs/udp_msg_sink.h"
@@ -47,6 +51,7 @@
 #include "satnogs/noaa_apt_sink.h"
 #include "satnogs/sstv_pd120_sink.h"
 #include "satnogs/frame_file_sink.h"
+#include "satnogs/frame_store.h"
 #include "satnogs/metadata.h"
 #include "satnogs/metadata_sink.h"
 #include "satnogs/iq_sink.h"
@@ -100,15 +105,24 @@ GR_SWIG_BLOCK_MAGIC2(satnogs, udp_msg_source);
 %include "satnogs/tcp_rigctl_msg_source.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, tcp_rigctl_msg_source);
 
+%include "satnogs/sgp4_doppler_msg_source.h"
+GR_SWIG_BLOCK_MAGIC2(satnogs, sgp4_doppler_msg_source);
+
 %include "satnogs/frame_decoder.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, frame_decoder);
 
+%include "satnogs/multi_frame_decoder.h"
+GR_SWIG_BLOCK_MAGIC2(satnogs, multi_frame_decoder);
+
 %include "satnogs/frame_encoder.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, frame_encoder);
 
 %include "satnogs/doppler_correction_cc.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, doppler_correction_cc);
 
+%include "satnogs/doppler_resampler_cc.h"
+GR_SWIG_BLOCK_MAGIC2(satnogs, doppler_resampler_cc);
+
 %include "satnogs/udp_msg_sink.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, udp_msg_sink);
 
@@ -133,6 +147,8 @@ GR_SWIG_BLOCK_MAGIC2(satnogs, sstv_pd120_sink);
 %include "satnogs/frame_file_sink.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, frame_file_sink);
 
+%include "satnogs/frame_store.h"
+
 %include "satnogs/metadata_sink.h"
 GR_SWIG_BLOCK_MAGIC2(satnogs, metadata_sink);
 